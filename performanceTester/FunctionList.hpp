@@ -7,8 +7,9 @@
 #include <climits>
 
 #include "../src/InputOutput/InputOutput.hpp"
+#include "../src/Models/Tools/GridOdometer.hpp"
 
-#define SpaceFunctionType std::function<double(const std::vector<int>&)>
+#define SpaceFunctionType std::function<double(const Coordinates&)>
 
 
 /*
@@ -16,12 +17,12 @@
 */
 namespace testfunctions {
 
-int dimSize = 0;
-int dims = 0;
-std::unordered_map<std::string, std::pair<double,double>> minMaxCache;
-bool lock = false;
+inline int dimSize = 0;
+inline int dims = 0;
+inline std::unordered_map<std::string, std::pair<double,double>> minMaxCache;
+inline bool lock = false;
 
-std::pair<double, double> getMinMax(SpaceFunctionType function, std::string functionId){
+inline std::pair<double, double> getMinMax(SpaceFunctionType function, std::string functionId){
     if (minMaxCache.find(functionId) != minMaxCache.end()){
         return minMaxCache[functionId];
     }
@@ -31,11 +32,11 @@ std::pair<double, double> getMinMax(SpaceFunctionType function, std::string func
     }
     lock = true;
 
-    int maxIdx = pow(dimSize, dims);
+    long long maxIdx = StateSpace::cell_count(dims, dimSize);
     std::pair<double, double> minMax = {std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest()};
-    for (int i = 0; i < maxIdx; i++){
-        std::vector<int> coords = InputOutput::index_to_coords(i, dims, dimSize);
-        double output = function(coords);
+    GridOdometer cell(dims, dimSize, 0);
+    for (long long i = 0; i < maxIdx; i++, cell.next()){
+        double output = function(cell.coords());
         minMax.first = std::min(minMax.first, output);
         minMax.second = std::max(minMax.second, output);
     }
@@ -46,14 +47,14 @@ std::pair<double, double> getMinMax(SpaceFunctionType function, std::string func
 }
 
 // Translate discrete query into continuous hypercube
-double translateIntoHypercube(int x, double lowerBound, double upperBound) {
+inline double translateIntoHypercube(int x, double lowerBound, double upperBound) {
     if (dimSize <= 1) return lowerBound;
     double scale = (upperBound - lowerBound) / (dimSize - 1);
     return lowerBound + x * scale;
 }
 
 // Generic normalization
-double normalize(double value, std::string functionId) {
+inline double normalize(double value, std::string functionId) {
     if (minMaxCache.find(functionId) != minMaxCache.end()){
         auto minMax = minMaxCache[functionId];
         if (minMax.second - minMax.first < 1) 
@@ -67,7 +68,7 @@ double normalize(double value, std::string functionId) {
 // ------------------ Test Functions ------------------
 
 // Ackley Function
-double ackleyFunction(const std::vector<int>& query) {
+inline double ackleyFunction(const Coordinates& query) {
     getMinMax(ackleyFunction, "ackleyFunction");
     const double a = 20.0, b = 0.2, c = 2 * M_PI;
     size_t d = query.size();
@@ -84,7 +85,7 @@ double ackleyFunction(const std::vector<int>& query) {
 }
 
 // Sum of Different Powers
-double sumpow(const std::vector<int>& query) {
+inline double sumpow(const Coordinates& query) {
     getMinMax(sumpow, "sumpow");
     size_t d = query.size();
     if (d == 0) return 0.0;
@@ -98,7 +99,7 @@ double sumpow(const std::vector<int>& query) {
 }
 
 // Griewank
-double griewank(const std::vector<int>& query) {
+inline double griewank(const Coordinates& query) {
     getMinMax(griewank,"griewank");
     size_t d = query.size();
     if (d == 0) return 0.0;
@@ -113,7 +114,7 @@ double griewank(const std::vector<int>& query) {
 }
 
 // Rastrigin
-double rastrigin(const std::vector<int>& query) {
+inline double rastrigin(const Coordinates& query) {
     getMinMax(rastrigin,"rastrigin");
     size_t d = query.size();
     if (d == 0) return 0.0;
@@ -127,7 +128,7 @@ double rastrigin(const std::vector<int>& query) {
 }
 
 // Michalewicz
-double michalewicz(const std::vector<int>& query) {
+inline double michalewicz(const Coordinates& query) {
     getMinMax(michalewicz,"michalewicz");
     size_t d = query.size();
     if (d == 0) return 0.0;
@@ -140,7 +141,7 @@ double michalewicz(const std::vector<int>& query) {
 }
 
 // Power Sum
-double powerSum(const std::vector<int>& query) {
+inline double powerSum(const Coordinates& query) {
     getMinMax(powerSum,"powerSum");
     size_t d = query.size();
     if (d == 0) return 0.0;
@@ -160,7 +161,7 @@ double powerSum(const std::vector<int>& query) {
 }
 
 // Zakharov
-double zakharov(const std::vector<int>& query) {
+inline double zakharov(const Coordinates& query) {
     getMinMax(zakharov,"zakharov");
     size_t d = query.size();
     if (d == 0) return 0.0;
@@ -175,7 +176,7 @@ double zakharov(const std::vector<int>& query) {
 }
 
 // Dixon-Price
-double dixonPrice(const std::vector<int>& query) {
+inline double dixonPrice(const Coordinates& query) {
     getMinMax(dixonPrice,"dixonPrice");
     size_t d = query.size();
     if (d == 0) return 0.0;
@@ -189,7 +190,7 @@ double dixonPrice(const std::vector<int>& query) {
 }
 
 // Rosenbrock
-double rosenbrock(const std::vector<int>& query) {
+inline double rosenbrock(const Coordinates& query) {
     getMinMax(rosenbrock,"rosenbrock");
     size_t d = query.size();
     if (d < 2) return 0.0;
@@ -203,7 +204,7 @@ double rosenbrock(const std::vector<int>& query) {
 }
 
 // Rotated Hyper Ellipsoid
-double hyperEllipsoid(const std::vector<int>& query) {
+inline double hyperEllipsoid(const Coordinates& query) {
     getMinMax(hyperEllipsoid,"hyperEllipsoid");
     size_t d = query.size();
     if (d == 0) return 0.0;
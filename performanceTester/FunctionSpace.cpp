@@ -16,28 +16,17 @@ int FunctionSpace::get_dimension_size() const {
     return this->dimensionSize;
 }
 
-double FunctionSpace::computeMeanHelper(std::vector<int>& query, int index, double& sum, int& count) const {
-    if (index == query.size()) {
-        sum += this->get(query);
-        count++;
-        return sum;
-    }
-    for (int i = 0; i < dimensionSize; i++) {
-        query[index] = i;
-        computeMeanHelper(query, index + 1, sum, count);
-    }
-    return sum;
-}
-
 double FunctionSpace::getRealMean() const {
-    std::vector<int> query(dimensions, 0);
+    // streamed cell by cell, the space may be far too large to hold
+    const long long cells = cell_count(dimensions, dimensionSize);
     double sum = 0.0;
-    int count = 0;
-    computeMeanHelper(query, 0, sum, count);
-    return count > 0 ? sum / count : 0.0;
+    GridOdometer cell(dimensions, dimensionSize, 0);
+    for (long long i = 0; i < cells; i++, cell.next())
+        sum += this->get(cell.coords());
+    return cells > 0 ? sum / cells : 0.0;
 }
 
-double FunctionSpace::get(const std::vector<int>& coords) const {
+double FunctionSpace::get(const Coordinates& coords) const {
     //for (auto i : coords)
         //std::cout << i << " ";
     //std::cout << std::endl;
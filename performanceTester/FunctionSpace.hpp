@@ -8,11 +8,11 @@
 #include <algorithm>
 #include <limits>
 
-#define SpaceFunctionType std::function<double(const std::vector<int>&)>
+#define SpaceFunctionType std::function<double(const Coordinates&)>
 
 typedef struct Results {
-    int correct = 0;
-    int totalSeen = 0;
+    long long correct = 0;
+    long long totalSeen = 0;
 
     double sumAbsoluteError = 0;
     double sumSquaredError = 0;
@@ -71,7 +71,6 @@ private:
 
     std::vector<Results> allResults;
 
-    double computeMeanHelper(std::vector<int>& query, int index, double& sum, int& count) const;
 public:
     FunctionSpace(int dimensions, int dimensionSize, SpaceFunctionType spaceFunction);
 
@@ -79,7 +78,7 @@ public:
 
     int get_dimension_size() const override;
     
-    double get(const std::vector<int>& coords) const override;
+    double get(const Coordinates& coords) const override;
 
     void resetResults();
     void updateResults(double predicted, double actual);
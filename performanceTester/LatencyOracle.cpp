@@ -0,0 +1,26 @@
+#include "LatencyOracle.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+LatencyOracle::LatencyOracle(Function function, std::chrono::microseconds latency, int concurrency)
+    : function(std::move(function)), latency(latency), workerFree(std::max(1, concurrency), Clock::now()) {}
+
+void LatencyOracle::submit(long long id, const Coordinates &query) {
+    // the query starts on whichever worker frees up first
+    auto worker = std::min_element(workerFree.begin(), workerFree.end());
+    auto start = std::max(*worker, Clock::now());
+    *worker = start + latency;
+    running.push({*worker, id, function(query)});
+}
+
+std::pair<long long, double> LatencyOracle::wait_next() {
+    if (running.empty())
+        throw std::logic_error("No query waiting for a result");
+
+    Job next = running.top();
+    running.pop();
+    std::this_thread::sleep_until(next.due);
+    return {next.id, next.result};
+}
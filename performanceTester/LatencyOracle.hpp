@@ -0,0 +1,42 @@
+#ifndef LATENCY_ORACLE_H
+#define LATENCY_ORACLE_H
+
+#include <chrono>
+#include <functional>
+#include <queue>
+#include <vector>
+
+#include "../src/InputOutput/AsyncOracle.hpp"
+
+/**
+ * Local stand-in for a slow simulator: answers every query after a fixed latency, working on
+ * at most `concurrency` queries at a time. Time is wall-clock, so whatever the caller does
+ * between submit and wait_next overlaps with the simulated work.
+ */
+class LatencyOracle : public AsyncOracle {
+public:
+    using Function = std::function<double(const Coordinates&)>;
+
+    LatencyOracle(Function function, std::chrono::microseconds latency, int concurrency = 1);
+
+    void submit(long long id, const Coordinates &query) override;
+    std::pair<long long, double> wait_next() override;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Job {
+        Clock::time_point due;
+        long long id;
+        double result;
+
+        bool operator>(const Job& other) const { return due > other.due; }
+    };
+
+    Function function;
+    std::chrono::microseconds latency;
+    std::vector<Clock::time_point> workerFree; // when each simulated worker is next idle
+    std::priority_queue<Job, std::vector<Job>, std::greater<Job>> running;
+};
+
+#endif // LATENCY_ORACLE_H
@@ -4,6 +4,8 @@
 #include <filesystem>
 #include <fstream>
 #include <random>
+#include <thread>
+#include <algorithm>
 
 using std::cout, std::endl;
 
@@ -11,6 +13,8 @@ FunctionSpace* StateSpaceIO::stateSpace = nullptr;
 std::string StateSpaceIO::name = "";
 int StateSpaceIO::queries = 0;
 bool StateSpaceIO::stochastic = false;
+std::chrono::microseconds StateSpaceIO::callLatency{0};
+std::chrono::microseconds StateSpaceIO::queryLatency{0};
 
 void StateSpaceIO::set_IO(FunctionSpace& stateSpace, const std::string& name, int queries, bool stochastic){
     StateSpaceIO::stateSpace = &stateSpace;
@@ -27,23 +31,43 @@ void StateSpaceIO::set_state_space(FunctionSpace& stateSpace, const std::string&
     StateSpaceIO::queries = queries;
 }
 
+void StateSpaceIO::set_latency(std::chrono::microseconds callLatency, std::chrono::microseconds queryLatency){
+    StateSpaceIO::callLatency = callLatency;
+    StateSpaceIO::queryLatency = queryLatency;
+}
+
 static std::default_random_engine gen(std::random_device{}());
 static std::uniform_real_distribution<double> dist(0.0, 1.0);
-double StateSpaceIO::send_query_recieve_result(const std::vector<int> &query) {
+double StateSpaceIO::evaluate(const Coordinates &query) {
     double result = stateSpace->get(query);
     if (stochastic) return dist(gen) <= result;
     return result;
 }
 
+double StateSpaceIO::send_query_recieve_result(const Coordinates &query) {
+    if (callLatency.count() || queryLatency.count())
+        std::this_thread::sleep_for(callLatency + queryLatency);
+    return evaluate(query);
+}
+
+std::vector<double> StateSpaceIO::send_queries_recieve_results(const std::vector<Coordinates> &queries) {
+    if (callLatency.count() || queryLatency.count())
+        std::this_thread::sleep_for(callLatency + queryLatency * (long long)queries.size());
+
+    std::vector<double> results;
+    results.reserve(queries.size());
+    for (const auto& query : queries)
+        results.push_back(evaluate(query));
+    return results;
+}
+
 void StateSpaceIO::output_state(Model &model, bool outputStateSpace) {
     stateSpace->resetResults();
 
     const int dimensions = model.get_dimensions();
     const int dimensionSize = model.get_dimensionSize();
 
-    long long maxIdx = 1;
-    for (int i = 0; i < dimensions; ++i)
-        maxIdx *= dimensionSize;
+    long long maxIdx = model.cell_count();
 
     // Construct directory path
     std::string dir = "PerformanceData" +
@@ -71,11 +95,16 @@ void StateSpaceIO::output_state(Model &model, bool outputStateSpace) {
     if (!queryOut.is_open())
         throw std::runtime_error("Failed to open " + queriesFile);
 
-    // Core write loop
-    for (long long i = 0; i < maxIdx; ++i) {
-        const auto coords = index_to_coords(i, dimensions, dimensionSize);
-        const double funcVal = this->stateSpace->get(coords);
-        const double queryVal = model.get_value_at(coords);
+    // Core write loop, the model is evaluated a block of cells at a time
+    const long long blockSize = output_block();
+    std::vector<double> block(std::min(maxIdx, blockSize));
+    GridOdometer cell(dimensions, dimensionSize, 0);
+    for (long long i = 0; i < maxIdx; ++i, cell.next()) {
+        if (i % blockSize == 0)
+            evaluate_block(model, i, std::min(maxIdx, i + blockSize), block.data());
+
+        const double funcVal = this->stateSpace->get(cell.coords());
+        const double queryVal = block[i % blockSize];
 
         stateSpace->updateResults(queryVal, funcVal);
 
@@ -1,6 +1,8 @@
 #ifndef SS_INPUT_OUTPUT
 #define SS_INPUT_OUTPUT
 
+#include <chrono>
+
 #include "../src/InputOutput/InputOutput.hpp"
 #include "FunctionSpace.hpp"
 
@@ -13,12 +15,20 @@ private:
     static std::string name;
     static int queries;
     static bool stochastic;
+    static std::chrono::microseconds callLatency, queryLatency;
     StateSpaceIO() = default;
 
+    double evaluate(const Coordinates &query);
+
 public:
     static void set_state_space(FunctionSpace& stateSpace, const std::string& name, int quereies);
     static void set_IO(FunctionSpace& stateSpace, const std::string& name, int quereies, bool stochastic);
-    double send_query_recieve_result(const std::vector<int> &query) override;
+    /**
+     * @brief Simulate a remote oracle: every round trip costs callLatency plus queryLatency per query
+     */
+    static void set_latency(std::chrono::microseconds callLatency, std::chrono::microseconds queryLatency);
+    double send_query_recieve_result(const Coordinates &query) override;
+    std::vector<double> send_queries_recieve_results(const std::vector<Coordinates> &queries) override;
     void output_state(Model& model, bool outputStateSpace);
     void output_state(Model& model) override;
 };
@@ -0,0 +1,88 @@
+#include "Benchmarks.hpp"
+#include "../../src/Models/StochasticQueryModel.hpp"
+#include "../../src/Models/TestModel.hpp"
+#include "../../src/Models/GEKModel.hpp"
+#include "../../src/Models/RBF.hpp"
+#include "../FunctionList.hpp"
+#include "../FunctionSpace.hpp"
+#include "../StateSpaceIO.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+
+// Every operator new in sep25_benchmarks goes through here so the count covers the models,
+// the standard containers and the IO. Eigen allocates its matrices with malloc and is not counted.
+static std::atomic<long long> allocations{0};
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+struct AllocationCounts {
+    double perQuery;
+    double perCell;
+};
+
+template <typename ModelType>
+static AllocationCounts count_allocations(int dimensions, int dimensionSize, int queries) {
+    ModelType model(dimensions, dimensionSize, queries);
+    InputOutput* io = InputOutput::get_instance();
+
+    long long before = allocations.load();
+    io->run_queries(model, queries);
+    long long queried = allocations.load();
+
+    std::vector<double> grid(model.cell_count());
+    long long reconstructing = allocations.load();
+    model.evaluate_grid(grid.data());
+    long long reconstructed = allocations.load();
+
+    return {double(queried - before) / queries, double(reconstructed - reconstructing) / grid.size()};
+}
+
+/**
+ * Heap allocations per query during the query phase, and per cell while reconstructing the
+ * state space, for every model on the performance tester's Griewank workload.
+ *
+ *   sep25_benchmarks allocations [dimensions] [dimensionSize] [queries]
+ */
+int allocation_benchmark(int argc, char* argv[]) {
+    int dimensions = argc > 0 ? std::atoi(argv[0]) : 3;
+    int dimensionSize = argc > 1 ? std::atoi(argv[1]) : 30;
+    int queries = argc > 2 ? std::atoi(argv[2]) : 1000;
+
+    testfunctions::minMaxCache.clear();
+    testfunctions::dimSize = dimensionSize;
+    testfunctions::dims = dimensions;
+
+    FunctionSpace fspace(dimensions, dimensionSize, testfunctions::griewank);
+    StateSpaceIO::set_IO(fspace, "Griewank", queries, false);
+    StateSpaceIO::set_latency(std::chrono::microseconds(0), std::chrono::microseconds(0));
+
+    std::cout << "Heap allocations, " << dimensions << "D/" << dimensionSize << ", " << queries << " queries\n";
+    std::cout << "-----------------------------------------------\n";
+    std::cout << "| Model            | Per query |  Per cell |\n";
+    std::cout << "-----------------------------------------------\n";
+    std::cout << std::fixed << std::setprecision(2);
+
+    auto report = [&](const std::string& name, AllocationCounts counts) {
+        std::cout << "| " << std::setw(16) << name << " | " << std::setw(9) << counts.perQuery << " | "
+                  << std::setw(9) << counts.perCell << " |\n";
+    };
+
+    report("StochasticQuery", count_allocations<StochasticQueryModel>(dimensions, dimensionSize, queries));
+    report("QueryTree+IDW", count_allocations<TestModel>(dimensions, dimensionSize, queries));
+    report("GEK", count_allocations<GEKModel>(dimensions, dimensionSize, queries));
+    report("RBF", count_allocations<RBFModel>(dimensions, dimensionSize, queries));
+    std::cout << "-----------------------------------------------\n";
+
+    return 0;
+}
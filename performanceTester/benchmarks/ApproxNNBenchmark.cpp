@@ -0,0 +1,153 @@
+#include "Benchmarks.hpp"
+#include "../../src/StateSpace/KDTreeStateSpace.hpp"
+#include "../../src/Models/Mapping/IDW.hpp"
+#include "../FunctionList.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+struct ApproxSetting {
+    std::string name;
+    double epsilon;
+    int maxChecks;
+};
+
+template <typename Op>
+static double seconds_for(const std::vector<Coordinates>& targets, Op op) {
+    auto start = std::chrono::steady_clock::now();
+    for (const Coordinates& target : targets) op(target);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Recall and speed-up of the approximate nearest neighbour modes against exact search, at
+ * high dimension. NN is KDTreeStateSpace::nearest_neighbor, K-NN is the KNNTree search behind
+ * IDW with K = 8. Recall is the share of the exact neighbours found. The last columns are the
+ * mean absolute change of the IDW prediction, over samples of the performance tester functions.
+ *
+ *   sep25_benchmarks ann [dimensions] [dimensionSize] [samples] [queries]
+ */
+int approx_nn_benchmark(int argc, char* argv[]) {
+    int dimensions = argc > 0 ? std::max(1, std::atoi(argv[0])) : 6;
+    int dimensionSize = argc > 1 ? std::max(2, std::atoi(argv[1])) : 12;
+    int samples = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20000;
+    int queries = argc > 3 ? std::max(1, std::atoi(argv[3])) : 2000;
+    const int K = 8;
+
+    testfunctions::minMaxCache.clear();
+    testfunctions::dimSize = dimensionSize;
+    testfunctions::dims = dimensions;
+
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> coord(0, dimensionSize - 1);
+    auto random_points = [&](int count) {
+        std::vector<Coordinates> points(count, Coordinates(dimensions));
+        for (Coordinates& p : points)
+            for (int d = 0; d < dimensions; d++) p[d] = coord(rng);
+        return points;
+    };
+    std::vector<Coordinates> sampleCoords = random_points(samples);
+    std::vector<Coordinates> targets = random_points(queries);
+
+    KDTreeStateSpace tree(dimensions, dimensionSize);
+    std::vector<std::pair<double, Coordinates>> positions;
+    for (int i = 0; i < samples; i++) {
+        tree.insert(sampleCoords[i], i);
+        positions.emplace_back(i, sampleCoords[i]);
+    }
+    KNNTree knn(positions);
+
+    const std::vector<std::pair<std::string, SpaceFunctionType>> functions = {
+        {"Ackley", testfunctions::ackleyFunction},
+        {"Griewank", testfunctions::griewank},
+        {"Rastrigin", testfunctions::rastrigin},
+    };
+    std::vector<IDW*> idws;
+    std::vector<std::vector<double>> exactPredictions;
+    for (const auto& [name, function] : functions) {
+        std::vector<std::pair<double, Coordinates>> data;
+        for (const Coordinates& c : sampleCoords) data.emplace_back(function(c), c);
+        idws.push_back(new IDW(data, K, 2));
+        exactPredictions.emplace_back();
+        for (const Coordinates& target : targets) exactPredictions.back().push_back(idws.back()->predict(target));
+    }
+
+    // exact reference answers, then the exact times on warm trees
+    std::vector<double> exactNearest;
+    std::vector<std::vector<KNNTree::Neighbour>> exactK(queries);
+    for (const Coordinates& c : targets) exactNearest.push_back(tree.squared_distance(tree.nearest_neighbor(c)->coords, c));
+    for (int q = 0; q < queries; q++) knn.getKNearest(targets[q], K, exactK[q]);
+
+    double sink = 0.0;
+    std::vector<KNNTree::Neighbour> found;
+    double exactNNTime = seconds_for(targets, [&](const Coordinates& c) { sink += tree.nearest_neighbor(c)->value; });
+    double exactKTime = seconds_for(targets, [&](const Coordinates& c) {
+        knn.getKNearest(c, K, found);
+        sink += found[0].value;
+    });
+
+    std::cout << "Approximate nearest neighbours, " << dimensions << "D/" << dimensionSize << ", " << samples
+              << " samples, " << queries << " queries\n";
+    std::cout << "-------------------------------------------------------------------------------------------------------------\n";
+    std::cout << "| Setting         | NN recall | NN speed-up | 8-NN recall | 8-NN speed-up | IDW d Ackley | d Griewank | d Rastrigin |\n";
+    std::cout << "-------------------------------------------------------------------------------------------------------------\n";
+    std::cout << std::fixed;
+
+    const std::vector<ApproxSetting> settings = {
+        {"exact", 0.0, 0},
+        {"epsilon 0.5", 0.5, 0},
+        {"epsilon 1", 1.0, 0},
+        {"epsilon 2", 2.0, 0},
+        {"checks 1000", 0.0, 1000},
+        {"checks 200", 0.0, 200},
+        {"checks 50", 0.0, 50},
+        {"eps 1, chk 200", 1.0, 200},
+    };
+    for (const ApproxSetting& setting : settings) {
+        tree.set_approximation({setting.epsilon, setting.maxChecks});
+        knn.setApproximation({setting.epsilon, setting.maxChecks});
+
+        double nnTime = seconds_for(targets, [&](const Coordinates& c) { sink += tree.nearest_neighbor(c)->value; });
+        int nnHits = 0;
+        for (int q = 0; q < queries; q++)
+            nnHits += tree.squared_distance(tree.nearest_neighbor(targets[q])->coords, targets[q]) == exactNearest[q];
+
+        double kTime = seconds_for(targets, [&](const Coordinates& c) {
+            knn.getKNearest(c, K, found);
+            sink += found[0].value;
+        });
+        long long kHits = 0, kTotal = 0;
+        for (int q = 0; q < queries; q++) {
+            knn.getKNearest(targets[q], K, found);
+            for (const KNNTree::Neighbour& exact : exactK[q]) {
+                kTotal++;
+                kHits += std::any_of(found.begin(), found.end(), [&](const KNNTree::Neighbour& n) { return n.index == exact.index; });
+            }
+        }
+
+        std::cout << "| " << std::left << std::setw(15) << setting.name << std::right << " | "
+                  << std::setprecision(3) << std::setw(9) << double(nnHits) / queries << " | "
+                  << std::setprecision(2) << std::setw(11) << exactNNTime / nnTime << " | "
+                  << std::setprecision(3) << std::setw(11) << double(kHits) / kTotal << " | "
+                  << std::setprecision(2) << std::setw(13) << exactKTime / kTime << " |";
+        for (size_t f = 0; f < idws.size(); f++) {
+            idws[f]->set_approximation({setting.epsilon, setting.maxChecks});
+            double change = 0.0;
+            for (int q = 0; q < queries; q++) change += std::abs(idws[f]->predict(targets[q]) - exactPredictions[f][q]);
+            std::cout << " " << std::setprecision(4) << std::setw(f == 0 ? 12 : (f == 1 ? 10 : 11)) << change / queries << " |";
+        }
+        std::cout << "\n";
+    }
+    std::cout << "-------------------------------------------------------------------------------------------------------------\n";
+
+    for (IDW* idw : idws) delete idw;
+    volatile double keep = sink;
+    (void)keep;
+    return 0;
+}
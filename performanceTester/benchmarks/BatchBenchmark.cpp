@@ -0,0 +1,74 @@
+#include "Benchmarks.hpp"
+#include "../../src/Models/StochasticQueryModel.hpp"
+#include "../../src/Models/TestModel.hpp"
+#include "../../src/Models/GEKModel.hpp"
+#include "../../src/Models/RBF.hpp"
+#include "../FunctionList.hpp"
+#include "../FunctionSpace.hpp"
+#include "../StateSpaceIO.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+template <typename ModelType>
+static double time_query_phase(int dimensions, int dimensionSize, int queries, int batchSize) {
+    ModelType model(dimensions, dimensionSize, queries);
+    InputOutput* io = InputOutput::get_instance();
+
+    auto start = std::chrono::steady_clock::now();
+    io->run_queries(model, queries, batchSize);
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+/**
+ * Wall time of the query phase against the StateSpaceIO oracle stand-in, which charges a
+ * fixed latency per round trip, for increasing batch sizes.
+ *
+ *   sep25_benchmarks batch [dimensions] [dimensionSize] [queries] [--latency-us perCall]
+ */
+int batch_benchmark(int argc, char* argv[]) {
+    int dimensions = argc > 0 ? std::atoi(argv[0]) : 2;
+    int dimensionSize = argc > 1 ? std::atoi(argv[1]) : 50;
+    int queries = argc > 2 ? std::atoi(argv[2]) : 1000;
+    long long latency = 200;
+    for (int i = 3; i < argc; i++)
+        if (std::string(argv[i]) == "--latency-us" && i + 1 < argc) latency = std::atoll(argv[++i]);
+
+    testfunctions::minMaxCache.clear();
+    testfunctions::dimSize = dimensionSize;
+    testfunctions::dims = dimensions;
+
+    FunctionSpace fspace(dimensions, dimensionSize, testfunctions::griewank);
+    StateSpaceIO::set_IO(fspace, "Griewank", queries, false);
+    StateSpaceIO::set_latency(std::chrono::microseconds(latency), std::chrono::microseconds(0));
+
+    std::cout << "Query phase wall time, " << dimensions << "D/" << dimensionSize << ", "
+              << queries << " queries, " << latency << "us per round trip\n";
+    std::cout << "-------------------------------------------------------------\n";
+    std::cout << "| Model            | Batch |  Wall (s) |  Queries/s | Speedup |\n";
+    std::cout << "-------------------------------------------------------------\n";
+    std::cout << std::fixed;
+
+    auto report = [&](const std::string& name, auto timeFor) {
+        double baseline = 0.0;
+        for (int batch : {1, 4, 16, 64, 256}) {
+            double seconds = timeFor(batch);
+            if (batch == 1) baseline = seconds;
+            std::cout << "| " << std::setw(16) << name << " | " << std::setw(5) << batch << " | "
+                      << std::setprecision(4) << std::setw(9) << seconds << " | "
+                      << std::setprecision(0) << std::setw(10) << queries / seconds << " | "
+                      << std::setprecision(2) << std::setw(7) << baseline / seconds << " |\n";
+        }
+    };
+
+    report("StochasticQuery", [&](int b) { return time_query_phase<StochasticQueryModel>(dimensions, dimensionSize, queries, b); });
+    report("QueryTree+IDW", [&](int b) { return time_query_phase<TestModel>(dimensions, dimensionSize, queries, b); });
+    report("GEK", [&](int b) { return time_query_phase<GEKModel>(dimensions, dimensionSize, queries, b); });
+    report("RBF", [&](int b) { return time_query_phase<RBFModel>(dimensions, dimensionSize, queries, b); });
+    std::cout << "-------------------------------------------------------------\n";
+
+    return 0;
+}
@@ -0,0 +1,35 @@
+#include "Benchmarks.hpp"
+
+#include <iostream>
+#include <map>
+#include <string>
+
+/**
+ * Driver for the benchmarks, run as
+ *   sep25_benchmarks <benchmark> [benchmark arguments]
+ */
+int main(int argc, char* argv[]) {
+    const std::map<std::string, int (*)(int, char**)> benchmarks = {
+        {"batch", batch_benchmark},
+        {"coroutine", coroutine_benchmark},
+        {"oracle_pool", oracle_pool_benchmark},
+        {"stream_io", stream_io_benchmark},
+        {"state_space", state_space_benchmark},
+        {"allocations", allocation_benchmark},
+        {"layout", layout_benchmark},
+        {"kdtree", kdtree_benchmark},
+        {"ann", approx_nn_benchmark},
+        {"rbf_train", rbf_train_benchmark},
+        {"rbf_grid", rbf_grid_benchmark},
+        {"fps", farthest_point_benchmark},
+    };
+
+    if (argc < 2 || benchmarks.find(argv[1]) == benchmarks.end()) {
+        std::cerr << "Usage: " << argv[0] << " <benchmark> [args]\nBenchmarks:";
+        for (const auto& [name, run] : benchmarks) std::cerr << " " << name;
+        std::cerr << "\n";
+        return 1;
+    }
+
+    return benchmarks.at(argv[1])(argc - 2, argv + 2);
+}
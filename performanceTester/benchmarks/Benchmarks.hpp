@@ -0,0 +1,21 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+/**
+ * Entry points for the micro/macro benchmarks in sep25_benchmarks.
+ * Each receives the arguments that follow its name on the command line.
+ */
+int batch_benchmark(int argc, char* argv[]);
+int coroutine_benchmark(int argc, char* argv[]);
+int oracle_pool_benchmark(int argc, char* argv[]);
+int stream_io_benchmark(int argc, char* argv[]);
+int state_space_benchmark(int argc, char* argv[]);
+int allocation_benchmark(int argc, char* argv[]);
+int layout_benchmark(int argc, char* argv[]);
+int kdtree_benchmark(int argc, char* argv[]);
+int approx_nn_benchmark(int argc, char* argv[]);
+int rbf_train_benchmark(int argc, char* argv[]);
+int rbf_grid_benchmark(int argc, char* argv[]);
+int farthest_point_benchmark(int argc, char* argv[]);
+
+#endif // BENCHMARKS_H
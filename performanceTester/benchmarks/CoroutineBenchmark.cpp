@@ -0,0 +1,98 @@
+#include "Benchmarks.hpp"
+#include "../../src/InputOutput/CoroutineDriver.hpp"
+#include "../../src/Models/StochasticQueryModel.hpp"
+#include "../../src/Models/TestModel.hpp"
+#include "../../src/Models/GEKModel.hpp"
+#include "../../src/Models/RBF.hpp"
+#include "../FunctionList.hpp"
+#include "../FunctionSpace.hpp"
+#include "../LatencyOracle.hpp"
+#include "../StateSpaceIO.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+template <typename ModelType>
+static double time_synchronous(int dimensions, int dimensionSize, int queries) {
+    ModelType model(dimensions, dimensionSize, queries);
+    auto start = std::chrono::steady_clock::now();
+    InputOutput::get_instance()->run_queries(model, queries);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename ModelType>
+static double time_coroutine(int dimensions, int dimensionSize, int queries, int inFlight, LatencyOracle& oracle) {
+    ModelType model(dimensions, dimensionSize, queries);
+    auto start = std::chrono::steady_clock::now();
+    CoroutineDriver(oracle, inFlight).run(model, queries);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Wall time of the query phase with the synchronous loop against the coroutine driver
+ * keeping several queries in flight, both against an oracle with a fixed per-query latency.
+ * With --concurrency 1 the oracle works on one query at a time and any gain comes from the
+ * model computing while the oracle is busy.
+ *
+ *   sep25_benchmarks coroutine [dimensions] [dimensionSize] [queries] [--latency-us perQuery] [--concurrency oracleWorkers]
+ */
+int coroutine_benchmark(int argc, char* argv[]) {
+    int dimensions = argc > 0 ? std::atoi(argv[0]) : 2;
+    int dimensionSize = argc > 1 ? std::atoi(argv[1]) : 50;
+    int queries = argc > 2 ? std::atoi(argv[2]) : 500;
+    long long latency = 500;
+    int concurrency = 1;
+    for (int i = 3; i < argc; i++) {
+        std::string opt = argv[i];
+        if (opt == "--latency-us" && i + 1 < argc) latency = std::atoll(argv[++i]);
+        else if (opt == "--concurrency" && i + 1 < argc) concurrency = std::max(1, std::atoi(argv[++i]));
+    }
+
+    testfunctions::minMaxCache.clear();
+    testfunctions::dimSize = dimensionSize;
+    testfunctions::dims = dimensions;
+
+    FunctionSpace fspace(dimensions, dimensionSize, testfunctions::griewank);
+    StateSpaceIO::set_IO(fspace, "Griewank", queries, false);
+    StateSpaceIO::set_latency(std::chrono::microseconds(latency), std::chrono::microseconds(0));
+    auto evaluate = [&fspace](const Coordinates& query) { return fspace.get(query); };
+
+    std::cout << "Query phase wall time, " << dimensions << "D/" << dimensionSize << ", " << queries
+              << " queries, " << latency << "us per query, " << concurrency << " oracle worker(s)\n";
+    std::cout << "------------------------------------------------------\n";
+    std::cout << "| Model            | In flight |  Wall (s) | Speedup |\n";
+    std::cout << "------------------------------------------------------\n";
+    std::cout << std::fixed;
+
+    auto report = [&](const std::string& name, auto sync, auto coroutine) {
+        double baseline = sync();
+        auto row = [&](const std::string& mode, double seconds) {
+            std::cout << "| " << std::setw(16) << name << " | " << std::setw(9) << mode << " | "
+                      << std::setprecision(4) << std::setw(9) << seconds << " | "
+                      << std::setprecision(2) << std::setw(7) << baseline / seconds << " |\n";
+        };
+        row("sync", baseline);
+        for (int inFlight : {1, 2, 4, 8}) {
+            LatencyOracle oracle(evaluate, std::chrono::microseconds(latency), concurrency);
+            row(std::to_string(inFlight), coroutine(inFlight, oracle));
+        }
+    };
+
+    report("StochasticQuery",
+           [&] { return time_synchronous<StochasticQueryModel>(dimensions, dimensionSize, queries); },
+           [&](int f, LatencyOracle& o) { return time_coroutine<StochasticQueryModel>(dimensions, dimensionSize, queries, f, o); });
+    report("QueryTree+IDW",
+           [&] { return time_synchronous<TestModel>(dimensions, dimensionSize, queries); },
+           [&](int f, LatencyOracle& o) { return time_coroutine<TestModel>(dimensions, dimensionSize, queries, f, o); });
+    report("GEK",
+           [&] { return time_synchronous<GEKModel>(dimensions, dimensionSize, queries); },
+           [&](int f, LatencyOracle& o) { return time_coroutine<GEKModel>(dimensions, dimensionSize, queries, f, o); });
+    report("RBF",
+           [&] { return time_synchronous<RBFModel>(dimensions, dimensionSize, queries); },
+           [&](int f, LatencyOracle& o) { return time_coroutine<RBFModel>(dimensions, dimensionSize, queries, f, o); });
+    std::cout << "------------------------------------------------------\n";
+
+    return 0;
+}
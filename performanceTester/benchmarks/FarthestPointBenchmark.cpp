@@ -0,0 +1,77 @@
+#include "Benchmarks.hpp"
+#include "../../src/Models/RBF.hpp"
+#include "../../src/StateSpace/KDTreeStateSpace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+// the cell farthest from every sample, rescanning the whole lattice with one batched search per
+// query, as RBFModel did before it kept the distances
+static double rescan_microseconds(int dimensions, int dimensionSize, int stride, int queries) {
+    std::vector<Coordinates> lattice;
+    Coordinates c(dimensions, 0);
+    while (true) {
+        lattice.push_back(c);
+        int d = dimensions - 1;
+        while (d >= 0 && c[d] + stride >= dimensionSize) c[d--] = 0;
+        if (d < 0) break;
+        c[d] += stride;
+    }
+
+    KDTreeStateSpace tree(dimensions, dimensionSize);
+    tree.insert(Coordinates(dimensions, dimensionSize / 2), 1.0);
+    std::vector<KDTreeStateSpace::Neighbor> nearest;
+    auto start = std::chrono::steady_clock::now();
+    for (int q = 1; q < queries; q++) {
+        tree.nearest_neighbors(lattice, nearest);
+        size_t best = 0;
+        for (size_t i = 1; i < lattice.size(); i++)
+            if (nearest[i].squaredDistance > nearest[best].squaredDistance) best = i;
+        tree.insert(lattice[best], 1.0);
+    }
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / queries;
+}
+
+static double model_microseconds(int dimensions, int dimensionSize, int queries) {
+    // a budget past the queries so the model never trains
+    RBFModel model(dimensions, dimensionSize, queries * 100);
+    auto start = std::chrono::steady_clock::now();
+    for (int q = 0; q < queries; q++) model.update_prediction(model.get_next_query(), 1.0);
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / queries;
+}
+
+/**
+ * Microseconds per RBFModel farthest point query and answer, the distance field kept up to date
+ * against a rescan of every lattice candidate per query. The lattice stride is the one the
+ * model picks, so both search the same candidates.
+ *
+ *   sep25_benchmarks fps [queries]
+ */
+int farthest_point_benchmark(int argc, char* argv[]) {
+    int queries = argc > 0 ? std::max(10, std::atoi(argv[0])) : 2000;
+
+    struct Grid { int dimensions, dimensionSize, stride; };
+    const std::vector<Grid> grids = {{2, 1024, 8}, {3, 128, 8}, {3, 60, 1}, {4, 40, 2}, {6, 12, 2}};
+
+    std::cout << "Farthest point sampling, " << queries << " queries, microseconds per query\n";
+    std::cout << "---------------------------------------------------------------\n";
+    std::cout << "|  D |    K |  Lattice |   Rescan | Distance field | Speed-up |\n";
+    std::cout << "---------------------------------------------------------------\n";
+    std::cout << std::fixed;
+    for (const Grid& g : grids) {
+        long long lattice = 1;
+        for (int d = 0; d < g.dimensions; d++) lattice *= (g.dimensionSize + g.stride - 1) / g.stride;
+        double rescan = rescan_microseconds(g.dimensions, g.dimensionSize, g.stride, queries);
+        double field = model_microseconds(g.dimensions, g.dimensionSize, queries);
+        std::cout << "| " << std::setw(2) << g.dimensions << " | " << std::setw(4) << g.dimensionSize << " | "
+                  << std::setw(8) << lattice << " | " << std::setprecision(1) << std::setw(8) << rescan << " | "
+                  << std::setw(14) << field << " | " << std::setw(8) << rescan / field << " |\n";
+    }
+    std::cout << "---------------------------------------------------------------\n";
+    return 0;
+}
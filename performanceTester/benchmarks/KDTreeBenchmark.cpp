@@ -0,0 +1,127 @@
+#include "Benchmarks.hpp"
+#include "../../src/StateSpace/KDTreeStateSpace.hpp"
+#include "../../src/StateSpace/FlatKDTreeStateSpace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+static std::vector<Coordinates> random_points(int dimensions, int dimensionSize, std::size_t count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> coord(0, dimensionSize - 1);
+    std::vector<Coordinates> points(count, Coordinates(dimensions));
+    for (Coordinates& p : points)
+        for (int d = 0; d < dimensions; d++) p[d] = coord(rng);
+    return points;
+}
+
+// millions of calls per second of op over items
+template <typename Op>
+static double throughput(const std::vector<Coordinates>& items, Op op) {
+    auto start = std::chrono::steady_clock::now();
+    for (const Coordinates& item : items) op(item);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return items.size() / seconds / 1e6;
+}
+
+static void benchmark_size(int dimensions, std::size_t points, std::size_t queries) {
+    // about 64 cells per point, so repeated cells are rare
+    int dimensionSize = std::max(16, (int)std::ceil(std::pow(64.0 * points, 1.0 / dimensions)));
+    std::vector<Coordinates> samples = random_points(dimensions, dimensionSize, points, 5);
+    std::vector<Coordinates> targets = random_points(dimensions, dimensionSize, queries, 11);
+    double sink = 0.0;
+
+    auto* tree = new KDTreeStateSpace(dimensions, dimensionSize);
+    double treeInsert = throughput(samples, [&](const Coordinates& c) { tree->insert(c, c[0]); });
+    double treeNearest = throughput(targets, [&](const Coordinates& c) { sink += tree->nearest_neighbor(c)->value; });
+    delete tree;
+
+    FlatKDTreeStateSpace flat(dimensions, dimensionSize);
+    double flatInsert = throughput(samples, [&](const Coordinates& c) { flat.insert(c, c[0]); });
+    double flatNearest = throughput(targets, [&](const Coordinates& c) { sink += flat.value_of(flat.nearest_neighbor(c)->point); });
+
+    std::cout << "| " << std::setw(2) << dimensions << " | " << std::setw(8) << points << " | "
+              << std::setw(14) << treeInsert << " | " << std::setw(14) << flatInsert << " | "
+              << std::setw(15) << treeNearest << " | " << std::setw(15) << flatNearest << " | "
+              << std::setw(10) << flat.depth() << " |\n";
+
+    volatile double keep = sink;
+    (void)keep;
+}
+
+// nearest sample of every point of a strided lattice, as RBFModel seeds its farthest point candidates,
+// one nearest_neighbor call per point against one batched nearest_neighbors call
+static void benchmark_lattice(int dimensions, int dimensionSize, int stride, std::size_t points) {
+    KDTreeStateSpace tree(dimensions, dimensionSize);
+    for (const Coordinates& c : random_points(dimensions, dimensionSize, points, 5)) tree.insert(c, c[0]);
+
+    std::vector<Coordinates> lattice;
+    Coordinates at(dimensions, 0);
+    while (true) {
+        lattice.push_back(at);
+        int d = dimensions - 1;
+        while (d >= 0 && (at[d] += stride) >= dimensionSize) at[d--] = 0;
+        if (d < 0) break;
+    }
+
+    const int repeats = 5;
+    double sink = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++)
+        for (const Coordinates& c : lattice) sink += tree.nearest_neighbor(c)->value;
+    double single = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / repeats;
+
+    std::vector<KDTreeStateSpace::Neighbor> nearest;
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        tree.nearest_neighbors(lattice, nearest);
+        sink += nearest[0].squaredDistance;
+    }
+    double batched = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / repeats;
+
+    std::cout << "| " << std::setw(2) << dimensions << " | " << std::setw(8) << lattice.size() << " | "
+              << std::setw(8) << points << " | " << std::setw(16) << single * 1e3 << " | "
+              << std::setw(17) << batched * 1e3 << " | " << std::setw(8) << single / batched << " |\n";
+    volatile double keep = sink;
+    (void)keep;
+}
+
+/**
+ * Insert and nearest neighbour throughput of KDTreeStateSpace against FlatKDTreeStateSpace,
+ * for uniformly random samples at 10^4 up to maxPoints points, in millions of calls per second.
+ * Then the time to find the nearest sample of every point of a lattice, target by target and batched.
+ *
+ *   sep25_benchmarks kdtree [maxPoints] [dimensions] [queries]
+ */
+int kdtree_benchmark(int argc, char* argv[]) {
+    std::size_t maxPoints = argc > 0 ? std::max(10000L, std::atol(argv[0])) : 1000000;
+    int dimensions = argc > 1 ? std::max(1, std::atoi(argv[1])) : 3;
+    std::size_t queries = argc > 2 ? std::max(1L, std::atol(argv[2])) : 100000;
+
+    std::cout << "k-d trees, " << dimensions << "D, " << queries << " nearest neighbour queries, millions per second\n";
+    std::cout << "-----------------------------------------------------------------------------------------\n";
+    std::cout << "|  D |   Points | Insert pointer | Insert    flat | Nearest pointer | Nearest    flat | Flat depth |\n";
+    std::cout << "-----------------------------------------------------------------------------------------\n";
+    std::cout << std::fixed << std::setprecision(3);
+
+    for (std::size_t points = 10000; points <= maxPoints; points *= 10)
+        benchmark_size(dimensions, points, queries);
+    std::cout << "-----------------------------------------------------------------------------------------\n\n";
+
+    std::cout << "Nearest sample of every lattice point, milliseconds per lattice\n";
+    std::cout << "-------------------------------------------------------------------------------\n";
+    std::cout << "|  D |  Lattice |  Samples | nearest_neighbor | nearest_neighbors | Speed-up |\n";
+    std::cout << "-------------------------------------------------------------------------------\n";
+    for (std::size_t points : {1000, 10000, 100000}) {
+        benchmark_lattice(2, 1024, 8, points);
+        benchmark_lattice(3, 256, 8, points);
+    }
+    std::cout << "-------------------------------------------------------------------------------\n";
+
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include "Benchmarks.hpp"
+#include "../../src/StateSpace/ArrayStateSpace.hpp"
+#include "../../src/StateSpace/MortonStateSpace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// the cell and its 2*D face neighbours are read per centre, returns millions of centres per second
+template <typename Read>
+static double stencil_throughput(const std::vector<Coordinates>& centres, int repeats, Read read, double& sink) {
+    auto start = std::chrono::steady_clock::now();
+    double sum = 0.0;
+    for (int r = 0; r < repeats; r++) {
+        for (const Coordinates& centre : centres) {
+            Coordinates probe = centre;
+            sum += read(probe);
+            for (std::size_t d = 0; d < probe.size(); d++) {
+                probe[d]--;
+                sum += read(probe);
+                probe[d] += 2;
+                sum += read(probe);
+                probe[d]--;
+            }
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    sink += sum;
+    return centres.size() * repeats / seconds / 1e6;
+}
+
+// interior centres, either uniformly random or a random walk of unit steps along random axes
+static std::vector<Coordinates> make_centres(int dimensions, int dimensionSize, std::size_t count, bool walk) {
+    std::mt19937 rng(17);
+    std::uniform_int_distribution<int> coord(1, dimensionSize - 2);
+    std::uniform_int_distribution<int> axis(0, dimensions - 1);
+    std::vector<Coordinates> centres;
+    centres.reserve(count);
+
+    Coordinates at(dimensions);
+    for (int d = 0; d < dimensions; d++) at[d] = coord(rng);
+    for (std::size_t i = 0; i < count; i++) {
+        if (walk) {
+            int d = axis(rng);
+            at[d] = std::clamp(at[d] + (rng() & 1 ? 1 : -1), 1, dimensionSize - 2);
+        } else {
+            for (int d = 0; d < dimensions; d++) at[d] = coord(rng);
+        }
+        centres.push_back(at);
+    }
+    return centres;
+}
+
+static void benchmark_shape(int dimensions, int dimensionSize, std::size_t count, int repeats) {
+    ArrayStateSpace rowMajor(dimensions, dimensionSize, 1.0);
+    MortonStateSpace morton(dimensions, dimensionSize, 1.0);
+    std::span<const double> mortonCells = morton.raw_view();
+    double sink = 0.0;
+
+    for (bool walk : {false, true}) {
+        std::vector<Coordinates> centres = make_centres(dimensions, dimensionSize, count, walk);
+        double rowGet = stencil_throughput(centres, repeats, [&](const Coordinates& c) { return rowMajor.get(c); }, sink);
+        double mortonGet = stencil_throughput(centres, repeats, [&](const Coordinates& c) { return morton.get(c); }, sink);
+        double mortonIndex = stencil_throughput(centres, repeats, [&](const Coordinates& c) { return mortonCells[morton.index(c)]; }, sink);
+
+        std::cout << "| " << std::setw(2) << dimensions << " | " << std::setw(9) << dimensionSize << " | "
+                  << std::setw(6) << (walk ? "walk" : "random") << " | " << std::setprecision(2)
+                  << std::setw(15) << rowGet << " | " << std::setw(12) << mortonGet << " | "
+                  << std::setw(16) << mortonIndex << " |\n";
+    }
+
+    volatile double keep = sink;
+    (void)keep;
+}
+
+/**
+ * Throughput of a 2D+1 point stencil read (a cell and its face neighbours) from row-major
+ * ArrayStateSpace and from MortonStateSpace, at uniformly random centres and along a random
+ * walk. Grids are ~32 MB so the row-major neighbours along the first axes miss the cache.
+ *
+ *   sep25_benchmarks layout [centres] [repeats]
+ */
+int layout_benchmark(int argc, char* argv[]) {
+    std::size_t count = argc > 0 ? std::max(1, std::atoi(argv[0])) : 1 << 20;
+    int repeats = argc > 1 ? std::max(1, std::atoi(argv[1])) : 3;
+
+#ifdef MASS_HAVE_BMI2
+    const char* interleave = "BMI2 pdep/pext";
+#else
+    const char* interleave = "lookup tables";
+#endif
+    std::cout << "Stencil reads, " << count << " centres x " << repeats << ", millions of centres per second ("
+              << interleave << ")\n";
+    std::cout << "-------------------------------------------------------------------------------\n";
+    std::cout << "|  D | Dim. size | Centre | Row-major get() | Morton get() | Morton index()  |\n";
+    std::cout << "-------------------------------------------------------------------------------\n";
+    std::cout << std::fixed;
+
+    benchmark_shape(2, 2048, count, repeats);
+    benchmark_shape(3, 160, count, repeats);
+    benchmark_shape(4, 48, count, repeats);
+    benchmark_shape(6, 13, count, repeats);
+    std::cout << "-------------------------------------------------------------------------------\n";
+
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include "Benchmarks.hpp"
+#include "../../src/InputOutput/CoroutineDriver.hpp"
+#include "../../src/InputOutput/ProcessPoolInputOutput.hpp"
+#include "../../src/Models/TestModel.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#ifndef SEP25_ORACLE_PATH
+    #define SEP25_ORACLE_PATH "./sep25_oracle"
+#endif
+
+// keep every process busy with raw queries, no model in the loop
+static double time_raw(ProcessPoolInputOutput& pool, int dimensions, int dimensionSize, int queries) {
+    auto start = std::chrono::steady_clock::now();
+    int sent = 0;
+    for (; sent < pool.get_processes() && sent < queries; sent++)
+        pool.submit(sent, InputOutput::index_to_coords(sent % dimensionSize, dimensions, dimensionSize));
+    for (int received = 0; received < queries; received++) {
+        pool.wait_next();
+        if (sent < queries) {
+            pool.submit(sent, InputOutput::index_to_coords(sent % dimensionSize, dimensions, dimensionSize));
+            sent++;
+        }
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static double time_model(ProcessPoolInputOutput& pool, int dimensions, int dimensionSize, int queries) {
+    TestModel model(dimensions, dimensionSize, queries);
+    auto start = std::chrono::steady_clock::now();
+    CoroutineDriver(pool, pool.get_processes()).run(model, queries);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Queries per second through a pool of N stand-in oracle processes as N grows, both raw and
+ * with the QueryTree+IDW model choosing the queries through the coroutine driver.
+ *
+ *   sep25_benchmarks oracle_pool [dimensions] [dimensionSize] [queries] [--latency-us perQuery] [--max-processes N] [--oracle path]
+ */
+int oracle_pool_benchmark(int argc, char* argv[]) {
+    int dimensions = argc > 0 ? std::atoi(argv[0]) : 2;
+    int dimensionSize = argc > 1 ? std::atoi(argv[1]) : 50;
+    int queries = argc > 2 ? std::atoi(argv[2]) : 2000;
+    long long latency = 1000;
+    int maxProcesses = 8;
+    std::string oracle = SEP25_ORACLE_PATH;
+    for (int i = 3; i < argc; i++) {
+        std::string opt = argv[i];
+        if (opt == "--latency-us" && i + 1 < argc) latency = std::atoll(argv[++i]);
+        else if (opt == "--max-processes" && i + 1 < argc) maxProcesses = std::max(1, std::atoi(argv[++i]));
+        else if (opt == "--oracle" && i + 1 < argc) oracle = argv[++i];
+    }
+
+    std::cout << "Oracle pool throughput, " << dimensions << "D/" << dimensionSize << ", " << queries
+              << " queries, " << latency << "us per query\n";
+    std::cout << "-------------------------------------------------------\n";
+    std::cout << "| Processes |  Raw queries/s | Model queries/s | Scale |\n";
+    std::cout << "-------------------------------------------------------\n";
+    std::cout << std::fixed;
+
+    double base = 0.0;
+    for (int processes = 1; processes <= maxProcesses; processes *= 2) {
+        ProcessPoolInputOutput pool({oracle, "--latency-us", std::to_string(latency)}, processes);
+        double raw = queries / time_raw(pool, dimensions, dimensionSize, queries);
+        double model = queries / time_model(pool, dimensions, dimensionSize, queries);
+        if (processes == 1) base = raw;
+        std::cout << "| " << std::setw(9) << processes << " | "
+                  << std::setprecision(0) << std::setw(14) << raw << " | "
+                  << std::setw(15) << model << " | "
+                  << std::setprecision(2) << std::setw(5) << raw / base << " |\n";
+    }
+    std::cout << "-------------------------------------------------------\n";
+
+    return 0;
+}
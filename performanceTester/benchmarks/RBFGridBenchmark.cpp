@@ -0,0 +1,81 @@
+#include "Benchmarks.hpp"
+#include "../../src/Models/RBF.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * Full-grid RBFModel reconstruction through evaluate_range, exact against the FFT convolution
+ * of set_evaluation_tolerance, for each kernel the model selects. The grid is sized so samples
+ * / cells is rho, which decides the kernel. Error is the largest absolute difference of a cell.
+ *
+ *   sep25_benchmarks rbf_grid [samples] [dimensions] [tolerance]
+ */
+int rbf_grid_benchmark(int argc, char* argv[]) {
+    int samples = argc > 0 ? std::max(10, std::atoi(argv[0])) : 3000;
+    int dimensions = argc > 1 ? std::max(2, std::atoi(argv[1])) : 3;
+    double tolerance = argc > 2 ? std::atof(argv[2]) : 1e-6;
+
+    // samples / cells for each kernel, the 2D special case picks MQ for 0.12 as well
+    const std::vector<std::pair<std::string, double>> kernels = {
+        {"IMQ", 0.03}, {"MQ", 0.12}, {"Gaussian", 0.35}};
+
+    std::cout << "RBF grid evaluation, " << dimensions << "D, " << samples << " samples, tolerance "
+              << tolerance << "\n";
+    std::cout << "---------------------------------------------------------------------------------\n";
+    std::cout << "| Kernel   |  Grid |      Cells | Exact (s) |   FFT (s) | Speed-up |  Max error |\n";
+    std::cout << "---------------------------------------------------------------------------------\n";
+    for (const auto& [name, rho] : kernels) {
+        int dimensionSize = std::max(4, (int)std::ceil(std::pow(samples / rho, 1.0 / dimensions)));
+        RBFModel model(dimensions, dimensionSize, samples);
+
+        std::mt19937 rng(samples);
+        std::uniform_int_distribution<int> coord(0, dimensionSize - 1);
+        std::set<Coordinates> seen;
+        std::vector<Coordinates> queries;
+        std::vector<double> results;
+        while ((int)queries.size() < samples) {
+            Coordinates c(dimensions);
+            double value = 0.0;
+            for (int d = 0; d < dimensions; d++) {
+                c[d] = coord(rng);
+                value += std::sin(6.0 * c[d] / dimensionSize);
+            }
+            if (!seen.insert(c).second) continue;
+            queries.push_back(c);
+            results.push_back(value);
+        }
+        model.update_predictions(queries, results);
+
+        const long long cells = model.cell_count();
+        std::vector<double> exact(cells), fast(cells);
+        auto start = std::chrono::steady_clock::now();
+        model.evaluate_range(0, cells, exact.data());
+        double exactTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        model.set_evaluation_tolerance(tolerance);
+        start = std::chrono::steady_clock::now();
+        model.evaluate_range(0, cells, fast.data());
+        double fastTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        double error = 0.0;
+        for (long long c = 0; c < cells; c++) error = std::max(error, std::abs(fast[c] - exact[c]));
+
+        std::cout << "| " << std::left << std::setw(8) << name << std::right << " | " << std::setw(5)
+                  << dimensionSize << " | " << std::setw(10) << cells << " | " << std::fixed
+                  << std::setprecision(3) << std::setw(9) << exactTime << " | " << std::setw(9) << fastTime
+                  << " | " << std::setprecision(1) << std::setw(8) << exactTime / fastTime << " | "
+                  << std::scientific << std::setprecision(2) << std::setw(10) << error << " |\n"
+                  << std::defaultfloat;
+    }
+    std::cout << "---------------------------------------------------------------------------------\n";
+    return 0;
+}
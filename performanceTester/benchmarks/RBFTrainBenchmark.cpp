@@ -0,0 +1,79 @@
+#include "Benchmarks.hpp"
+#include "../../src/Models/RBF.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+// seconds for an RBFModel to take N distinct random samples in one block and train on them.
+// The grid is sized so samples / cells is rho, which decides the kernel the model picks.
+static double time_training(int dimensions, int samples, double rho, bool partitioned = false) {
+    int dimensionSize = std::max(4, (int)std::ceil(std::pow(samples / rho, 1.0 / dimensions)));
+    RBFModel model(dimensions, dimensionSize, samples);
+    model.set_partition_of_unity(partitioned);
+
+    std::mt19937 rng(samples);
+    std::uniform_int_distribution<int> coord(0, dimensionSize - 1);
+    std::set<Coordinates> seen;
+    std::vector<Coordinates> queries;
+    std::vector<double> results;
+    while ((int)queries.size() < samples) {
+        Coordinates c(dimensions);
+        double value = 0.0;
+        for (int d = 0; d < dimensions; d++) {
+            c[d] = coord(rng);
+            value += std::sin(6.0 * c[d] / dimensionSize);
+        }
+        if (!seen.insert(c).second) continue;
+        queries.push_back(c);
+        results.push_back(value);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    model.update_predictions(queries, results);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * RBFModel training time from 1k samples up to maxSamples, for each kernel the model selects:
+ * up to RBFModel::DENSE_MAX_SAMPLES, IMQ and Gaussian train through Cholesky and MQ through LU.
+ * Beyond it the model trains the compact Wendland kernel through a sparse solve. The last
+ * column is the partition-of-unity mode with the MQ kernel, at every size.
+ *
+ *   sep25_benchmarks rbf_train [maxSamples] [dimensions]
+ */
+int rbf_train_benchmark(int argc, char* argv[]) {
+    int maxSamples = argc > 0 ? std::max(1000, std::atoi(argv[0])) : 100000;
+    int dimensions = argc > 1 ? std::max(3, std::atoi(argv[1])) : 3;
+
+    // samples / cells for each kernel, away from the 2D special case
+    const std::vector<std::pair<std::string, double>> kernels = {
+        {"IMQ", 0.03}, {"MQ", 0.12}, {"Gaussian", 0.3}, {"Wendland", 0.1}};
+
+    std::cout << "RBF training, " << dimensions << "D, seconds\n";
+    std::cout << "--------------------------------------------------------------------\n";
+    std::cout << "|  Samples |      IMQ |       MQ | Gaussian | Wendland |   MQ PoU |\n";
+    std::cout << "--------------------------------------------------------------------\n";
+    std::cout << std::fixed << std::setprecision(2);
+    for (int samples : {1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000, 1000000}) {
+        if (samples > maxSamples) break;
+        bool dense = samples <= RBFModel::DENSE_MAX_SAMPLES;
+        std::cout << "| " << std::setw(8) << samples << " |";
+        for (const auto& [name, rho] : kernels) {
+            if (dense != (name != "Wendland"))
+                std::cout << "        - |";
+            else
+                std::cout << " " << std::setw(8) << time_training(dimensions, samples, rho) << " |" << std::flush;
+        }
+        std::cout << " " << std::setw(8) << time_training(dimensions, samples, 0.12, true) << " |\n";
+    }
+    std::cout << "--------------------------------------------------------------------\n";
+    return 0;
+}
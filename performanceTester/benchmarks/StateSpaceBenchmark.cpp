@@ -0,0 +1,87 @@
+#include "Benchmarks.hpp"
+#include "../../src/StateSpace/ArrayStateSpaceN.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// a read-modify-write per coordinate, returns millions of cells per second
+template <typename Access>
+static double throughput(std::size_t accesses, int repeats, Access access) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++)
+        for (std::size_t i = 0; i < accesses; i++) access(i);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return accesses * repeats / seconds / 1e6;
+}
+
+template <int D>
+static void benchmark_dimension(int dimensionSize, std::size_t accesses, int repeats) {
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> coord(0, dimensionSize - 1);
+    std::vector<Coordinates> dynamic(accesses, Coordinates(D));
+    std::vector<std::array<int, D>> fixed(accesses);
+    for (std::size_t i = 0; i < accesses; i++)
+        for (int d = 0; d < D; d++) fixed[i][d] = dynamic[i][d] = coord(rng);
+
+    ArrayStateSpace generic(D, dimensionSize);
+    std::unique_ptr<ArrayStateSpace> dispatched = make_array_state_space(D, dimensionSize);
+    ArrayStateSpaceN<D> specialised(dimensionSize);
+
+    double vectorGeneric = throughput(accesses, repeats, [&](std::size_t i) {
+        generic.set(dynamic[i], generic.get(dynamic[i]) + 1.0);
+    });
+    double vectorDispatched = throughput(accesses, repeats, [&](std::size_t i) {
+        dispatched->set(dynamic[i], dispatched->get(dynamic[i]) + 1.0);
+    });
+    double checked = throughput(accesses, repeats, [&](std::size_t i) {
+        specialised.at(fixed[i]) += 1.0;
+    });
+    double unchecked = throughput(accesses, repeats, [&](std::size_t i) {
+        specialised[fixed[i]] += 1.0;
+    });
+
+    // keep the stores observable
+    volatile double sink = generic.raw_view()[0] + dispatched->raw_view()[0] + specialised.raw_view()[0];
+    (void)sink;
+
+    std::cout << "| " << std::setw(2) << D << " | " << std::setw(9) << dimensionSize << " | "
+              << std::setprecision(1) << std::setw(14) << vectorGeneric << " | "
+              << std::setw(17) << vectorDispatched << " | "
+              << std::setw(10) << checked << " | "
+              << std::setw(10) << unchecked << " |\n";
+}
+
+/**
+ * Random get/set throughput of the generic ArrayStateSpace against ArrayStateSpaceN<D>,
+ * through the Coordinates interface of make_array_state_space and through std::array
+ * coordinates, checked (at) and unchecked (operator[]).
+ *
+ *   sep25_benchmarks state_space [accesses] [repeats]
+ */
+int state_space_benchmark(int argc, char* argv[]) {
+    std::size_t accesses = argc > 0 ? std::max(1, std::atoi(argv[0])) : 1 << 20;
+    int repeats = argc > 1 ? std::max(1, std::atoi(argv[1])) : 5;
+
+    std::cout << "State space get+set throughput, " << accesses << " random cells x " << repeats << ", millions per second\n";
+    std::cout << "-------------------------------------------------------------------------------\n";
+    std::cout << "|  D | Dim. size | Generic vector | Dispatched vector | Array (at) | Array ([]) |\n";
+    std::cout << "-------------------------------------------------------------------------------\n";
+    std::cout << std::fixed;
+
+    benchmark_dimension<1>(1 << 20, accesses, repeats);
+    benchmark_dimension<2>(1024, accesses, repeats);
+    benchmark_dimension<3>(100, accesses, repeats);
+    benchmark_dimension<4>(32, accesses, repeats);
+    benchmark_dimension<6>(10, accesses, repeats);
+    benchmark_dimension<8>(6, accesses, repeats);
+    std::cout << "-------------------------------------------------------------------------------\n";
+
+    return 0;
+}
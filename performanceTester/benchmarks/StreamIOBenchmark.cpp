@@ -0,0 +1,158 @@
+#include "Benchmarks.hpp"
+#include "../../src/InputOutput/BufferedStreamIO.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <sys/wait.h>
+    #include <unistd.h>
+    #define MASS_HAVE_PROCESSES 1
+#endif
+
+#ifdef MASS_HAVE_PROCESSES
+
+// times queries round trips through io, inFlight of them outstanding at once (1 = synchronous)
+static double run_queries(InputOutput& io, const std::vector<Coordinates>& pool, int queries, int inFlight) {
+    auto start = std::chrono::steady_clock::now();
+    if (inFlight <= 1) {
+        for (int i = 0; i < queries; i++)
+            io.send_query_recieve_result(pool[i % pool.size()]);
+    } else {
+        auto& oracle = dynamic_cast<AsyncOracle&>(io);
+        int sent = 0;
+        for (; sent < inFlight && sent < queries; sent++)
+            oracle.submit(sent, pool[sent % pool.size()]);
+        for (int received = 0; received < queries; received++) {
+            oracle.wait_next();
+            if (sent < queries) {
+                oracle.submit(sent, pool[sent % pool.size()]);
+                sent++;
+            }
+        }
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Fork a model side whose stdin/stdout are pipes to this process, which answers every query
+ * line at once. Returns the round trips per second the model side measured.
+ */
+static double round_trips(bool buffered, const std::vector<Coordinates>& pool, int queries, int inFlight) {
+    int toModel[2], fromModel[2], timing[2];
+    if (::pipe(toModel) != 0 || ::pipe(fromModel) != 0 || ::pipe(timing) != 0)
+        throw std::runtime_error("Failed to create benchmark pipes");
+
+    std::cout.flush();
+    std::fflush(stdout);
+    pid_t pid = ::fork();
+    if (pid < 0) throw std::runtime_error("Failed to fork the model side");
+
+    if (pid == 0) {
+        ::dup2(toModel[0], 0);
+        ::dup2(fromModel[1], 1);
+        ::close(toModel[0]); ::close(toModel[1]);
+        ::close(fromModel[0]); ::close(fromModel[1]);
+        ::close(timing[0]);
+
+        double seconds;
+        if (buffered) {
+            BufferedStreamIO io;
+            seconds = run_queries(io, pool, queries, inFlight);
+        } else {
+            CommandLineInputOutput::set_IO();
+            seconds = run_queries(*InputOutput::get_instance(), pool, queries, inFlight);
+            std::cout.flush();
+        }
+        double rate = queries / seconds;
+        ssize_t ignored = ::write(timing[1], &rate, sizeof(rate));
+        (void)ignored;
+        ::_exit(0);
+    }
+
+    ::close(toModel[0]);
+    ::close(fromModel[1]);
+    ::close(timing[1]);
+
+    // instant oracle, one result per query line
+    char in[1 << 16];
+    std::string reply;
+    ssize_t n;
+    while ((n = ::read(fromModel[0], in, sizeof(in))) > 0) {
+        reply.clear();
+        for (ssize_t i = 0; i < n; i++)
+            if (in[i] == '\n') reply += "0.5\n";
+        for (size_t written = 0; written < reply.size();) {
+            ssize_t w = ::write(toModel[1], reply.data() + written, reply.size() - written);
+            if (w <= 0) break;
+            written += w;
+        }
+    }
+    ::close(toModel[1]);
+    ::close(fromModel[0]);
+
+    double rate = 0.0;
+    if (::read(timing[0], &rate, sizeof(rate)) != sizeof(rate)) rate = 0.0;
+    ::close(timing[0]);
+    ::waitpid(pid, nullptr, 0);
+    return rate;
+}
+
+/**
+ * Round trips per second of the stdin/stdout protocol over a pipe to an oracle that answers
+ * instantly, so only the IO layer is measured: CommandLineInputOutput against BufferedStreamIO,
+ * synchronously and with several queries in flight.
+ *
+ *   sep25_benchmarks stream_io [dimensions] [queries] [--in-flight N]
+ */
+int stream_io_benchmark(int argc, char* argv[]) {
+    int dimensions = argc > 0 ? std::atoi(argv[0]) : 4;
+    int queries = argc > 1 ? std::atoi(argv[1]) : 200000;
+    int inFlight = 8;
+    for (int i = 2; i < argc; i++) {
+        std::string opt = argv[i];
+        if (opt == "--in-flight" && i + 1 < argc) inFlight = std::max(2, std::atoi(argv[++i]));
+    }
+
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> coord(0, 999);
+    std::vector<Coordinates> pool(1024, Coordinates(dimensions));
+    for (auto& query : pool)
+        for (auto& c : query) c = coord(rng);
+
+    std::cout << "Oracle round trips over a pipe, " << dimensions << "D queries, " << queries << " queries\n";
+    std::cout << "-----------------------------------------------------------\n";
+    std::cout << "| Mode          | CommandLine/s |  Buffered/s | Speed up |\n";
+    std::cout << "-----------------------------------------------------------\n";
+    std::cout << std::fixed;
+
+    for (int flight : {1, inFlight}) {
+        double clio = round_trips(false, pool, queries, flight);
+        double buffered = round_trips(true, pool, queries, flight);
+        std::string mode = flight == 1 ? "synchronous" : std::to_string(flight) + " in flight";
+        std::cout << "| " << std::left << std::setw(13) << mode << std::right << " | "
+                  << std::setprecision(0) << std::setw(13) << clio << " | "
+                  << std::setw(11) << buffered << " | "
+                  << std::setprecision(2) << std::setw(7) << buffered / clio << "x |\n";
+    }
+    std::cout << "-----------------------------------------------------------\n";
+
+    return 0;
+}
+
+#else
+
+int stream_io_benchmark(int, char*[]) {
+    std::cerr << "stream_io needs fork and pipes, which this platform does not provide\n";
+    return 1;
+}
+
+#endif
@@ -29,13 +29,14 @@
 #include <iomanip>
 #include <map>
 #include <chrono>
+#include <limits>
 struct PerfResult {
     std::string name;
     Results results;
 };
 
 
-PerfResult runPerfTest(int dimensions, int dimensionSize, bool outputStateSpace, bool stochastic, int queries, SpaceFunctionType func, const std::string& name) {
+PerfResult runPerfTest(int dimensions, int dimensionSize, bool outputStateSpace, bool stochastic, int queries, int batchSize, SpaceFunctionType func, const std::string& name) {
     
     FunctionSpace fspace(dimensions, dimensionSize, func);
     
@@ -44,13 +45,7 @@ PerfResult runPerfTest(int dimensions, int dimensionSize, bool outputStateSpace,
 
     CurrentModel model(dimensions, dimensionSize, queries);
     
-    for (int i = 0; i < queries; i++) {
-        std::vector<int> query = model.get_next_query();
-
-        double result = io->send_query_recieve_result(query);
-
-        model.update_prediction(query, result);
-    }
+    io->run_queries(model, queries, batchSize);
     
     io->output_state(model, outputStateSpace);
 
@@ -58,7 +53,7 @@ PerfResult runPerfTest(int dimensions, int dimensionSize, bool outputStateSpace,
 }
 
 // Run model against all functions in testfunctions and output a table
-void runAllFunctions(int dimensions, int dimensionSize, bool outputStateSpace, bool stochastic) {
+void runAllFunctions(int dimensions, int dimensionSize, bool outputStateSpace, bool stochastic, int batchSize) {
     
     struct FuncInfo {
         SpaceFunctionType func;
@@ -101,11 +96,12 @@ void runAllFunctions(int dimensions, int dimensionSize, bool outputStateSpace, b
     #include <chrono>
     for (double percent : queryPercents) {
         for (const auto& f : funcs) {
-            int totalArea = 1;
-            for (int d = 0; d < dimensions; ++d) totalArea *= dimensionSize;
-            int queries = std::max(1, static_cast<int>(totalArea * percent));
+            long long totalArea = StateSpace::cell_count(dimensions, dimensionSize);
+            // clamp before narrowing, the models count queries in an int
+            double wanted = std::min(totalArea * percent, (double)std::numeric_limits<int>::max());
+            int queries = std::max(1, static_cast<int>(wanted));
             auto start = std::chrono::high_resolution_clock::now();
-            PerfResult r = runPerfTest(dimensions, dimensionSize, outputStateSpace, stochastic, queries, f.func, f.name);
+            PerfResult r = runPerfTest(dimensions, dimensionSize, outputStateSpace, stochastic, queries, batchSize, f.func, f.name);
             auto end = std::chrono::high_resolution_clock::now();
             double duration = std::chrono::duration<double>(end - start).count();
             std::cout << "| " << std::setw(16) << f.name << " | "
@@ -163,7 +159,7 @@ void runAllFunctions(int dimensions, int dimensionSize, bool outputStateSpace, b
 int main(int argc, char* argv[]) {
     if (argc < 3) {
         std::cerr << "Usage: " << argv[0] 
-                  << " <dimensions> <dimensionSize> [--output shouldOutput] [--rand testStochastic]\n";
+                  << " <dimensions> <dimensionSize> [--output shouldOutput] [--rand testStochastic] [--batch queriesPerRoundTrip] [--threads reconstructionThreads]\n";
         return 1;
     }
 
@@ -176,9 +172,20 @@ int main(int argc, char* argv[]) {
 
     bool outputStateSpace = false;
     bool stochastic = false;
+    int batchSize = 1;
 
     for (int i = 3; i < argc; i++){
         std::string opt = argv[i];
+        if (opt == "--batch" && i + 1 < argc){
+            batchSize = std::max(1, std::atoi(argv[++i]));
+            continue;
+        }
+
+        if (opt == "--threads" && i + 1 < argc){
+            StateSpaceIO::set_threads(std::max(1, std::atoi(argv[++i])));
+            continue;
+        }
+
         if (opt == "--output" && i + 1 < argc){
             opt = argv[i+1];
             if (opt == "1" || opt == "true" || opt == "yes") {
@@ -195,5 +202,5 @@ int main(int argc, char* argv[]) {
         }
     }
     testfunctions::dimSize = dimensionSize;
-    runAllFunctions(dimensions, dimensionSize, outputStateSpace, stochastic);
+    runAllFunctions(dimensions, dimensionSize, outputStateSpace, stochastic, batchSize);
 }
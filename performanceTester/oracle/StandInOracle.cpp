@@ -0,0 +1,40 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+/**
+ * Stand-in for a simulator speaking the command line protocol: reads one comma separated
+ * query per line from stdin and answers each with a smooth value in [0, 1] after a fixed
+ * delay. Exits when stdin closes.
+ *
+ *   sep25_oracle [--latency-us perQuery]
+ */
+int main(int argc, char* argv[]) {
+    long long latency = 0;
+    for (int i = 1; i < argc; i++)
+        if (std::string(argv[i]) == "--latency-us" && i + 1 < argc) latency = std::atoll(argv[++i]);
+
+    std::cout.precision(17);
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (line.empty()) continue;
+
+        std::istringstream coords(line);
+        std::string coord;
+        double sum = 0.0;
+        int count = 0;
+        while (std::getline(coords, coord, ',')) {
+            sum += std::cos(0.2 * std::atoi(coord.c_str()));
+            count++;
+        }
+
+        if (latency > 0) std::this_thread::sleep_for(std::chrono::microseconds(latency));
+        std::cout << 0.5 + 0.5 * sum / std::max(count, 1) << std::endl;
+    }
+    return 0;
+}
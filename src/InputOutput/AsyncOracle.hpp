@@ -0,0 +1,32 @@
+/**
+ * @file AsyncOracle.hpp
+ * @brief Declares AsyncOracle, an oracle that can have several queries outstanding at once.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef ASYNC_ORACLE_H
+#define ASYNC_ORACLE_H
+
+#include <utility>
+#include <vector>
+
+#include "../StateSpace/Coordinates.hpp"
+
+class AsyncOracle {
+public:
+    virtual ~AsyncOracle() = default;
+
+    /**
+     * @brief Hand query to the oracle under id and return without waiting for its result.
+     */
+    virtual void submit(long long id, const Coordinates &query) = 0;
+
+    /**
+     * @brief Block until a submitted query completes, returning its id and result.
+     * Results may arrive in any order.
+     */
+    virtual std::pair<long long, double> wait_next() = 0;
+};
+
+#endif // ASYNC_ORACLE_H
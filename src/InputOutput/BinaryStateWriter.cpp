@@ -0,0 +1,202 @@
+/**
+ * @file BinaryStateWriter.cpp
+ * @brief Implements BinaryStateWriter, which writes a reconstructed state space as raw little-endian values.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "BinaryStateWriter.hpp"
+#include "../StateSpace/CellCodec.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+    #define MASS_HAVE_MMAP 1
+#endif
+
+// values are converted in blocks of this many before being handed to a stream
+static constexpr std::size_t STREAM_BLOCK = 8192;
+
+template <typename T>
+static void store_le(unsigned char* dst, T value) {
+    static_assert(std::is_integral_v<T>);
+    for (std::size_t i = 0; i < sizeof(T); ++i)
+        dst[i] = static_cast<unsigned char>(static_cast<std::uint64_t>(value) >> (8 * i));
+}
+
+std::size_t BinaryStateWriter::element_size(DataType type) {
+    switch (type) {
+        case FLOAT64: return sizeof(double);
+        case FLOAT32: return sizeof(float);
+        case BFLOAT16:
+        case FLOAT16:
+        case UNORM16: return sizeof(std::uint16_t);
+    }
+    throw std::invalid_argument("Unknown binary data type");
+}
+
+void BinaryStateWriter::encode_header(unsigned char* out, int dimensions, int dimensionSize, DataType type) {
+    std::uint64_t cells = 1;
+    for (int i = 0; i < dimensions; ++i) cells *= static_cast<std::uint64_t>(dimensionSize);
+
+    std::memcpy(out, "MASS", 4);
+    store_le<std::uint32_t>(out + 4, VERSION);
+    store_le<std::uint32_t>(out + 8, type);
+    store_le<std::uint32_t>(out + 12, static_cast<std::uint32_t>(dimensions));
+    store_le<std::uint64_t>(out + 16, static_cast<std::uint64_t>(dimensionSize));
+    store_le<std::uint64_t>(out + 24, cells);
+}
+
+BinaryStateWriter::BinaryStateWriter(const std::string& path, int dimensions, int dimensionSize, DataType type)
+    : type(type), cellCount(1)
+{
+    for (int i = 0; i < dimensions; ++i) cellCount *= static_cast<std::uint64_t>(dimensionSize);
+
+    unsigned char header[HEADER_SIZE];
+    encode_header(header, dimensions, dimensionSize, type);
+
+    if (map_file(path)) {
+        std::memcpy(mapped, header, HEADER_SIZE);
+        return;
+    }
+
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+        throw std::runtime_error("Failed to open " + path);
+    out = &file;
+    out->write(reinterpret_cast<const char*>(header), HEADER_SIZE);
+}
+
+BinaryStateWriter::BinaryStateWriter(std::ostream& out, int dimensions, int dimensionSize, DataType type)
+    : type(type), cellCount(1), out(&out)
+{
+    for (int i = 0; i < dimensions; ++i) cellCount *= static_cast<std::uint64_t>(dimensionSize);
+
+    unsigned char header[HEADER_SIZE];
+    encode_header(header, dimensions, dimensionSize, type);
+    out.write(reinterpret_cast<const char*>(header), HEADER_SIZE);
+}
+
+BinaryStateWriter::~BinaryStateWriter() {
+    // close() reports short writes, the destructor only releases resources
+    unmap();
+    if (out) out->flush();
+}
+
+// converted a block at a time through the vectorised codecs, then copied out little-endian
+template <typename Cell>
+static void encode_le(unsigned char* dst, const double* values, std::size_t count) {
+    using Bits = std::conditional_t<sizeof(Cell) == 8, std::uint64_t,
+                 std::conditional_t<sizeof(Cell) == 4, std::uint32_t, std::uint16_t>>;
+    Cell block[1024];
+    for (std::size_t done = 0; done < count; done += 1024) {
+        std::size_t n = std::min<std::size_t>(1024, count - done);
+        encode_cells(values + done, block, n);
+        if constexpr (std::endian::native == std::endian::little) {
+            std::memcpy(dst + done * sizeof(Cell), block, n * sizeof(Cell));
+        } else {
+            for (std::size_t i = 0; i < n; ++i)
+                store_le<Bits>(dst + (done + i) * sizeof(Cell), std::bit_cast<Bits>(block[i]));
+        }
+    }
+}
+
+void BinaryStateWriter::encode_values(unsigned char* dst, const double* values, std::size_t count) const {
+    switch (type) {
+        case FLOAT64:
+            if constexpr (std::endian::native == std::endian::little)
+                std::memcpy(dst, values, count * sizeof(double));
+            else
+                encode_le<double>(dst, values, count);
+            return;
+        case FLOAT32: encode_le<float>(dst, values, count); return;
+        case BFLOAT16: encode_le<BFloat16>(dst, values, count); return;
+        case FLOAT16: encode_le<Half>(dst, values, count); return;
+        case UNORM16: encode_le<UNorm16>(dst, values, count); return;
+    }
+}
+
+void BinaryStateWriter::write(const double* values, std::size_t count) {
+    if (closed)
+        throw std::logic_error("BinaryStateWriter used after close");
+    if (written + count > cellCount)
+        throw std::out_of_range("More values written than the state space holds");
+
+    const std::size_t elem = element_size(type);
+
+    if (mapped) {
+        encode_values(mapped + HEADER_SIZE + written * elem, values, count);
+        written += count;
+        return;
+    }
+
+    scratch.resize(std::min(count, STREAM_BLOCK) * elem);
+    for (std::size_t done = 0; done < count; done += STREAM_BLOCK) {
+        std::size_t n = std::min(STREAM_BLOCK, count - done);
+        encode_values(scratch.data(), values + done, n);
+        out->write(reinterpret_cast<const char*>(scratch.data()), n * elem);
+    }
+    written += count;
+}
+
+void BinaryStateWriter::close() {
+    if (closed) return;
+    closed = true;
+
+    unmap();
+    if (out) {
+        out->flush();
+        if (!*out) throw std::runtime_error("Failed writing binary state space");
+    }
+    if (file.is_open()) file.close();
+
+    if (written != cellCount)
+        throw std::runtime_error("Binary state space closed after " + std::to_string(written) +
+                                 " of " + std::to_string(cellCount) + " values");
+}
+
+bool BinaryStateWriter::map_file(const std::string& path) {
+#ifdef MASS_HAVE_MMAP
+    const std::size_t total = HEADER_SIZE + cellCount * element_size(type);
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    if (::ftruncate(fd, static_cast<off_t>(total)) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* region = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping keeps the file alive
+    if (region == MAP_FAILED) return false;
+
+    // values are written front to back exactly once
+    ::madvise(region, total, MADV_SEQUENTIAL);
+
+    mapped = static_cast<unsigned char*>(region);
+    mappedSize = total;
+    return true;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+void BinaryStateWriter::unmap() {
+#ifdef MASS_HAVE_MMAP
+    if (mapped) {
+        ::munmap(mapped, mappedSize);
+        mapped = nullptr;
+        mappedSize = 0;
+    }
+#endif
+}
@@ -0,0 +1,88 @@
+/**
+ * @file BinaryStateWriter.hpp
+ * @brief Declares BinaryStateWriter, which writes a reconstructed state space as raw little-endian values.
+ *
+ * Layout of the output, every field little-endian:
+ *   bytes  0-3   magic "MASS"
+ *   bytes  4-7   uint32 format version
+ *   bytes  8-11  uint32 data type (BinaryStateWriter::DataType)
+ *   bytes 12-15  uint32 dimensions
+ *   bytes 16-23  uint64 dimension size
+ *   bytes 24-31  uint64 number of values that follow
+ *   bytes 32-    values in row-major order (last coordinate fastest)
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef BINARY_STATE_WRITER_H
+#define BINARY_STATE_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class BinaryStateWriter {
+public:
+    /**
+     * @brief Element types, the 16-bit ones are the cell types of CellCodec.hpp:
+     * BFLOAT16 and FLOAT16 hold the top half of a float and an IEEE binary16, UNORM16 holds
+     * round(clamp(value, 0, 1) * 65535).
+     */
+    enum DataType : std::uint32_t { FLOAT64 = 0, FLOAT32 = 1, BFLOAT16 = 2, FLOAT16 = 3, UNORM16 = 4 };
+
+    static constexpr std::uint32_t VERSION = 1;
+    static constexpr std::size_t HEADER_SIZE = 32;
+
+    /**
+     * @brief Write to a file. Where the platform supports it the file is sized up front and
+     * memory-mapped so values are stored straight into the mapping.
+     */
+    BinaryStateWriter(const std::string& path, int dimensions, int dimensionSize, DataType type);
+
+    /**
+     * @brief Write to an already open binary stream, e.g. stdout.
+     */
+    BinaryStateWriter(std::ostream& out, int dimensions, int dimensionSize, DataType type);
+
+    ~BinaryStateWriter();
+
+    BinaryStateWriter(const BinaryStateWriter&) = delete;
+    BinaryStateWriter& operator=(const BinaryStateWriter&) = delete;
+
+    /**
+     * @brief Append the next count values of the state space.
+     */
+    void write(const double* values, std::size_t count);
+
+    /**
+     * @brief Flush and release the output, throws if fewer values than cells were written.
+     */
+    void close();
+
+    static std::size_t element_size(DataType type);
+    static void encode_header(unsigned char* out, int dimensions, int dimensionSize, DataType type);
+
+private:
+    DataType type;
+    std::uint64_t cellCount;
+    std::uint64_t written = 0;
+    bool closed = false;
+
+    // stream output
+    std::ofstream file;
+    std::ostream* out = nullptr;
+    std::vector<unsigned char> scratch;
+
+    // memory-mapped output
+    unsigned char* mapped = nullptr;
+    std::size_t mappedSize = 0;
+
+    void encode_values(unsigned char* dst, const double* values, std::size_t count) const;
+    bool map_file(const std::string& path);
+    void unmap();
+};
+
+#endif // BINARY_STATE_WRITER_H
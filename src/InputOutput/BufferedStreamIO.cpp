@@ -0,0 +1,210 @@
+/**
+ * @file BufferedStreamIO.cpp
+ * @brief Implements BufferedStreamIO, the command line protocol over raw file descriptors with reusable buffers.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "BufferedStreamIO.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+    #include <fcntl.h>
+    #include <io.h>
+    #include <sys/stat.h>
+    static long long raw_read(int fd, char *buffer, std::size_t bytes) { return ::_read(fd, buffer, (unsigned)bytes); }
+    static long long raw_write(int fd, const char *buffer, std::size_t bytes) { return ::_write(fd, buffer, (unsigned)bytes); }
+    static int raw_create(const char *path) { return ::_open(path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE); }
+    static int raw_close(int fd) { return ::_close(fd); }
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    static long long raw_read(int fd, char *buffer, std::size_t bytes) { return ::read(fd, buffer, bytes); }
+    static long long raw_write(int fd, const char *buffer, std::size_t bytes) { return ::write(fd, buffer, bytes); }
+    static int raw_create(const char *path) { return ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644); }
+    static int raw_close(int fd) { return ::close(fd); }
+#endif
+
+// longest int or %g double text plus a separator
+static constexpr std::size_t MAX_FIELD = 32;
+
+static bool is_separator(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+void BufferedStreamIO::set_IO(){
+    if (instance == nullptr)
+        instance = new BufferedStreamIO;
+}
+
+BufferedStreamIO::BufferedStreamIO(int inputFd, int outputFd)
+    : inputFd(inputFd), outputFd(outputFd), out(BUFFER_SIZE), in(BUFFER_SIZE) {}
+
+BufferedStreamIO::~BufferedStreamIO() {
+    try {
+        flush();
+    } catch (const std::exception&) {
+        // the oracle is gone, nothing left to tell it
+    }
+}
+
+void BufferedStreamIO::flush() {
+    std::size_t written = 0;
+    while (written < outUsed) {
+        long long n = raw_write(outputFd, out.data() + written, outUsed - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            outUsed = 0;
+            throw std::runtime_error("Failed to write to the oracle");
+        }
+        written += n;
+    }
+    outUsed = 0;
+}
+
+void BufferedStreamIO::reserve_out(std::size_t bytes) {
+    if (out.size() - outUsed < bytes) flush();
+}
+
+void BufferedStreamIO::write_query(const Coordinates &query) {
+    for (std::size_t i = 0; i < query.size(); i++) {
+        reserve_out(MAX_FIELD);
+        char *end = std::to_chars(out.data() + outUsed, out.data() + out.size(), query[i]).ptr;
+        *end++ = (i == query.size() - 1) ? '\n' : ',';
+        outUsed = end - out.data();
+    }
+}
+
+void BufferedStreamIO::fill() {
+    // about to block on the oracle, so it must have every query we owe it
+    flush();
+
+    if (inBegin > 0) {
+        std::memmove(in.data(), in.data() + inBegin, inEnd - inBegin);
+        inEnd -= inBegin;
+        inBegin = 0;
+    }
+    if (inEnd == in.size())
+        throw std::runtime_error("Oracle result longer than the read buffer");
+
+    long long n;
+    do {
+        n = raw_read(inputFd, in.data() + inEnd, in.size() - inEnd);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0)
+        throw std::runtime_error("Failed to read from the oracle");
+    if (n == 0) inputClosed = true;
+    inEnd += n;
+}
+
+double BufferedStreamIO::read_result() {
+    for (;;) {
+        while (inBegin < inEnd && is_separator(in[inBegin])) inBegin++;
+
+        // a result is complete once a separator follows it, or the oracle has closed its end
+        std::size_t tokenEnd = inBegin;
+        while (tokenEnd < inEnd && !is_separator(in[tokenEnd])) tokenEnd++;
+
+        if (inBegin < tokenEnd && (tokenEnd < inEnd || inputClosed)) {
+            const char *first = in.data() + inBegin;
+            const char *last = in.data() + tokenEnd;
+            if (*first == '+') first++; // from_chars takes no explicit plus, operator>> does
+            double result;
+            auto [ptr, ec] = std::from_chars(first, last, result);
+            if (ec != std::errc() || ptr != last)
+                throw std::runtime_error("Malformed oracle result \"" + std::string(in.data() + inBegin, tokenEnd - inBegin) + "\"");
+            inBegin = tokenEnd;
+            return result;
+        }
+        if (inputClosed)
+            throw std::runtime_error("Oracle closed its output with results outstanding");
+        fill();
+    }
+}
+
+double BufferedStreamIO::send_query_recieve_result(const Coordinates &query){
+    write_query(query);
+    return read_result();
+}
+
+std::vector<double> BufferedStreamIO::send_queries_recieve_results(const std::vector<Coordinates> &queries){
+    for (const auto& query : queries)
+        write_query(query);
+
+    std::vector<double> results(queries.size());
+    for (auto& result : results)
+        result = read_result();
+    return results;
+}
+
+void BufferedStreamIO::submit(long long id, const Coordinates &query){
+    write_query(query);
+    submitted.push_back(id);
+}
+
+std::pair<long long, double> BufferedStreamIO::wait_next(){
+    if (submitted.empty())
+        throw std::logic_error("No query waiting for a result");
+
+    double result = read_result();
+    long long id = submitted.front();
+    submitted.pop_front();
+    return {id, result};
+}
+
+void BufferedStreamIO::output_state(Model &model){
+    flush();
+    if (outputFormat != TEXT) {
+        output_state_binary(model);
+        return;
+    }
+
+    if (outputPath.empty()) {
+        write_state_text(model);
+        return;
+    }
+
+    // the text goes through the same buffer, flushed into the output file instead of to the oracle
+    int fileFd = raw_create(outputPath.c_str());
+    if (fileFd < 0) throw std::runtime_error("Failed to open output file " + outputPath);
+    const int oracleFd = outputFd;
+    outputFd = fileFd;
+    try {
+        write_state_text(model);
+    } catch (...) {
+        outUsed = 0;
+        outputFd = oracleFd;
+        raw_close(fileFd);
+        throw;
+    }
+    outputFd = oracleFd;
+    if (raw_close(fileFd) != 0) throw std::runtime_error("Failed to write the state space output");
+}
+
+void BufferedStreamIO::write_state_text(Model &model){
+    long long maxIdx = model.cell_count();
+
+    // same text as operator<< on a default stream, six significant digits
+    const long long blockSize = output_block();
+    std::vector<double> block(std::min(maxIdx, blockSize));
+    for (long long begin = 0; begin < maxIdx; begin += blockSize) {
+        long long end = std::min(maxIdx, begin + blockSize);
+        evaluate_block(model, begin, end, block.data());
+        for (long long i = begin; i < end; i++) {
+            reserve_out(MAX_FIELD);
+            char *next = out.data() + outUsed;
+            if (i > 0) *next++ = ' ';
+            next = std::to_chars(next, out.data() + out.size(), block[i - begin], std::chars_format::general, 6).ptr;
+            outUsed = next - out.data();
+        }
+    }
+    reserve_out(1);
+    out[outUsed++] = '\n';
+    flush();
+}
@@ -0,0 +1,71 @@
+/**
+ * @file BufferedStreamIO.hpp
+ * @brief Declares BufferedStreamIO, the command line protocol over raw file descriptors with reusable buffers.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef BUFFERED_STREAM_IO_H
+#define BUFFERED_STREAM_IO_H
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+#include "CommandLineInputOutput.hpp"
+
+/**
+ * @brief Speaks the same protocol as CommandLineInputOutput, but bypasses iostreams: queries are
+ * formatted with std::to_chars into one reusable write buffer and results are parsed with
+ * std::from_chars out of one large read buffer, so a round trip allocates nothing.
+ *
+ * Written queries stay in the buffer until a result is needed that has not been read yet, so
+ * several submitted queries go out in a single write. Text output_state produces the same bytes
+ * as CommandLineInputOutput, the binary formats are written by CommandLineInputOutput.
+ */
+class BufferedStreamIO : public CommandLineInputOutput {
+public:
+    static constexpr std::size_t BUFFER_SIZE = 1 << 16;
+
+    /**
+     * @brief Read results from inputFd and write queries to outputFd, stdin/stdout by default.
+     * The descriptors are not closed.
+     */
+    BufferedStreamIO(int inputFd = 0, int outputFd = 1);
+    ~BufferedStreamIO() override;
+
+    static void set_IO();
+
+    double send_query_recieve_result(const Coordinates &query) override;
+    std::vector<double> send_queries_recieve_results(const std::vector<Coordinates> &queries) override;
+    void output_state(Model &model) override;
+    void submit(long long id, const Coordinates &query) override;
+    std::pair<long long, double> wait_next() override;
+
+    /**
+     * @brief Write out everything buffered so far.
+     */
+    void flush();
+
+private:
+    int inputFd;
+    int outputFd;
+
+    std::vector<char> out;
+    std::size_t outUsed = 0;
+
+    std::vector<char> in;
+    std::size_t inBegin = 0; // first unparsed byte
+    std::size_t inEnd = 0;   // one past the last byte read
+    bool inputClosed = false;
+
+    std::deque<long long> submitted; // ids of queries written but not answered, oldest first
+
+    void write_query(const Coordinates &query);
+    void write_state_text(Model &model);
+    void reserve_out(std::size_t bytes);
+    double read_result();
+    void fill();
+};
+
+#endif // BUFFERED_STREAM_IO_H
@@ -10,18 +10,44 @@
  */
 #include <iostream>
 #include "CommandLineInputOutput.hpp"
+#include "BinaryStateWriter.hpp"
+#include "../StateSpace/ArrayStateSpace.hpp"
+#include <bit>
 #include <cmath>
+#include <memory>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef _WIN32
+    #include <fcntl.h>
+    #include <io.h>
+    #include <cstdio>
+#endif
+
+CommandLineInputOutput::OutputFormat CommandLineInputOutput::outputFormat = CommandLineInputOutput::TEXT;
+std::string CommandLineInputOutput::outputPath = "";
 
 void CommandLineInputOutput::set_IO(){
     if (instance == nullptr)
         instance = new CommandLineInputOutput;
 }
 
-double CommandLineInputOutput::send_query_recieve_result(const std::vector<int> &query){
+void CommandLineInputOutput::set_output_format(OutputFormat format, const std::string& path){
+    outputFormat = format;
+    outputPath = path;
+}
 
-    // output query to the CL
-    for (int i = 0; i < query.size(); i++)
+// one query per line, coordinates separated by commas
+static void write_query(const Coordinates &query){
+    for (size_t i = 0; i < query.size(); i++)
         std::cout << query[i] << ((i == query.size()-1) ? "\n" : ",");
+}
+
+double CommandLineInputOutput::send_query_recieve_result(const Coordinates &query){
+
+    // output query to the CL
+    write_query(query);
 
     double result;
     std::cin >> result;
@@ -29,19 +55,112 @@ double CommandLineInputOutput::send_query_recieve_result(const std::vector<int>
     return result;
 }
 
+std::vector<double> CommandLineInputOutput::send_queries_recieve_results(const std::vector<Coordinates> &queries){
+
+    // output the whole block before waiting on any result
+    for (const auto& query : queries)
+        write_query(query);
+    std::cout.flush();
+
+    // one result per query, in the order the queries were written
+    std::vector<double> results(queries.size());
+    for (auto& result : results)
+        std::cin >> result;
+
+    return results;
+}
+
+void CommandLineInputOutput::submit(long long id, const Coordinates &query){
+    write_query(query);
+    std::cout.flush();
+    submitted.push_back(id);
+}
+
+std::pair<long long, double> CommandLineInputOutput::wait_next(){
+    if (submitted.empty())
+        throw std::logic_error("No query waiting for a result");
+
+    // results come back in the order the queries were written
+    double result;
+    std::cin >> result;
+    long long id = submitted.front();
+    submitted.pop_front();
+    return {id, result};
+}
+
 void CommandLineInputOutput::output_state(Model &model){
+    if (outputFormat != TEXT) {
+        output_state_binary(model);
+        return;
+    }
+
+    long long maxIdx = model.cell_count();
+
+    std::ofstream file;
+    if (!outputPath.empty()) {
+        file.open(outputPath);
+        if (!file) throw std::runtime_error("Failed to open output file " + outputPath);
+    }
+    std::ostream& out = outputPath.empty() ? std::cout : file;
+
+    const long long blockSize = output_block();
+    std::vector<double> block(std::min(maxIdx, blockSize));
+    for (long long begin = 0; begin < maxIdx; begin += blockSize) {
+        long long end = std::min(maxIdx, begin + blockSize);
+        evaluate_block(model, begin, end, block.data());
+        for (long long i = begin; i < end; i++) {
+            if (i > 0) out << " ";
+            out << block[i - begin];
+        }
+    }
+    out << std::endl;
+    if (!out) throw std::runtime_error("Failed to write the state space output");
+}
+
+void CommandLineInputOutput::output_state_binary(Model &model){
     int dimensions = model.get_dimensions();
     int dimensionSize = model.get_dimensionSize();
+    BinaryStateWriter::DataType type = BinaryStateWriter::FLOAT64;
+    switch (outputFormat) {
+        case BINARY_F32: type = BinaryStateWriter::FLOAT32; break;
+        case BINARY_BF16: type = BinaryStateWriter::BFLOAT16; break;
+        case BINARY_F16: type = BinaryStateWriter::FLOAT16; break;
+        case BINARY_U16: type = BinaryStateWriter::UNORM16; break;
+        default: break;
+    }
 
-    long long maxIdx = 1;
-    for (int i = 0; i < dimensions; ++i)
-        maxIdx *= dimensionSize;
+    long long maxIdx = model.cell_count();
+
+    // f64 files are the native layout of a file-backed ArrayStateSpace, the model evaluates
+    // straight into the mapped output with no block copies
+    if (type == BinaryStateWriter::FLOAT64 && !outputPath.empty() && std::endian::native == std::endian::little) {
+        ArrayStateSpace grid(dimensions, dimensionSize, outputPath, ArrayStateSpace::SEQUENTIAL);
+        double* cells = grid.raw_view().data();
+        const long long blockSize = output_block();
+        for (long long begin = 0; begin < maxIdx; begin += blockSize)
+            evaluate_block(model, begin, std::min(maxIdx, begin + blockSize), cells + begin);
+        grid.flush();
+        return;
+    }
+
+    std::unique_ptr<BinaryStateWriter> writer;
+    if (outputPath.empty()) {
+        std::cout.flush();
+#ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY); // no newline translation inside the values
+#endif
+        writer = std::make_unique<BinaryStateWriter>(std::cout, dimensions, dimensionSize, type);
+    } else {
+        writer = std::make_unique<BinaryStateWriter>(outputPath, dimensions, dimensionSize, type);
+    }
 
-    auto coords = index_to_coords(0, dimensions, dimensionSize);
-    std::cout << model.get_value_at(coords);
-    for (long long i = 1; i < maxIdx; i++) {
-        coords = index_to_coords(i, dimensions, dimensionSize);
-        std::cout << " " << model.get_value_at(coords);
+    // predictions are evaluated in blocks and handed over without any formatting
+    const long long blockSize = output_block();
+    std::vector<double> block(std::min(maxIdx, blockSize));
+    for (long long begin = 0; begin < maxIdx; begin += blockSize) {
+        long long end = std::min(maxIdx, begin + blockSize);
+        evaluate_block(model, begin, end, block.data());
+        writer->write(block.data(), end - begin);
     }
-    std::cout << std::endl;
+    writer->close();
 }
\ No newline at end of file
@@ -11,15 +11,47 @@
 #ifndef COMMAND_LINE_IO_H
 #define COMMAND_LINE_IO_H
 #include <vector>
+#include <string>
+#include <deque>
 
 #include "InputOutput.hpp"
+#include "AsyncOracle.hpp"
+
+/**
+ * @brief Queries are written to stdout as comma separated coordinates, one per line, and
+ * results are read from stdin in the same order. As an AsyncOracle each query is flushed as
+ * soon as it is submitted, so the oracle can work on it while the model picks the next one.
+ */
+class CommandLineInputOutput : public InputOutput, public AsyncOracle {
+public:
+    /**
+     * @brief How output_state writes the reconstructed state space.
+     * TEXT is space separated values, the binary formats are described in BinaryStateWriter.hpp.
+     * Either goes to outputPath when it is set, otherwise to stdout.
+     */
+    enum OutputFormat { TEXT, BINARY_F64, BINARY_F32, BINARY_BF16, BINARY_F16, BINARY_U16 };
+
+private:
+    std::deque<long long> submitted; // ids of queries written but not answered, oldest first
+
+protected:
+    static OutputFormat outputFormat;
+    static std::string outputPath;
 
-class CommandLineInputOutput : public InputOutput {
     CommandLineInputOutput() = default;
+    void output_state_binary(Model &model);
 public:
-    double send_query_recieve_result(const std::vector<int> &query) override;
+    double send_query_recieve_result(const Coordinates &query) override;
+    std::vector<double> send_queries_recieve_results(const std::vector<Coordinates> &queries) override;
     void output_state(Model &model) override;
+    void submit(long long id, const Coordinates &query) override;
+    std::pair<long long, double> wait_next() override;
     static void set_IO();
+
+    /**
+     * @brief Select the output_state format, binary output goes to path or to stdout if path is empty
+     */
+    static void set_output_format(OutputFormat format, const std::string& path = "");
 };
 
 #endif // COMMAND_LINE_IO_H
\ No newline at end of file
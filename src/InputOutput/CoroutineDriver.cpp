@@ -0,0 +1,64 @@
+/**
+ * @file CoroutineDriver.cpp
+ * @brief Implements CoroutineDriver, which runs a model's query loop with several queries in flight.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "CoroutineDriver.hpp"
+#include "InputOutput.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+CoroutineDriver::CoroutineDriver(AsyncOracle &oracle, int inFlight)
+    : oracle(oracle), inFlight(std::max(1, inFlight)) {}
+
+QueryCoroutine CoroutineDriver::model_queries(Model &model, int totalQueries, int inFlight) {
+    // a model restored from a snapshot already holds some results
+    int sent = model.answered_queries(), received = sent;
+    while (received < totalQueries) {
+        while (sent < totalQueries && sent - received < inFlight) {
+            co_yield model.get_next_query();
+            ++sent;
+        }
+
+        QueryCoroutine::Completion done = co_await QueryCoroutine::next_result();
+        int answeredBefore = model.answered_queries();
+        model.update_prediction(done.query, done.result);
+        InputOutput::checkpoint(model, answeredBefore);
+        ++received;
+    }
+}
+
+void CoroutineDriver::run(Model &model, int totalQueries) {
+    QueryCoroutine task = model_queries(model, totalQueries, inFlight);
+    auto &promise = task.promise();
+
+    std::unordered_map<long long, Coordinates> outstanding;
+    long long nextId = 0;
+
+    task.resume();
+    while (!task.done()) {
+        if (promise.query) {
+            oracle.submit(nextId, *promise.query);
+            outstanding.emplace(nextId++, std::move(*promise.query));
+            promise.query.reset();
+        } else if (promise.awaitingResult) {
+            if (outstanding.empty())
+                throw std::logic_error("Model awaited a result with no query in flight");
+
+            auto [id, result] = oracle.wait_next();
+            auto it = outstanding.find(id);
+            if (it == outstanding.end())
+                throw std::runtime_error("Oracle returned a result for unknown query " + std::to_string(id));
+            promise.completion = QueryCoroutine::Completion{std::move(it->second), result};
+            outstanding.erase(it);
+        }
+        task.resume();
+    }
+
+    if (promise.error) std::rethrow_exception(promise.error);
+}
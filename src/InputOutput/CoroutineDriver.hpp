@@ -0,0 +1,42 @@
+/**
+ * @file CoroutineDriver.hpp
+ * @brief Declares CoroutineDriver, which runs a model's query loop with several queries in flight.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef COROUTINE_DRIVER_H
+#define COROUTINE_DRIVER_H
+
+#include "AsyncOracle.hpp"
+#include "QueryCoroutine.hpp"
+#include "../Models/Model.hpp"
+
+/**
+ * @brief Schedules a model's QueryCoroutine against an AsyncOracle.
+ *
+ * Up to inFlight queries are outstanding at once, so the model picks its next query and
+ * ingests results while the oracle is still working on earlier ones. With inFlight = 1
+ * this is the synchronous loop of InputOutput::run_queries.
+ */
+class CoroutineDriver {
+public:
+    CoroutineDriver(AsyncOracle &oracle, int inFlight);
+
+    /**
+     * @brief Ask totalQueries queries of the model and feed back every result.
+     */
+    void run(Model &model, int totalQueries);
+
+    /**
+     * @brief The model's side of the exchange: keeps inFlight queries outstanding and
+     * updates the model with each result in completion order.
+     */
+    static QueryCoroutine model_queries(Model &model, int totalQueries, int inFlight);
+
+private:
+    AsyncOracle &oracle;
+    int inFlight;
+};
+
+#endif // COROUTINE_DRIVER_H
@@ -1,16 +1,29 @@
 #include "InputOutput.hpp"
+#include "ParallelEvaluator.hpp"
 
 #include <stdexcept>
+#include <algorithm>
 
 InputOutput* InputOutput::instance = nullptr;
+int InputOutput::threads = 1;
+std::string InputOutput::checkpointPath = "";
+int InputOutput::checkpointEvery = 0;
 
 InputOutput::InputOutput() {
     if (instance == nullptr)
         instance = this;
 }
 
-std::vector<int> InputOutput::index_to_coords(int index, int dimensions, int dimensionSize) {
-    std::vector<int> coords(dimensions);
+InputOutput::~InputOutput() {
+    if (instance == this)
+        instance = nullptr;
+}
+
+Coordinates InputOutput::index_to_coords(long long index, int dimensions, int dimensionSize) {
+    if (index < 0) {
+        throw std::out_of_range("negative cell index");
+    }
+    Coordinates coords(dimensions);
     for (int d = dimensions - 1; d >= 0; --d) {
         coords[d] = index % dimensionSize;
         index /= dimensionSize;
@@ -21,6 +34,71 @@ std::vector<int> InputOutput::index_to_coords(int index, int dimensions, int dim
     return coords;
 }
 
+void InputOutput::set_threads(int threads) {
+    if (threads < 1)
+        throw std::invalid_argument("thread count must be at least 1");
+    InputOutput::threads = threads;
+}
+
+void InputOutput::set_checkpoint(const std::string &path, int everyResults) {
+    if (!path.empty() && everyResults < 1)
+        throw std::invalid_argument("checkpoint interval must be at least 1");
+    checkpointPath = path;
+    checkpointEvery = everyResults;
+}
+
+void InputOutput::checkpoint(const Model &model, int answeredBefore) {
+    if (checkpointPath.empty()) return;
+    if (answeredBefore >= 0 && model.answered_queries() / checkpointEvery <= answeredBefore / checkpointEvery)
+        return;
+    model.save_snapshot(checkpointPath);
+}
+
+long long InputOutput::output_block() {
+    // a few chunks per thread so stealing can even out uneven cells
+    return threads == 1 ? OUTPUT_BLOCK : OUTPUT_BLOCK * threads * 16;
+}
+
+void InputOutput::evaluate_block(Model &model, long long begin, long long end, double *out) {
+    if (threads == 1) {
+        model.evaluate_range(begin, end, out);
+        return;
+    }
+    ParallelEvaluator(threads).evaluate(model, begin, end, out);
+}
+
+std::vector<double> InputOutput::send_queries_recieve_results(const std::vector<Coordinates> &queries) {
+    std::vector<double> results;
+    results.reserve(queries.size());
+    for (const auto& query : queries)
+        results.push_back(send_query_recieve_result(query));
+    return results;
+}
+
+void InputOutput::run_queries(Model &model, int totalQueries, int batchSize) {
+    batchSize = std::max(1, batchSize);
+
+    if (batchSize == 1) {
+        for (int i = model.answered_queries(); i < totalQueries; i++) {
+            Coordinates query = model.get_next_query();
+            double result = send_query_recieve_result(query);
+            int answeredBefore = model.answered_queries();
+            model.update_prediction(query, result);
+            checkpoint(model, answeredBefore);
+        }
+        return;
+    }
+
+    for (int sent = model.answered_queries(); sent < totalQueries; sent += batchSize) {
+        int count = std::min(batchSize, totalQueries - sent);
+        std::vector<Coordinates> queries = model.get_next_queries(count);
+        std::vector<double> results = send_queries_recieve_results(queries);
+        int answeredBefore = model.answered_queries();
+        model.update_predictions(queries, results);
+        checkpoint(model, answeredBefore);
+    }
+}
+
 InputOutput* InputOutput::get_instance(){ 
     if (instance == nullptr){
         throw std::runtime_error("IO instance is null - must be set before usage");
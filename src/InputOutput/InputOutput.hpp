@@ -11,17 +11,69 @@
 #ifndef INPUT_OUTPUT_H
 #define INPUT_OUTPUT_H
 #include <vector>
+#include <string>
 #include "../Models/Model.hpp"
 
 class InputOutput {
 protected:
     static InputOutput* instance;
     InputOutput();
+
+    // cells evaluated per block when writing out the state space, per thread
+    static constexpr long long OUTPUT_BLOCK = 4096;
+
+    // threads used to reconstruct the state space in output_state
+    static int threads;
+
+    // snapshot written every checkpointEvery results, none if checkpointPath is empty
+    static std::string checkpointPath;
+    static int checkpointEvery;
+
+    /**
+     * @brief Cells per block of output_state, large enough to keep every thread busy.
+     */
+    static long long output_block();
+
+    /**
+     * @brief Evaluate the cells [begin, end) of the model into out, on `threads` threads.
+     */
+    static void evaluate_block(Model &model, long long begin, long long end, double *out);
 public:
-    virtual double send_query_recieve_result(const std::vector<int> &query) = 0;
+    virtual ~InputOutput();
+
+    virtual double send_query_recieve_result(const Coordinates &query) = 0;
     virtual void output_state(Model &model) = 0;
 
-    static std::vector<int> index_to_coords(int index, int dimensions, int dimensionSize);
+    /**
+     * @brief Send a block of queries and receive one result per query, in query order.
+     * Defaults to one round trip per query.
+     */
+    virtual std::vector<double> send_queries_recieve_results(const std::vector<Coordinates> &queries);
+
+    /**
+     * @brief Drive the query loop of a model, batchSize queries per round trip. A model
+     * restored from a snapshot continues from the results it already has.
+     */
+    void run_queries(Model &model, int totalQueries, int batchSize = 1);
+
+    /**
+     * @brief Set the number of threads output_state reconstructs the state space with.
+     */
+    static void set_threads(int threads);
+
+    /**
+     * @brief Have the query loops snapshot the model to path every everyResults results.
+     * An empty path turns checkpoints off.
+     */
+    static void set_checkpoint(const std::string &path, int everyResults);
+
+    /**
+     * @brief Snapshot the model if a checkpoint is due since it had answeredBefore results.
+     * Query loops call this after each update, answeredBefore = -1 writes one regardless.
+     */
+    static void checkpoint(const Model &model, int answeredBefore);
+
+    static Coordinates index_to_coords(long long index, int dimensions, int dimensionSize);
     static InputOutput* get_instance();
 };
 
@@ -0,0 +1,90 @@
+/**
+ * @file MpscQueue.hpp
+ * @brief Declares MpscQueue, an unbounded lock-free multi-producer single-consumer queue.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <utility>
+
+/**
+ * @brief Linked list queue in the style of Vyukov's MPSC queue: producers swap themselves in
+ * at the head with a single exchange, the one consumer walks the list from the tail. Only
+ * pop() may block, it sleeps on an atomic counter rather than a mutex.
+ */
+template <typename T>
+class MpscQueue {
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        T value{};
+    };
+
+    std::atomic<Node*> head;       // last pushed node, producers
+    Node* tail;                    // already consumed node before the next value, consumer only
+    std::atomic<std::uint32_t> available{0};
+
+public:
+    MpscQueue() : tail(new Node) { head.store(tail, std::memory_order_relaxed); }
+
+    ~MpscQueue() {
+        while (tail) {
+            Node* next = tail->next.load(std::memory_order_relaxed);
+            delete tail;
+            tail = next;
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    /**
+     * @brief Safe to call from any number of threads at once.
+     */
+    void push(T value) {
+        Node* node = new Node;
+        node->value = std::move(value);
+        Node* prev = head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+
+        available.fetch_add(1, std::memory_order_release);
+        available.notify_one();
+    }
+
+    /**
+     * @brief Consumer only. Returns false if nothing is ready.
+     */
+    bool try_pop(T& out) {
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (!next) return false;
+
+        out = std::move(next->value);
+        delete tail;
+        tail = next;
+        available.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Consumer only. Blocks until a value is pushed.
+     */
+    T pop() {
+        T out;
+        while (!try_pop(out)) {
+            std::uint32_t count = available.load(std::memory_order_acquire);
+            if (count == 0)
+                available.wait(0, std::memory_order_acquire);
+            else
+                std::this_thread::yield(); // a producer is between its exchange and link
+        }
+        return out;
+    }
+};
+
+#endif // MPSC_QUEUE_H
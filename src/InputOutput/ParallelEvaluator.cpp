@@ -0,0 +1,133 @@
+/**
+ * @file ParallelEvaluator.cpp
+ * @brief Implements ParallelEvaluator, which reconstructs a range of the state space on several threads.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "ParallelEvaluator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief The chunks [front, back) still owned by one thread. Both ends are packed into a
+ * single word so the owner (front) and thieves (back) claim chunks with one CAS, lock-free.
+ */
+class ChunkRange {
+private:
+    std::atomic<std::uint64_t> range{0};
+
+    static std::uint64_t pack(std::uint32_t front, std::uint32_t back) {
+        return (static_cast<std::uint64_t>(front) << 32) | back;
+    }
+
+public:
+    void reset(std::uint32_t front, std::uint32_t back) {
+        range.store(pack(front, back), std::memory_order_relaxed);
+    }
+
+    bool take_front(std::uint32_t &chunk) {
+        std::uint64_t current = range.load(std::memory_order_relaxed);
+        for (;;) {
+            std::uint32_t front = current >> 32, back = static_cast<std::uint32_t>(current);
+            if (front >= back) return false;
+            if (range.compare_exchange_weak(current, pack(front + 1, back), std::memory_order_relaxed)) {
+                chunk = front;
+                return true;
+            }
+        }
+    }
+
+    bool steal_back(std::uint32_t &chunk) {
+        std::uint64_t current = range.load(std::memory_order_relaxed);
+        for (;;) {
+            std::uint32_t front = current >> 32, back = static_cast<std::uint32_t>(current);
+            if (front >= back) return false;
+            if (range.compare_exchange_weak(current, pack(front, back - 1), std::memory_order_relaxed)) {
+                chunk = back - 1;
+                return true;
+            }
+        }
+    }
+};
+
+} // namespace
+
+ParallelEvaluator::ParallelEvaluator(int threads, long long chunkSize)
+    : threads(std::max(1, threads)), chunkSize(std::max(1LL, chunkSize)) {}
+
+void ParallelEvaluator::evaluate(Model &model, long long begin, long long end, double *out) const {
+    if (end <= begin) return;
+
+    // chunk indices must fit the packed 32-bit halves of a ChunkRange
+    long long chunk = chunkSize;
+    const long long maxChunks = std::numeric_limits<std::uint32_t>::max();
+    if ((end - begin + chunk - 1) / chunk > maxChunks)
+        chunk = (end - begin + maxChunks - 1) / maxChunks;
+    const long long chunkCount = (end - begin + chunk - 1) / chunk;
+
+    const int workers = static_cast<int>(std::min<long long>(threads, chunkCount));
+    if (workers <= 1) {
+        model.evaluate_range(begin, end, out);
+        return;
+    }
+
+    std::vector<ChunkRange> shares(workers);
+    for (int t = 0; t < workers; ++t)
+        shares[t].reset(static_cast<std::uint32_t>(chunkCount * t / workers),
+                        static_cast<std::uint32_t>(chunkCount * (t + 1) / workers));
+
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto run_chunk = [&](std::uint32_t c) {
+        long long from = begin + c * chunk;
+        long long to = std::min(end, from + chunk);
+        model.evaluate_range(from, to, out + (from - begin));
+    };
+
+    auto work = [&](int self) {
+        try {
+            std::uint32_t c;
+            while (!failed.load(std::memory_order_relaxed) && shares[self].take_front(c))
+                run_chunk(c);
+
+            // own share done, steal from the others until a full pass finds nothing
+            bool stole = true;
+            while (stole && !failed.load(std::memory_order_relaxed)) {
+                stole = false;
+                for (int i = 1; i < workers; ++i) {
+                    if (shares[(self + i) % workers].steal_back(c)) {
+                        run_chunk(c);
+                        stole = true;
+                        break;
+                    }
+                }
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) error = std::current_exception();
+            failed.store(true, std::memory_order_relaxed);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (int t = 1; t < workers; ++t)
+        pool.emplace_back(work, t);
+    work(0);
+    for (auto &thread : pool)
+        thread.join();
+
+    if (error) std::rethrow_exception(error);
+}
@@ -0,0 +1,42 @@
+/**
+ * @file ParallelEvaluator.hpp
+ * @brief Declares ParallelEvaluator, which reconstructs a range of the state space on several threads.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef PARALLEL_EVALUATOR_H
+#define PARALLEL_EVALUATOR_H
+
+#include "../Models/Model.hpp"
+
+/**
+ * @brief Splits a range of cells into chunks and evaluates them with Model::evaluate_range on
+ * a fixed number of threads.
+ *
+ * Every thread starts with an equal, contiguous share of the chunks and works through it from
+ * the front. A thread that runs out steals single chunks from the back of another thread's
+ * share, so cells that are expensive to predict do not leave the other threads idle. Each cell
+ * is written exactly once and evaluate_range agrees with get_value_at, so the result does not
+ * depend on the thread count.
+ */
+class ParallelEvaluator {
+public:
+    static constexpr long long DEFAULT_CHUNK = 1024;
+
+    explicit ParallelEvaluator(int threads, long long chunkSize = DEFAULT_CHUNK);
+
+    /**
+     * @brief Fill out[0 .. end-begin) with the values of the cells in [begin, end).
+     * Rethrows the first exception raised by any thread.
+     */
+    void evaluate(Model &model, long long begin, long long end, double *out) const;
+
+    int get_threads() const { return threads; }
+
+private:
+    int threads;
+    long long chunkSize;
+};
+
+#endif // PARALLEL_EVALUATOR_H
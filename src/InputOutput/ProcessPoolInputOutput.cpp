@@ -0,0 +1,221 @@
+/**
+ * @file ProcessPoolInputOutput.cpp
+ * @brief Implements ProcessPoolInputOutput, which sends queries to several local oracle processes at once.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "ProcessPoolInputOutput.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <csignal>
+    #include <fcntl.h>
+    #include <sys/wait.h>
+    #include <unistd.h>
+    #define MASS_HAVE_PROCESSES 1
+#endif
+
+void ProcessPoolInputOutput::set_IO(const std::vector<std::string> &command, int processes){
+    if (instance == nullptr)
+        instance = new ProcessPoolInputOutput(command, processes);
+}
+
+#ifdef MASS_HAVE_PROCESSES
+
+static void make_pipe(int fds[2]) {
+    if (::pipe(fds) != 0)
+        throw std::runtime_error("Failed to create oracle pipe");
+    // only the ends dup'ed onto a child's stdin/stdout survive exec
+    ::fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    ::fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+}
+
+ProcessPoolInputOutput::ProcessPoolInputOutput(const std::vector<std::string> &command, int processes) {
+    if (command.empty())
+        throw std::invalid_argument("No oracle command given");
+    if (processes < 1)
+        throw std::invalid_argument("Oracle pool needs at least one process");
+    workers = std::vector<Worker>(processes); // reader threads hold on to their slot
+
+    // a dead oracle shows up as a failed write instead of killing us
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::vector<char*> argv;
+    for (const auto &arg : command) argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    for (int w = 0; w < processes; ++w) {
+        int toChild[2] = {-1, -1}, fromChild[2] = {-1, -1};
+        try {
+            make_pipe(toChild);
+            make_pipe(fromChild);
+
+            pid_t pid = ::fork();
+            if (pid < 0)
+                throw std::runtime_error("Failed to start oracle process");
+            if (pid == 0) {
+                ::dup2(toChild[0], STDIN_FILENO);
+                ::dup2(fromChild[1], STDOUT_FILENO);
+                ::execvp(argv[0], argv.data());
+                ::_exit(127);
+            }
+
+            ::close(toChild[0]);
+            ::close(fromChild[1]);
+            toChild[0] = fromChild[1] = -1;
+            // the worker owns the remaining ends from here, shutdown closes them
+            workers[w].pid = pid;
+            workers[w].toChild = toChild[1];
+            workers[w].fromChild = fromChild[0];
+            toChild[1] = fromChild[0] = -1;
+            workers[w].reader = std::thread(&ProcessPoolInputOutput::read_results, this, w);
+            idle.push_back(w);
+        } catch (...) {
+            // the earlier workers' reader threads must be joined before the exception leaves
+            for (int fd : {toChild[0], toChild[1], fromChild[0], fromChild[1]})
+                if (fd >= 0) ::close(fd);
+            shutdown();
+            throw;
+        }
+    }
+}
+
+ProcessPoolInputOutput::~ProcessPoolInputOutput() {
+    shutdown();
+}
+
+void ProcessPoolInputOutput::shutdown() {
+    // closing stdin tells each oracle to exit, which ends its reader thread
+    for (auto &worker : workers) {
+        if (worker.toChild >= 0) ::close(worker.toChild);
+        worker.toChild = -1;
+    }
+    for (auto &worker : workers) {
+        if (worker.reader.joinable()) worker.reader.join();
+        if (worker.fromChild >= 0) ::close(worker.fromChild);
+        worker.fromChild = -1;
+        if (worker.pid > 0) ::waitpid(static_cast<pid_t>(worker.pid), nullptr, 0);
+        worker.pid = -1;
+    }
+}
+
+void ProcessPoolInputOutput::read_results(int worker) {
+    const int fd = workers[worker].fromChild;
+    std::string pending;
+    char buffer[4096];
+
+    for (;;) {
+        ssize_t n = ::read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+
+        pending.append(buffer, n);
+        std::size_t start = 0, end;
+        while ((end = pending.find('\n', start)) != std::string::npos) {
+            std::string line = pending.substr(start, end - start);
+            start = end + 1;
+            if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+            completed.push({worker, std::strtod(line.c_str(), nullptr), false});
+        }
+        pending.erase(0, start);
+    }
+
+    completed.push({worker, 0, true});
+}
+
+void ProcessPoolInputOutput::dispatch(int worker, long long id, const Coordinates &query) {
+    std::string line;
+    for (std::size_t i = 0; i < query.size(); i++) {
+        line += std::to_string(query[i]);
+        line += (i == query.size() - 1) ? '\n' : ',';
+    }
+
+    const char *data = line.data();
+    std::size_t left = line.size();
+    while (left > 0) {
+        ssize_t n = ::write(workers[worker].toChild, data, left);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) throw std::runtime_error("Oracle process " + std::to_string(worker) + " stopped reading queries");
+        data += n;
+        left -= n;
+    }
+    workers[worker].busyWith = id;
+}
+
+#else
+
+ProcessPoolInputOutput::ProcessPoolInputOutput(const std::vector<std::string> &, int) {
+    throw std::runtime_error("Oracle process pools are not supported on this platform");
+}
+
+ProcessPoolInputOutput::~ProcessPoolInputOutput() = default;
+
+void ProcessPoolInputOutput::shutdown() {}
+
+void ProcessPoolInputOutput::read_results(int) {}
+
+void ProcessPoolInputOutput::dispatch(int, long long, const Coordinates &) {}
+
+#endif // MASS_HAVE_PROCESSES
+
+void ProcessPoolInputOutput::submit(long long id, const Coordinates &query) {
+    ++outstanding;
+    if (idle.empty()) {
+        waiting.emplace_back(id, query);
+        return;
+    }
+    int worker = idle.front();
+    idle.pop_front();
+    dispatch(worker, id, query);
+}
+
+std::pair<long long, double> ProcessPoolInputOutput::wait_next() {
+    if (outstanding == 0)
+        throw std::logic_error("No query waiting for a result");
+
+    Completion done = completed.pop();
+    Worker &worker = workers[done.worker];
+    if (done.failed || worker.busyWith < 0)
+        throw std::runtime_error("Oracle process " + std::to_string(done.worker) + " exited or answered without a query");
+
+    long long id = worker.busyWith;
+    worker.busyWith = -1;
+    --outstanding;
+
+    // keep the process busy with the oldest query still waiting
+    if (!waiting.empty()) {
+        auto next = std::move(waiting.front());
+        waiting.pop_front();
+        dispatch(done.worker, next.first, next.second);
+    } else {
+        idle.push_back(done.worker);
+    }
+    return {id, done.result};
+}
+
+double ProcessPoolInputOutput::send_query_recieve_result(const Coordinates &query) {
+    if (outstanding != 0)
+        throw std::logic_error("Synchronous query while asynchronous queries are in flight");
+    submit(nextId++, query);
+    return wait_next().second;
+}
+
+std::vector<double> ProcessPoolInputOutput::send_queries_recieve_results(const std::vector<Coordinates> &queries) {
+    if (outstanding != 0)
+        throw std::logic_error("Synchronous query while asynchronous queries are in flight");
+
+    const long long first = nextId;
+    for (const auto &query : queries)
+        submit(nextId++, query);
+
+    std::vector<double> results(queries.size());
+    for (std::size_t i = 0; i < queries.size(); i++) {
+        auto [id, result] = wait_next();
+        results[id - first] = result;
+    }
+    return results;
+}
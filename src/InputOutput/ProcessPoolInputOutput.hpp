@@ -0,0 +1,74 @@
+/**
+ * @file ProcessPoolInputOutput.hpp
+ * @brief Declares ProcessPoolInputOutput, which sends queries to several local oracle processes at once.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef PROCESS_POOL_IO_H
+#define PROCESS_POOL_IO_H
+
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CommandLineInputOutput.hpp"
+#include "MpscQueue.hpp"
+
+/**
+ * @brief Launches N copies of an oracle command and talks to each over pipes with the
+ * command line protocol: one comma separated query per line on its stdin, one result per
+ * line on its stdout. An oracle must exit once its stdin is closed.
+ *
+ * Every process works on one query at a time. Submitted queries go to the first idle process
+ * or wait for one. A reader thread per process pushes results onto a lock-free queue, and
+ * wait_next hands them out in completion order. The state space is still written to stdout
+ * as by CommandLineInputOutput. Only available on POSIX systems.
+ */
+class ProcessPoolInputOutput : public CommandLineInputOutput {
+public:
+    ProcessPoolInputOutput(const std::vector<std::string> &command, int processes);
+    ~ProcessPoolInputOutput() override;
+
+    static void set_IO(const std::vector<std::string> &command, int processes);
+
+    double send_query_recieve_result(const Coordinates &query) override;
+
+    /**
+     * @brief Spread the block over every process, results are returned in query order.
+     */
+    std::vector<double> send_queries_recieve_results(const std::vector<Coordinates> &queries) override;
+
+    void submit(long long id, const Coordinates &query) override;
+    std::pair<long long, double> wait_next() override;
+
+    int get_processes() const { return (int)workers.size(); }
+
+private:
+    struct Worker {
+        long pid = -1;
+        int toChild = -1, fromChild = -1;
+        long long busyWith = -1; // id of the query being evaluated, -1 when idle
+        std::thread reader;
+    };
+
+    struct Completion {
+        int worker = -1;
+        double result = 0;
+        bool failed = false; // the process closed its output
+    };
+
+    std::vector<Worker> workers;
+    std::deque<int> idle;
+    std::deque<std::pair<long long, Coordinates>> waiting; // submitted, no process free yet
+    MpscQueue<Completion> completed;
+    long long outstanding = 0;
+    long long nextId = 0; // ids for the synchronous calls
+
+    void dispatch(int worker, long long id, const Coordinates &query);
+    void read_results(int worker);
+    void shutdown();
+};
+
+#endif // PROCESS_POOL_IO_H
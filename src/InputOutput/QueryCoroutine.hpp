@@ -0,0 +1,89 @@
+/**
+ * @file QueryCoroutine.hpp
+ * @brief Declares QueryCoroutine, the coroutine type through which a model trades queries for results.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef QUERY_COROUTINE_H
+#define QUERY_COROUTINE_H
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "../StateSpace/Coordinates.hpp"
+
+/**
+ * @brief The model side co_yields every query it wants answered and co_awaits
+ * QueryCoroutine::next_result() when it needs a result, receiving whichever outstanding
+ * query completed first. Whoever resumes the coroutine services the yield or await it
+ * stopped on, see CoroutineDriver.
+ */
+class QueryCoroutine {
+public:
+    struct Completion {
+        Coordinates query;
+        double result;
+    };
+
+    struct promise_type {
+        std::optional<Coordinates> query;  // set while suspended on co_yield
+        std::optional<Completion> completion;   // filled in before an await is resumed
+        bool awaitingResult = false;
+        std::exception_ptr error;
+
+        QueryCoroutine get_return_object() {
+            return QueryCoroutine(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(Coordinates next) {
+            query = std::move(next);
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    struct ResultAwaiter {
+        promise_type *promise = nullptr;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<promise_type> waiting) noexcept {
+            promise = &waiting.promise();
+            promise->awaitingResult = true;
+        }
+        Completion await_resume() {
+            promise->awaitingResult = false;
+            Completion done = std::move(*promise->completion);
+            promise->completion.reset();
+            return done;
+        }
+    };
+
+    /**
+     * @brief co_await this for the next completed query.
+     */
+    static ResultAwaiter next_result() { return {}; }
+
+    QueryCoroutine(QueryCoroutine &&other) noexcept : handle(std::exchange(other.handle, {})) {}
+    QueryCoroutine(const QueryCoroutine &) = delete;
+    QueryCoroutine &operator=(const QueryCoroutine &) = delete;
+    ~QueryCoroutine() {
+        if (handle) handle.destroy();
+    }
+
+    bool done() const { return handle.done(); }
+    void resume() { handle.resume(); }
+    promise_type &promise() { return handle.promise(); }
+
+private:
+    explicit QueryCoroutine(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+#endif // QUERY_COROUTINE_H
@@ -15,20 +15,20 @@
 
 #include "DumbModel.hpp"
 
-DumbModel::DumbModel(int dimensions, int dimensionSize, int totalQueries) : 
-    Model(dimensions, dimensionSize, totalQueries), stateSpace(new ArrayStateSpace(dimensions, dimensionSize)) {
+DumbModel::DumbModel(int dimensions, int dimensionSize, int totalQueries, const DenseStorage& storage) : 
+    Model(dimensions, dimensionSize, totalQueries), stateSpace(make_dense_state_space(dimensions, dimensionSize, storage)) {
     std::srand(std::time(nullptr));
 }
 
-std::vector<int> DumbModel::get_next_query() {
+Coordinates DumbModel::get_next_query() {
     return {0,0,0};
 }
 
-void DumbModel::update_prediction(const std::vector<int> &query, double result) {
+void DumbModel::update_prediction(const Coordinates &query, double result) {
     return;
 }
 
-double DumbModel::get_value_at(const std::vector<int> &query) {
+double DumbModel::get_value_at(const Coordinates &query) {
     return 0.335;
 }
 
@@ -2,8 +2,10 @@
 #ifndef DUMB_MODEL_H
 #define DUMB_MODEL_H
 
+#include <memory>
+
 #include "Model.hpp"
-#include "../StateSpace/ArrayStateSpace.hpp"
+#include "../StateSpace/ArrayStateSpaceN.hpp"
 
 /**
  * @brief The DumbModel is merely for testing the client - It 
@@ -11,12 +13,12 @@
  * 
  */
 class DumbModel : public Model {
-    ArrayStateSpace* stateSpace;
+    std::unique_ptr<DenseStateSpace> stateSpace;
 public:
-    DumbModel(int dimensions, int dimensionSize, int totalQueries);
-    std::vector<int> get_next_query() override;
-    void update_prediction(const std::vector<int> &query, double result) override;
-    double get_value_at(const std::vector<int> &query) override;
+    DumbModel(int dimensions, int dimensionSize, int totalQueries, const DenseStorage& storage = {});
+    Coordinates get_next_query() override;
+    void update_prediction(const Coordinates &query, double result) override;
+    double get_value_at(const Coordinates &query) override;
 };
 
 
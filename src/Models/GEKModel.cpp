@@ -2,6 +2,8 @@
 #include "GEKModel.hpp"
 #include <iostream>
 #include <stdexcept>
+#include <algorithm>
+#include <string>
 
 GEKModel::GEKModel(int dimensions, int dimensionSize, int totalQueries) :
     Model(dimensions, dimensionSize, totalQueries),
@@ -21,26 +23,42 @@ GEKModel::~GEKModel() {
     if (mapping) delete mapping;
 }
 
-std::vector<int> GEKModel::get_next_query() {
+Coordinates GEKModel::get_next_query() {
     currentQuery++;
     return queryTree->get_next_query();
 }
 
-void GEKModel::update_prediction(const std::vector<int> &query, double result) {
+void GEKModel::update_prediction(const Coordinates &query, double result) {
     queryTree->update_prediction(query, result);
     data.emplace_back(result, query);
     
     // Create/recreate the mapping when we've collected all queries
-    if (currentQuery == totalQueries) {
-        if (mapping) delete mapping;
-        mapping = new GEKMapping(data, dimensions, dimensionSize, use_local_neighborhood, local_k);
-        if (!periodic_dims.empty()) {
-            mapping->set_periodic_dimensions(periodic_dims);
-        }
+    if (++answeredQueries == totalQueries) {
+        build_mapping();
     }
 }
 
-double GEKModel::get_value_at(const std::vector<int>& query) {
+void GEKModel::update_predictions(const std::vector<Coordinates> &queries, const std::vector<double> &results) {
+    queryTree->update_predictions(queries, results);
+    data.reserve(data.size() + queries.size());
+    for (size_t i = 0; i < queries.size(); ++i)
+        data.emplace_back(results[i], queries[i]);
+
+    answeredQueries += queries.size();
+    if (answeredQueries == totalQueries) {
+        build_mapping();
+    }
+}
+
+void GEKModel::build_mapping() {
+    if (mapping) delete mapping;
+    mapping = new GEKMapping(data, dimensions, dimensionSize, use_local_neighborhood, local_k);
+    if (!periodic_dims.empty()) {
+        mapping->set_periodic_dimensions(periodic_dims);
+    }
+}
+
+double GEKModel::get_value_at(const Coordinates& query) {
     if (mapping) {
         return mapping->predict(query);
     }
@@ -48,6 +66,11 @@ double GEKModel::get_value_at(const std::vector<int>& query) {
     return 0.0;
 }
 
+void GEKModel::evaluate_range(long long begin, long long end, double* out) {
+    if (mapping) mapping->predict_range(begin, end, dimensions, dimensionSize, out);
+    else std::fill(out, out + (end - begin), 0.0);
+}
+
 void GEKModel::set_periodic_dimensions(const std::vector<bool>& periodic) {
     if ((int)periodic.size() != dimensions) {
         throw std::invalid_argument("periodic dimensions vector size mismatch");
@@ -58,4 +81,30 @@ void GEKModel::set_periodic_dimensions(const std::vector<bool>& periodic) {
     }
 }
 
+void GEKModel::save_state(SnapshotWriter& out) const {
+    out.tag("GEKModel");
+    out.points(data, dimensions);
+    out.integers(std::vector<int>(periodic_dims.begin(), periodic_dims.end()));
+    out.integer(mapping ? 1 : 0);
+    if (mapping) mapping->save_state(out);
+}
+
+void GEKModel::load_state(SnapshotReader& in) {
+    in.expect("GEKModel");
+    data = in.points(dimensions);
+    if ((int)data.size() != answeredQueries)
+        throw std::runtime_error("Snapshot holds " + std::to_string(data.size()) + " results for " +
+                                 std::to_string(answeredQueries) + " answered queries");
+    std::vector<int> periodic = in.integers();
+    periodic_dims.assign(periodic.begin(), periodic.end());
+
+    if (in.integer() != 0)
+        mapping = new GEKMapping(data, dimensions, dimensionSize, use_local_neighborhood, local_k, in);
+
+    // the tree is only needed to pick further queries
+    if (answeredQueries < totalQueries)
+        for (const auto& [result, query] : data)
+            queryTree->update_prediction(query, result);
+}
+
 #endif // GEK || TESTING
@@ -19,9 +19,11 @@ public:
     GEKModel(int dimensions, int dimensionSize, int totalQueries);
     ~GEKModel();
     
-    std::vector<int> get_next_query() override;
-    void update_prediction(const std::vector<int> &query, double result) override;
-    double get_value_at(const std::vector<int> &query) override;
+    Coordinates get_next_query() override;
+    void update_prediction(const Coordinates &query, double result) override;
+    double get_value_at(const Coordinates &query) override;
+    void evaluate_range(long long begin, long long end, double* out) override;
+    void update_predictions(const std::vector<Coordinates> &queries, const std::vector<double> &results) override;
     
     /**
      * @brief Configure which dimensions have periodic boundary conditions
@@ -30,14 +32,22 @@ public:
      */
     void set_periodic_dimensions(const std::vector<bool>& periodic);
 
+    bool supports_snapshots() const override { return true; }
+
+protected:
+    void save_state(SnapshotWriter& out) const override;
+    void load_state(SnapshotReader& in) override;
+
 private:
     QueryTree* queryTree;
     GEKMapping* mapping;
-    std::vector<std::pair<double, std::vector<int>>> data;
+    std::vector<std::pair<double, Coordinates>> data;
     int leafSize;
     bool use_local_neighborhood;
     int local_k;
     std::vector<bool> periodic_dims;
+
+    void build_mapping();
 };
 
 #endif //GEK_MODEL_H
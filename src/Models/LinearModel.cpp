@@ -5,19 +5,19 @@
 
 #include "LinearModel.hpp"
 
-LinearModel::LinearModel(int dimensions, int dimensionSize, int totalQueries) : 
-    Model(dimensions, dimensionSize, totalQueries), stateSpace(new ArrayStateSpace(dimensions, dimensionSize)) {
+LinearModel::LinearModel(int dimensions, int dimensionSize, int totalQueries, const DenseStorage& storage) : 
+    Model(dimensions, dimensionSize, totalQueries), stateSpace(make_dense_state_space(dimensions, dimensionSize, storage)) {
     std::srand(std::time(nullptr));
 }
 
-std::vector<int> LinearModel::get_next_query() {
+Coordinates LinearModel::get_next_query() {
     currentQuery++;
 
     static int traversed_ix = 0;
 
     int D = this->stateSpace->get_dimensions();
     int K = this->stateSpace->get_dimension_size();
-    std::vector<int> nextQuery(D, 0);
+    Coordinates nextQuery(D, 0);
 
     double step = ((double)(K-1))/(double)totalQueries;
     for (auto &var : nextQuery){
@@ -31,7 +31,7 @@ std::vector<int> LinearModel::get_next_query() {
     return nextQuery;
 }
 
-void print_statespace(ArrayStateSpace& stateSpace) {
+void print_statespace(DenseStateSpace& stateSpace) {
     std::vector<double> vec2Output = stateSpace.get_raw_representation();
     if (vec2Output.size() == 0) return;
     for (int i = 0; i < vec2Output.size(); i++)
@@ -94,7 +94,7 @@ int LinearModel::find_prev_nonzero_afterzero_ix(double ix) {
     return traversed_ix;
 }
 
-double LinearModel::get_value_at(const std::vector<int> &query) {
+double LinearModel::get_value_at(const Coordinates &query) {
     return this->stateSpace->get(query);
 }
 
@@ -143,9 +143,9 @@ void LinearModel::update_prediction_final() {
 
 }
 
-void LinearModel::update_prediction(const std::vector<int> &query, double result) {
+void LinearModel::update_prediction(const Coordinates &query, double result) {
     stateSpace->set(query, result);
-    if (currentQuery == totalQueries)
+    if (++answeredQueries == totalQueries)
         update_prediction_final();
 }
 
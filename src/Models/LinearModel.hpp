@@ -2,16 +2,18 @@
 #ifndef LINEAR_MODEL_H
 #define LINEAR_MODEL_H
 
+#include <memory>
+
 #include "Model.hpp"
-#include "../StateSpace/ArrayStateSpace.hpp"
+#include "../StateSpace/ArrayStateSpaceN.hpp"
 
 class LinearModel : public Model {
-    ArrayStateSpace* stateSpace;
+    std::unique_ptr<DenseStateSpace> stateSpace;
 public:
-    LinearModel(int dimensions, int dimensionSize, int totalQueries);
-    std::vector<int> get_next_query() override;
-    void update_prediction(const std::vector<int> &query, double result) override;
-    double get_value_at(const std::vector<int> &query) override;
+    LinearModel(int dimensions, int dimensionSize, int totalQueries, const DenseStorage& storage = {});
+    Coordinates get_next_query() override;
+    void update_prediction(const Coordinates &query, double result) override;
+    double get_value_at(const Coordinates &query) override;
 private:
     void update_prediction_final();
     int find_next_nonzero_ix(double ix);
@@ -5,10 +5,11 @@
 #include <limits>
 #include <stdexcept>
 
-// Helper function to select indices of the k nearest observed points (squared Euclidean distance)
+// Helper function to select indices of the k nearest observed points (squared Euclidean distance).
+// Ties go to the lower index and the result is sorted, so equal neighbourhoods compare equal.
 static std::vector<int> select_k_nearest_indices_helper(
-    const std::vector<std::pair<double, std::vector<int>>>& observed,
-    const std::vector<int>& query,
+    const std::vector<std::pair<double, Coordinates>>& observed,
+    const Coordinates& query,
     int k)
 {
     int n = (int)observed.size();
@@ -28,18 +29,18 @@ static std::vector<int> select_k_nearest_indices_helper(
         dists.push_back({d2, i});
     }
     
-    std::nth_element(dists.begin(), dists.begin() + k - 1, dists.end(),
-                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    std::nth_element(dists.begin(), dists.begin() + k - 1, dists.end());
     
     std::vector<int> out;
     out.reserve(k);
     for (int i = 0; i < k; ++i) {
         out.push_back(dists[i].second);
     }
+    std::sort(out.begin(), out.end());
     return out;
 }
 
-GEKMapping::GEKMapping(std::vector<std::pair<double, std::vector<int>>>& data,
+GEKMapping::GEKMapping(std::vector<std::pair<double, Coordinates>>& data,
                        int dimensions,
                        int dimensionSize,
                        bool use_local_neighborhood,
@@ -49,24 +50,78 @@ GEKMapping::GEKMapping(std::vector<std::pair<double, std::vector<int>>>& data,
       dimensionSize(dimensionSize),
       use_local_neighborhood(use_local_neighborhood),
       local_k(local_k),
-      periodic_dims(dimensions, false)
+      periodic_dims(dimensions, false),
+      pointSlots(dimensions, dimensionSize)
 {
-    // If not using local neighborhoods, train global model immediately
-    if (!use_local_neighborhood) {
+    index_points();
+    // Train the global model now if any prediction can take the global path, so that
+    // predictions never modify the mapping and may run concurrently
+    if (!use_local_neighborhood || (int)queriedPoints.size() <= local_k) {
         train();
     }
 }
 
+GEKMapping::GEKMapping(std::vector<std::pair<double, Coordinates>>& data,
+                       int dimensions,
+                       int dimensionSize,
+                       bool use_local_neighborhood,
+                       int local_k,
+                       SnapshotReader& trainedState)
+    : Mapping(data),
+      dimensions(dimensions),
+      dimensionSize(dimensionSize),
+      use_local_neighborhood(use_local_neighborhood),
+      local_k(local_k),
+      periodic_dims(dimensions, false),
+      pointSlots(dimensions, dimensionSize)
+{
+    index_points();
+    trainedState.expect("GEKMapping");
+    theta = trainedState.real();
+    std::vector<int> periodic = trainedState.integers();
+    if ((int)periodic.size() != dimensions)
+        throw std::runtime_error("Snapshot periodic dimensions do not match the mapping");
+    for (int d = 0; d < dimensions; ++d) periodic_dims[d] = periodic[d] != 0;
+
+    trained = trainedState.integer() != 0;
+    if (trained) {
+        int n = (int)queriedPoints.size();
+        std::vector<double> inverse = trainedState.reals();
+        std::vector<double> weights = trainedState.reals();
+        if ((long long)inverse.size() != (long long)n * n || (int)weights.size() != n)
+            throw std::runtime_error("Snapshot covariance does not match the data");
+        C_inv = Eigen::Map<Eigen::MatrixXd>(inverse.data(), n, n);
+        alpha_global = Eigen::Map<Eigen::VectorXd>(weights.data(), n);
+    }
+}
+
+void GEKMapping::save_state(SnapshotWriter& out) const {
+    out.tag("GEKMapping");
+    out.real(theta);
+    out.integers(std::vector<int>(periodic_dims.begin(), periodic_dims.end()));
+    out.integer(trained ? 1 : 0);
+    if (trained) {
+        out.reals(std::vector<double>(C_inv.data(), C_inv.data() + C_inv.size()));
+        out.reals(std::vector<double>(alpha_global.data(), alpha_global.data() + alpha_global.size()));
+    }
+}
+
+void GEKMapping::index_points() {
+    pointSlots.reserve(queriedPoints.size());
+    for (int i = 0; i < (int)queriedPoints.size(); ++i)
+        pointSlots.emplace(queriedPoints[i].second, i);
+}
+
 GEKMapping::~GEKMapping() {
     // Eigen matrices will clean up automatically
 }
 
-double GEKMapping::covariance(const std::vector<int>& x, const std::vector<int>& y) {
+double GEKMapping::covariance(const Coordinates& x, const Coordinates& y) const {
     double d2 = compute_periodic_distance_squared(x, y);
     return std::exp(-theta * d2);
 }
 
-double GEKMapping::compute_periodic_distance_squared(const std::vector<int>& x, const std::vector<int>& y) {
+double GEKMapping::compute_periodic_distance_squared(const Coordinates& x, const Coordinates& y) const {
     double d2 = 0.0;
     for (int d = 0; d < dimensions; ++d) {
         double diff = x[d] - y[d];
@@ -109,16 +164,22 @@ void GEKMapping::train() {
     
     // Invert using Eigen
     C_inv = C.inverse();
+
+    Eigen::VectorXd y(n);
+    for (int i = 0; i < n; ++i) {
+        y(i) = queriedPoints[i].first;
+    }
+    alpha_global = C_inv * y;
     trained = true;
 }
 
-std::vector<int> GEKMapping::select_k_nearest_indices(const std::vector<int>& query, int k) {
+std::vector<int> GEKMapping::select_k_nearest_indices(const Coordinates& query, int k) const {
     return select_k_nearest_indices_helper(queriedPoints, query, k);
 }
 
 void GEKMapping::build_local_cov_and_targets(const std::vector<int>& indices,
                                              Eigen::MatrixXd& C_loc,
-                                             Eigen::VectorXd& y_loc)
+                                             Eigen::VectorXd& y_loc) const
 {
     int m = (int)indices.size();
     C_loc = Eigen::MatrixXd(m, m);
@@ -137,26 +198,43 @@ void GEKMapping::build_local_cov_and_targets(const std::vector<int>& indices,
     }
 }
 
-double GEKMapping::predict(std::vector<int> query) {
+double GEKMapping::predict(const Coordinates& query) {
+    std::vector<int> indices;
+    Eigen::VectorXd alpha;
+    return predict_cell(query, indices, alpha);
+}
+
+void GEKMapping::predict_range(long long begin, long long end, int dimensions, int dimensionSize, double* out) {
+    std::vector<int> indices;
+    Eigen::VectorXd alpha;
+    GridOdometer cell(dimensions, dimensionSize, begin);
+    for (long long i = begin; i < end; ++i, cell.next())
+        *out++ = predict_cell(cell.coords(), indices, alpha);
+}
+
+double GEKMapping::predict_cell(const Coordinates& query, std::vector<int>& indices, Eigen::VectorXd& alpha) const {
     int n = (int)queriedPoints.size();
     if (n == 0) return 0.0;
     
     // Check if query is an exact match with an observed point
-    for (const auto& pt : queriedPoints) {
-        if (pt.second == query) {
-            return pt.first;
-        }
-    }
+    int exact = pointSlots.find(query);
+    if (exact != CellSlotMap::NONE) return queriedPoints[exact].first;
     
     // Use local neighborhood if configured and we have enough points
     if (use_local_neighborhood && n > local_k) {
-        std::vector<int> indices = select_k_nearest_indices(query, local_k);
-        int m = (int)indices.size();
+        std::vector<int> nearest = select_k_nearest_indices(query, local_k);
+        int m = (int)nearest.size();
         if (m == 0) return 0.0;
         
-        Eigen::MatrixXd C_loc;
-        Eigen::VectorXd y_loc;
-        build_local_cov_and_targets(indices, C_loc, y_loc);
+        if (nearest != indices) {
+            Eigen::MatrixXd C_loc;
+            Eigen::VectorXd y_loc;
+            build_local_cov_and_targets(nearest, C_loc, y_loc);
+            
+            // Solve local system: C_loc * alpha = y_loc
+            alpha = C_loc.colPivHouseholderQr().solve(y_loc);
+            indices = std::move(nearest);
+        }
         
         // Build covariance vector between query and local points
         Eigen::VectorXd k_vec(m);
@@ -165,19 +243,12 @@ double GEKMapping::predict(std::vector<int> query) {
             k_vec(i) = covariance(query, queriedPoints[idx].second);
         }
         
-        // Solve local system: C_loc * alpha = y_loc
-        Eigen::VectorXd alpha = C_loc.colPivHouseholderQr().solve(y_loc);
-        
         // Prediction: k_vec^T * alpha
         return k_vec.dot(alpha);
     }
     
     // Global prediction
-    if (!trained) {
-        train();
-    }
-    
-    if (!trained || n == 0) return 0.0;
+    if (!trained) return 0.0;
     
     // Build covariance vector
     Eigen::VectorXd k_vec(n);
@@ -185,17 +256,11 @@ double GEKMapping::predict(std::vector<int> query) {
         k_vec(i) = covariance(query, queriedPoints[i].second);
     }
     
-    // Build value vector
-    Eigen::VectorXd y(n);
-    for (int i = 0; i < n; ++i) {
-        y(i) = queriedPoints[i].first;
-    }
-    
     // Prediction: k_vec^T * C_inv * y
-    return k_vec.dot(C_inv * y);
+    return k_vec.dot(alpha_global);
 }
 
-double GEKMapping::get_variance(const std::vector<int>& query) {
+double GEKMapping::get_variance(const Coordinates& query) const {
     int n = (int)queriedPoints.size();
     if (n == 0) return 1.0;  // Maximum uncertainty when no data
     
@@ -221,10 +286,6 @@ double GEKMapping::get_variance(const std::vector<int>& query) {
     }
     
     // Global variance
-    if (!trained) {
-        const_cast<GEKMapping*>(this)->train();
-    }
-    
     if (!trained) return 1.0;
     
     Eigen::VectorXd k_vec(n);
@@ -3,6 +3,8 @@
 #define GEK_MAPPING_H
 
 #include "Mapping.hpp"
+#include "../Tools/Snapshot.hpp"
+#include "../../StateSpace/CellSlotMap.hpp"
 #include <vector>
 #include <Eigen/Dense>
 
@@ -23,21 +25,43 @@ public:
      * @param use_local_neighborhood Whether to use local neighborhoods for prediction
      * @param local_k Number of nearest neighbors to use for local solves
      */
-    GEKMapping(std::vector<std::pair<double, std::vector<int>>>& data,
+    GEKMapping(std::vector<std::pair<double, Coordinates>>& data,
                int dimensions,
                int dimensionSize,
                bool use_local_neighborhood = true,
                int local_k = 64);
     
+    /**
+     * @brief Restore a mapping stored with save_state without training it again.
+     */
+    GEKMapping(std::vector<std::pair<double, Coordinates>>& data,
+               int dimensions,
+               int dimensionSize,
+               bool use_local_neighborhood,
+               int local_k,
+               SnapshotReader& trainedState);
+
     ~GEKMapping() override;
+
+    /**
+     * @brief Write the trained state (covariance inverse and weights) for the restoring constructor.
+     */
+    void save_state(SnapshotWriter& out) const;
     
     /**
-     * @brief Predict the value at a given query point using GEK interpolation
+     * @brief Predict the value at a given query point using GEK interpolation.
+     * Does not modify the mapping, so several threads may predict at once.
      * 
      * @param query The coordinates to predict at
      * @return double The predicted value
      */
-    double predict(std::vector<int> query) override;
+    double predict(const Coordinates& query) override;
+
+    /**
+     * @brief Predict a block of cells. Neighbouring cells usually share the same local
+     * neighbourhood, whose solve is then reused instead of repeated.
+     */
+    void predict_range(long long begin, long long end, int dimensions, int dimensionSize, double* out) override;
     
     /**
      * @brief Configure which dimensions have periodic boundary conditions
@@ -52,7 +76,7 @@ public:
      * @param query The coordinates to evaluate uncertainty at
      * @return double The predicted variance
      */
-    double get_variance(const std::vector<int>& query);
+    double get_variance(const Coordinates& query) const;
 
 private:
     int dimensions;
@@ -61,37 +85,50 @@ private:
     bool use_local_neighborhood;
     int local_k;
     std::vector<bool> periodic_dims;
+    CellSlotMap pointSlots; // cell -> first queried point at it, for exact matches
     
     // Global covariance matrix inverse (for non-local mode)
     Eigen::MatrixXd C_inv;
+    Eigen::VectorXd alpha_global; // C_inv * y
     bool trained = false;
     
     /**
      * @brief Compute covariance between two points
      */
-    double covariance(const std::vector<int>& x, const std::vector<int>& y);
+    double covariance(const Coordinates& x, const Coordinates& y) const;
     
     /**
      * @brief Compute squared distance with periodic boundary handling
      */
-    double compute_periodic_distance_squared(const std::vector<int>& x, const std::vector<int>& y);
+    double compute_periodic_distance_squared(const Coordinates& x, const Coordinates& y) const;
     
+    /**
+     * @brief Fill pointSlots from queriedPoints
+     */
+    void index_points();
+
     /**
      * @brief Train the global covariance matrix (if not using local neighborhoods)
      */
     void train();
     
     /**
-     * @brief Select k nearest observed points to a query
+     * @brief Predict one cell. indices/alpha hold the last local neighbourhood and its solve,
+     * reused when the query's neighbourhood is the same.
+     */
+    double predict_cell(const Coordinates& query, std::vector<int>& indices, Eigen::VectorXd& alpha) const;
+
+    /**
+     * @brief Select k nearest observed points to a query, ascending by index
      */
-    std::vector<int> select_k_nearest_indices(const std::vector<int>& query, int k);
+    std::vector<int> select_k_nearest_indices(const Coordinates& query, int k) const;
     
     /**
      * @brief Build local covariance matrix and target vector
      */
     void build_local_cov_and_targets(const std::vector<int>& indices,
                                      Eigen::MatrixXd& C_loc,
-                                     Eigen::VectorXd& y_loc);
+                                     Eigen::VectorXd& y_loc) const;
 };
 
 #endif // GEK_MAPPING_H
@@ -1,7 +1,7 @@
 #include "IDW.hpp"
 
 
-IDW::IDW(std::vector<std::pair<double, std::vector<int>>>& data, int maxNeighbours, int power, double offset) : Mapping(data){
+IDW::IDW(std::vector<std::pair<double, Coordinates>>& data, int maxNeighbours, int power, double offset) : Mapping(data){
     this->knnTree = new KNNTree(this->queriedPoints);
     this->maxNeighbours = maxNeighbours;
     this->power = power;
@@ -12,18 +12,14 @@ IDW::~IDW(){
     delete knnTree;
 }
 
-double IDW::predict(std::vector<int> query) {
-    size_t dim = query.size();
+double IDW::weigh(const std::vector<KNNTree::Neighbour>& neighbours) const {
     float numerator = 0.0f;
     float denominator = 0.0f;
     const float EPS = 1e-6f; // avoid division by zero
 
-    std::vector<KNNTree::KDResult> relevantPoints = knnTree->getKNearest(query, this->maxNeighbours);
-    
-    for (const auto& pv : relevantPoints) {
-        const std::vector<int>& coords = pv.point;
-        
-        if (offset == 0 && (pv.distance < EPS || pv.point == query)) return pv.value;
+    for (const auto& pv : neighbours) {
+        // coordinates are integral so a zero distance is an exact hit
+        if (offset == 0 && pv.distance < EPS) return pv.value;
         
         float weight = 1;
         if (pv.distance > offset) weight = 1.0f / std::pow(pv.distance, this->power);
@@ -34,3 +30,28 @@ double IDW::predict(std::vector<int> query) {
     return numerator / denominator;
 }
 
+double IDW::predict(const Coordinates& query) {
+    std::vector<KNNTree::Neighbour> relevantPoints;
+    knnTree->getKNearest(query, this->maxNeighbours, relevantPoints);
+    return weigh(relevantPoints);
+}
+
+void IDW::predict_range(long long begin, long long end, int dimensions, int dimensionSize, double* out) {
+    std::vector<KNNTree::Neighbour> relevantPoints;
+    relevantPoints.reserve(this->maxNeighbours);
+
+    // an approximate search prunes differently under a bound, so only exact searches are seeded
+    const KNNTree::Approximation& approximation = knnTree->getApproximation();
+    const bool seeded = approximation.epsilon == 0.0 && approximation.maxChecks == 0;
+
+    GridOdometer cell(dimensions, dimensionSize, begin);
+    int moved = -1; // outermost axis changed by the last step, -1 before the first cell
+    for (long long i = begin; i < end; ++i, moved = cell.next()) {
+        double bound = std::numeric_limits<double>::infinity();
+        if (seeded && moved == dimensions - 1 && (int)relevantPoints.size() == this->maxNeighbours)
+            bound = relevantPoints.back().distance + 1.0 + 1e-9; // slack for sqrt rounding
+
+        knnTree->getKNearest(cell.coords(), this->maxNeighbours, relevantPoints, bound);
+        *out++ = weigh(relevantPoints);
+    }
+}
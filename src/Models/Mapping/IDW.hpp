@@ -10,10 +10,24 @@ private:
     int maxNeighbours, power; 
     double offset;
 
+    double weigh(const std::vector<KNNTree::Neighbour>& neighbours) const;
+
 public:
-    IDW(std::vector<std::pair<double, std::vector<int>>>& data, int maxNeighbours, int power, double offset = 0);
+    IDW(std::vector<std::pair<double, Coordinates>>& data, int maxNeighbours, int power, double offset = 0);
 
     ~IDW();
 
-    double predict(std::vector<int> query) override;
-};
\ No newline at end of file
+    double predict(const Coordinates& query) override;
+
+    /**
+     * @brief Look neighbours up approximately, see KNNTree::Approximation. Off by default.
+     */
+    void set_approximation(const KNNTree::Approximation& approximation) { knnTree->setApproximation(approximation); }
+
+    /**
+     * @brief Walks the grid reusing the previous cell's neighbours: stepping one cell along the
+     * last axis moves every point by at most 1, so the K nearest lie within the old K-th distance + 1.
+     * With an approximation set every cell is searched unbounded, as predict does.
+     */
+    void predict_range(long long begin, long long end, int dimensions, int dimensionSize, double* out) override;
+};
@@ -1,12 +1,28 @@
+#pragma once
 #include <vector>
+#include "../Tools/GridOdometer.hpp"
 
 class Mapping {
 protected:
-    std::vector<std::pair<double, std::vector<int>>> queriedPoints;
+    std::vector<std::pair<double, Coordinates>> queriedPoints;
 public:
-    Mapping(std::vector<std::pair<double, std::vector<int>>> queriedPoints) : queriedPoints(queriedPoints) {}
+    Mapping(std::vector<std::pair<double, Coordinates>> queriedPoints) : queriedPoints(queriedPoints) {}
 
     virtual ~Mapping() {};
 
-    virtual double predict(std::vector<int> query) = 0;
-};
\ No newline at end of file
+    /**
+     * @brief Predict the value at query. Implementations must not modify the mapping, as
+     * the state space is reconstructed from several threads at once.
+     */
+    virtual double predict(const Coordinates& query) = 0;
+
+    /**
+     * @brief Predict the cells with row-major index in [begin, end) of a
+     * dimensionSize^dimensions grid into out. Override when neighbouring cells can share work.
+     */
+    virtual void predict_range(long long begin, long long end, int dimensions, int dimensionSize, double* out) {
+        GridOdometer cell(dimensions, dimensionSize, begin);
+        for (long long i = begin; i < end; ++i, cell.next())
+            *out++ = predict(cell.coords());
+    }
+};
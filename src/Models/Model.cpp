@@ -0,0 +1,73 @@
+#include "Model.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+// "MASSSNAP" followed by the format version
+static const std::string SNAPSHOT_MAGIC = "MASSSNAP";
+static constexpr long long SNAPSHOT_VERSION = 2; // 2: RBF snapshots hold the partition-of-unity patches
+
+void Model::save_snapshot(const std::string &path) const {
+    if (!supports_snapshots())
+        throw std::logic_error("This model does not support snapshots");
+    // written beside the old snapshot and renamed over it, so a crash mid-write loses nothing
+    const std::string partial = path + ".partial";
+    {
+        std::ofstream file(partial, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            throw std::runtime_error("Failed to open " + partial);
+
+        SnapshotWriter out(file);
+        out.tag(SNAPSHOT_MAGIC);
+        out.integer(SNAPSHOT_VERSION);
+        out.integer(dimensions);
+        out.integer(dimensionSize);
+        out.integer(totalQueries);
+        out.integer(answeredQueries);
+        save_state(out);
+
+        file.close();
+        if (!file) throw std::runtime_error("Failed to write " + partial);
+    }
+    std::remove(path.c_str()); // rename does not replace on every platform
+    if (std::rename(partial.c_str(), path.c_str()) != 0)
+        throw std::runtime_error("Failed to move snapshot into " + path);
+}
+
+void Model::load_snapshot(const std::string &path) {
+    if (answeredQueries != 0 || currentQuery != 0)
+        throw std::logic_error("Snapshots can only be loaded into a freshly constructed model");
+    if (!supports_snapshots())
+        throw std::logic_error("This model does not support snapshots");
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        throw std::runtime_error("Failed to open " + path);
+
+    SnapshotReader in(file);
+    in.expect(SNAPSHOT_MAGIC);
+    if (in.integer() != SNAPSHOT_VERSION)
+        throw std::runtime_error("Unsupported snapshot version in " + path);
+
+    long long savedDimensions = in.integer();
+    long long savedDimensionSize = in.integer();
+    long long savedTotalQueries = in.integer();
+    if (savedDimensions != dimensions || savedDimensionSize != dimensionSize || savedTotalQueries != totalQueries)
+        throw std::invalid_argument("Snapshot " + path + " is of a " + std::to_string(savedDimensions) + "D/" +
+                                    std::to_string(savedDimensionSize) + " run with " +
+                                    std::to_string(savedTotalQueries) + " queries");
+
+    // queries that were in flight are asked again
+    answeredQueries = (int)in.integer();
+    currentQuery = answeredQueries;
+    load_state(in);
+}
+
+void Model::save_state(SnapshotWriter &) const {
+    throw std::logic_error("This model does not support snapshots");
+}
+
+void Model::load_state(SnapshotReader &) {
+    throw std::logic_error("This model does not support snapshots");
+}
@@ -11,19 +11,104 @@
 #ifndef MODEL_H
 #define MODEL_H
 #include <vector>
+#include <cstddef>
+#include <string>
+#include "Tools/GridOdometer.hpp"
+#include "Tools/Snapshot.hpp"
+#include "../StateSpace/StateSpace.hpp"
 
 class Model {
 protected:
     int dimensions, dimensionSize, totalQueries, currentQuery = 0;
+    int answeredQueries = 0; // results received so far, lags currentQuery while queries are in flight
 public:
         Model(int dimensions, int dimensionSize, int totalQueries): 
             totalQueries(totalQueries), dimensions(dimensions), dimensionSize(dimensionSize) {};
+        virtual ~Model() = default;
         int get_dimensions(){ return dimensions; }
         int get_dimensionSize(){ return dimensionSize; }
-        virtual std::vector<int> get_next_query() = 0;
-        virtual void update_prediction(const std::vector<int> &query, double result) = 0;
-        virtual double get_value_at(const std::vector<int> &query) = 0;
+        virtual Coordinates get_next_query() = 0;
+        virtual void update_prediction(const Coordinates &query, double result) = 0;
+        virtual double get_value_at(const Coordinates &query) = 0;
+
+        /**
+         * @brief Emit count queries to be sent to the oracle as one block.
+         * 
+         * The results for earlier queries are not known yet, so models must be able to
+         * pick several points without an update_prediction in between.
+         */
+        virtual std::vector<Coordinates> get_next_queries(int count) {
+            std::vector<Coordinates> queries;
+            queries.reserve(count);
+            for (int i = 0; i < count; i++)
+                queries.push_back(get_next_query());
+            return queries;
+        }
+
+        /**
+         * @brief Ingest a block of results, results[i] belonging to queries[i].
+         */
+        virtual void update_predictions(const std::vector<Coordinates> &queries, const std::vector<double> &results) {
+            for (std::size_t i = 0; i < queries.size(); i++)
+                update_prediction(queries[i], results[i]);
+        }
+
+        /**
+         * @brief Number of cells in the state space, throws std::overflow_error past 64 bits.
+         */
+        long long cell_count() const { return StateSpace::cell_count(dimensions, dimensionSize); }
+
+        /**
+         * @brief Write the values of the cells with row-major index in [begin, end) to out.
+         * 
+         * Must agree with get_value_at cell for cell. The default walks the coordinates in place,
+         * models override it when neighbouring cells can share work. Once querying is over,
+         * get_value_at and evaluate_range may be called from several threads at once.
+         */
+        virtual void evaluate_range(long long begin, long long end, double *out) {
+            GridOdometer cell(dimensions, dimensionSize, begin);
+            for (long long i = begin; i < end; ++i, cell.next())
+                *out++ = get_value_at(cell.coords());
+        }
+
+        /**
+         * @brief Write the whole state space to out, which must hold cell_count() values.
+         */
+        void evaluate_grid(double *out) { evaluate_range(0, cell_count(), out); }
+
+        /**
+         * @brief Number of results the model has been given so far.
+         */
+        int answered_queries() const { return answeredQueries; }
+
+        /**
+         * @brief Whether save_snapshot and load_snapshot work for this model, so a run can
+         * refuse checkpoints before it spends any oracle calls.
+         */
+        virtual bool supports_snapshots() const { return false; }
+
+        /**
+         * @brief Write the model's state to path, replacing it only once the new snapshot is complete.
+         * 
+         * Queries still in flight are not part of the snapshot, a resumed run asks them again.
+         * A model that has been given all its results is stored trained.
+         */
+        void save_snapshot(const std::string &path) const;
+
+        /**
+         * @brief Restore a freshly constructed model from save_snapshot. The snapshot must
+         * come from the same model with the same dimensions, dimension size and query budget.
+         */
+        void load_snapshot(const std::string &path);
+
+protected:
+        /**
+         * @brief Write/read everything beyond the counters in Model. Models that support
+         * snapshots override both, the defaults throw std::logic_error.
+         */
+        virtual void save_state(SnapshotWriter &out) const;
+        virtual void load_state(SnapshotReader &in);
 };
 
 
-#endif // MODEL_H
\ No newline at end of file
+#endif // MODEL_H
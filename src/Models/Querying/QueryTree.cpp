@@ -2,6 +2,7 @@
 #include <algorithm>
 #include <numeric>
 #include <iostream>
+#include <queue>
 
 QueryTree::QueryTree(int dims, int dimSize, int leafSize)
     : dims(dims), dimSize(dimSize), leafSize(leafSize) 
@@ -29,36 +30,45 @@ QueryTree::~QueryTree(){
     freeTree(root);
 }
 
-bool QueryTree::point_in_leaf(const std::vector<int>& query, const TreeNode* leaf) {
+bool QueryTree::point_in_leaf(const Coordinates& query, const TreeNode* leaf) {
     for (size_t d = 0; d < query.size(); ++d)
         if (query[d] < leaf->dimensionLimits[d][0] || query[d] > leaf->dimensionLimits[d][1])
             return false;
     return true;
 }
 
-std::vector<int> QueryTree::get_candidate(TreeNode* leaf) {
-    if (leaf->points.empty()) {
-        std::vector<int> mid(dims);
+double QueryTree::min_distance(const Coordinates& candidate, const TreeNode* leaf) const {
+    double minDist = std::numeric_limits<double>::infinity();
+    for (auto& p : leaf->points) {
+        double dist = 0.0;
+        for (int d = 0; d < dims; ++d) dist += std::abs(candidate[d] - p.second[d]);
+        if (dist < minDist) minDist = dist;
+    }
+    // points still waiting on a result count as samples, so in-flight queries spread out
+    for (auto& p : leaf->pending) {
+        double dist = 0.0;
+        for (int d = 0; d < dims; ++d) dist += std::abs(candidate[d] - p[d]);
+        if (dist < minDist) minDist = dist;
+    }
+    return minDist;
+}
+
+Coordinates QueryTree::get_candidate(TreeNode* leaf) {
+    if (leaf->points.empty() && leaf->pending.empty()) {
+        Coordinates mid(dims);
         for (int d = 0; d < dims; ++d)
             mid[d] = (leaf->dimensionLimits[d][0] + leaf->dimensionLimits[d][1]) / 2;
         return mid;
     }
 
-    std::vector<std::vector<int>> candidates = leaf->cg->getCandidates(5);
+    std::vector<Coordinates> candidates = leaf->cg->getCandidates(5);
+    size_t sampled = leaf->points.size() + leaf->pending.size();
 
-    std::vector<int> bestPoint;
+    Coordinates bestPoint;
     double bestScore = -1.0;
 
     for (auto& candidate : candidates) {
-        double minDist = std::numeric_limits<double>::infinity();
-        for (auto& p : leaf->points) {
-            double dist = 0.0;
-            for (int d = 0; d < dims; ++d)
-                dist += std::abs(candidate[d] - p.second[d]);
-            if (dist < minDist) minDist = dist;
-        }
-
-        double score = minDist / (1.0 + 0.1 * leaf->points.size());
+        double score = min_distance(candidate, leaf) / (1.0 + 0.1 * sampled);
 
         if (score > bestScore) {
             bestScore = score;
@@ -75,39 +85,73 @@ std::vector<int> QueryTree::get_candidate(TreeNode* leaf) {
     return bestPoint;
 }
 
+std::pair<double, Coordinates> QueryTree::score_leaf(TreeNode* leaf) {
+    Coordinates candidate = get_candidate(leaf);
+
+    double score;
+    if (!leaf->points.empty() || !leaf->pending.empty()) {
+        size_t sampled = leaf->points.size() + leaf->pending.size();
+        score = min_distance(candidate, leaf) / (1.0 + 0.1 * sampled);
+    } else {
+        score = 1e9;
+    }
 
+    return {score, candidate};
+}
 
-std::vector<int> QueryTree::get_next_query() {
-    std::pair<double, std::vector<int>> bestChoice = {-1.0, {}};
+Coordinates QueryTree::get_next_query() {
+    std::pair<double, Coordinates> bestChoice = {-1.0, {}};
 
     for (auto leaf : leaves) {
-        std::vector<int> candidate = get_candidate(leaf);
-
-        double score;
-        if (!leaf->points.empty()) {
-            double minDist = std::numeric_limits<double>::infinity();
-            for (auto& p : leaf->points) {
-                double dist = 0.0;
-                for (int d = 0; d < dims; ++d) dist += std::abs(candidate[d] - p.second[d]);
-                if (dist < minDist) minDist = dist;
-            }
-            score = minDist / (1.0 + 0.1 * leaf->points.size());
-        } else {
-            score = 1e9;
-        }
+        auto choice = score_leaf(leaf);
 
-        if (score > bestChoice.first) {
-            bestChoice = {score, candidate};
-            nextLeaf = {candidate, leaf};
+        if (choice.first > bestChoice.first) {
+            bestChoice = choice;
+            nextLeaf = {choice.second, leaf};
         }
     }
 
-    if (bestChoice.second.empty()) bestChoice.second = std::vector<int>(dims, dimSize / 2);
+    if (bestChoice.second.empty()) return Coordinates(dims, dimSize / 2);
 
+    nextLeaf.second->pending.push_back(bestChoice.second);
     return bestChoice.second;
 }
 
-TreeNode* QueryTree::find_leaf(TreeNode* node, const std::vector<int>& query) {
+std::vector<Coordinates> QueryTree::get_next_queries(int count) {
+    std::vector<Coordinates> queries;
+    queries.reserve(count);
+
+    // Score every leaf once. Handing out a point only changes the score of its own
+    // leaf, so only that leaf is rescored before the next pick.
+    using Choice = std::pair<double, std::pair<Coordinates, TreeNode*>>;
+    auto cmp = [](const Choice& a, const Choice& b) { return a.first < b.first; };
+    std::priority_queue<Choice, std::vector<Choice>, decltype(cmp)> best(cmp);
+    for (auto leaf : leaves) {
+        auto choice = score_leaf(leaf);
+        best.push({choice.first, {std::move(choice.second), leaf}});
+    }
+
+    while ((int)queries.size() < count) {
+        if (best.empty()) {
+            queries.push_back(Coordinates(dims, dimSize / 2));
+            continue;
+        }
+        auto [score, pick] = best.top();
+        best.pop();
+
+        TreeNode* leaf = pick.second;
+        leaf->pending.push_back(pick.first);
+        nextLeaf = {pick.first, leaf};
+        queries.push_back(std::move(pick.first));
+
+        auto choice = score_leaf(leaf);
+        best.push({choice.first, {std::move(choice.second), leaf}});
+    }
+
+    return queries;
+}
+
+TreeNode* QueryTree::find_leaf(TreeNode* node, const Coordinates& query) {
     if (!node->left && !node->right)
         return node;
 
@@ -126,7 +170,12 @@ TreeNode* QueryTree::find_leaf(TreeNode* node, const std::vector<int>& query) {
 }
 
 
-void QueryTree::update_prediction(const std::vector<int>& query, double result) {
+void QueryTree::mark_pending(const Coordinates& query) {
+    TreeNode* target = find_leaf(root, query);
+    (target ? target : root)->pending.push_back(query);
+}
+
+TreeNode* QueryTree::insert_point(const Coordinates& query, double result) {
     TreeNode* target = nullptr;
     if (nextLeaf.second != nullptr && query == this->nextLeaf.first)
         target = nextLeaf.second;
@@ -135,6 +184,9 @@ void QueryTree::update_prediction(const std::vector<int>& query, double result)
 
     if (!target) target = root;
 
+    auto it = std::find(target->pending.begin(), target->pending.end(), query);
+    if (it != target->pending.end()) target->pending.erase(it);
+
     try {
         target->cg->addQueriedPoint(query);
     } catch (const std::runtime_error& e) {
@@ -142,9 +194,37 @@ void QueryTree::update_prediction(const std::vector<int>& query, double result)
     }
 
     target->points.push_back({result, query});
+    return target;
+}
+
+void QueryTree::update_prediction(const Coordinates& query, double result) {
+    TreeNode* target = insert_point(query, result);
 
     if ((int)target->points.size() <= leafSize) return;
 
+    split_leaf(target);
+}
+
+void QueryTree::update_predictions(const std::vector<Coordinates>& queries, const std::vector<double>& results) {
+    std::vector<TreeNode*> touched;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        TreeNode* target = insert_point(queries[i], results[i]);
+        if ((int)target->points.size() > leafSize) touched.push_back(target);
+    }
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+    // A leaf can take many points from one batch, keep splitting until every leaf fits
+    while (!touched.empty()) {
+        TreeNode* target = touched.back();
+        touched.pop_back();
+        if ((int)target->points.size() <= leafSize || !split_leaf(target)) continue;
+        touched.push_back(target->left);
+        touched.push_back(target->right);
+    }
+}
+
+bool QueryTree::split_leaf(TreeNode* target) {
     int n = target->points.size();
     int bestDim = -1;
     double bestVar = -1.0;
@@ -170,7 +250,7 @@ void QueryTree::update_prediction(const std::vector<int>& query, double result)
         }
     }
 
-    if (bestDim == -1) return;
+    if (bestDim == -1) return false;
 
     std::sort(target->points.begin(), target->points.end(),
               [bestDim](auto &a, auto &b){ return a.second[bestDim] < b.second[bestDim]; });
@@ -183,7 +263,7 @@ void QueryTree::update_prediction(const std::vector<int>& query, double result)
 
     splitValue = std::max(parentMin, std::min(splitValue, parentMax - 1));
 
-    if (splitValue < parentMin || splitValue >= parentMax) return;
+    if (splitValue < parentMin || splitValue >= parentMax) return false;
 
     auto left = new TreeNode();
     auto right = new TreeNode();
@@ -202,6 +282,10 @@ void QueryTree::update_prediction(const std::vector<int>& query, double result)
         if (p.second[bestDim] <= splitValue && left) left->points.push_back(p);
         else if (right) right->points.push_back(p);
     }
+    for (auto& p : target->pending) {
+        if (p[bestDim] <= splitValue) left->pending.push_back(p);
+        else right->pending.push_back(p);
+    }
 
     target->splitDim = bestDim;
     target->splitValue = splitValue;
@@ -214,6 +298,6 @@ void QueryTree::update_prediction(const std::vector<int>& query, double result)
 
     if (nextLeaf.second == target) nextLeaf = {{}, nullptr};
     target->points.clear();
+    target->pending.clear();
+    return true;
 }
-
-
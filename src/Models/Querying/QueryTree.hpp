@@ -9,7 +9,8 @@
 struct TreeNode {
     TreeNode *left = nullptr, *right = nullptr, *parent = nullptr;
     int splitDim = -1, splitValue = -1;
-    std::vector<std::pair<double, std::vector<int>>> points;
+    std::vector<std::pair<double, Coordinates>> points;
+    std::vector<Coordinates> pending; // handed out by get_next_query, result not back yet
     std::vector<std::vector<int>> dimensionLimits;
     CandidateGenerator *cg;
 
@@ -22,17 +23,25 @@ class QueryTree {
 public:
     QueryTree(int dims, int dimSize, int leafSize);
     ~QueryTree();
-    std::vector<int> get_next_query();
-    void update_prediction(const std::vector<int>& query, double result);
-    std::pair<std::vector<int>, TreeNode*> nextLeaf;
+    Coordinates get_next_query();
+    void update_prediction(const Coordinates& query, double result);
+    std::vector<Coordinates> get_next_queries(int count);
+    void update_predictions(const std::vector<Coordinates>& queries, const std::vector<double>& results);
+    // a point handed out before a restart that has no result yet, so it is not chosen again
+    void mark_pending(const Coordinates& query);
+    std::pair<Coordinates, TreeNode*> nextLeaf;
 private:
     TreeNode* root;
     std::set<TreeNode*> leaves;
     int dims, dimSize, leafSize;
     std::mt19937 rng{std::random_device{}()};
 
-    TreeNode* find_leaf(TreeNode* node, const std::vector<int>& query);
+    TreeNode* find_leaf(TreeNode* node, const Coordinates& query);
 
-    std::vector<int> get_candidate(TreeNode* leaf);
-    bool point_in_leaf(const std::vector<int>& query, const TreeNode* leaf);
+    Coordinates get_candidate(TreeNode* leaf);
+    std::pair<double, Coordinates> score_leaf(TreeNode* leaf);
+    double min_distance(const Coordinates& candidate, const TreeNode* leaf) const;
+    TreeNode* insert_point(const Coordinates& query, double result);
+    bool split_leaf(TreeNode* target);
+    bool point_in_leaf(const Coordinates& query, const TreeNode* leaf);
 };
@@ -2,33 +2,28 @@
 #include "RBF.hpp"
 #include <random>
 #include <ctime>
+#include <atomic>
+#include <exception>
+#include <numeric>
+#include <thread>
 
 // ------------------------------ ctor ------------------------------
 RBFModel::RBFModel(int dimensions, int dimensionSize, int totalQueries)
     : Model(dimensions, dimensionSize, totalQueries),
-      stateSpace(new KDTreeStateSpace(dimensions, dimensionSize)) {
+      stateSpace(new KDTreeStateSpace(dimensions, dimensionSize)),
+      sample_slots(dimensions, dimensionSize) {
     std::srand((unsigned)std::time(nullptr));
 }
 
-// ------------------------------ key helper ------------------------------
-std::string RBFModel::coords_key(const std::vector<int>& c) {
-    std::ostringstream os;
-    for (size_t i = 0; i < c.size(); ++i) {
-        if (i) os << ',';
-        os << c[i];
-    }
-    return os.str();
-}
-
 // ------------------------------ sampling policy ------------------------------
-std::vector<int> RBFModel::get_next_query() {
+Coordinates RBFModel::get_next_query() {
     currentQuery++;
     return is_dense_sampling() ? dense_uniform_query() : farthest_point_query();
 }
 
-std::vector<int> RBFModel::dense_uniform_query() {
+Coordinates RBFModel::dense_uniform_query() {
     int D = dimensions, K = dimensionSize;
-    std::vector<int> q(D, 0);
+    Coordinates q(D, 0);
     double step = (K - 1.0) / std::max(1, totalQueries);
     for (int d = 0; d < D; ++d) {
         double phase = 0.5 * (d + 1);
@@ -39,57 +34,163 @@ std::vector<int> RBFModel::dense_uniform_query() {
     return q;
 }
 
-std::vector<int> RBFModel::farthest_point_query() {
+Coordinates RBFModel::farthest_point_query() {
     int D = dimensions, K = dimensionSize;
-    std::vector<int> best(D, 0);
-    double bestDist = -1.0;
-    if (sample_coords.empty()) {
-        for (int d = 0; d < D; ++d) best[d] = K / 2;
+    if (sample_coords.empty() && pending_coords.empty()) {
+        Coordinates best(D, K / 2);
+        pending_coords.push_back(best);
         return best;
     }
 
-    int stride = (K >= 128) ? 8 : (K >= 64 ? 4 : 1);
-    for (int i0 = 0; i0 < K; i0 += stride) {
-        if (D == 2) {
-            for (int i1 = 0; i1 < K; i1 += stride) {
-                std::vector<int> c = {i0, i1};
-                auto* nn = stateSpace->nearest_neighbor(c);
-                double d2 = stateSpace->squared_distance(c, nn->coords);
-                if (d2 > bestDist) { bestDist = d2; best = c; }
-            }
-        } else if (D == 3) {
-            for (int i1 = 0; i1 < K; i1 += stride)
-                for (int i2 = 0; i2 < K; i2 += stride) {
-                    std::vector<int> c = {i0, i1, i2};
-                    auto* nn = stateSpace->nearest_neighbor(c);
-                    double d2 = stateSpace->squared_distance(c, nn->coords);
-                    if (d2 > bestDist) { bestDist = d2; best = c; }
-                }
+    if (lattice.empty()) build_lattice();
+    int best = farthest_candidate();
+    // every candidate is taken, spread the rest of the budget evenly
+    if (lattice_distance[best] == 0.0) return dense_uniform_query();
+
+    pending_coords.push_back(lattice[best]);
+    lower_lattice_distances(lattice[best]);
+    return lattice[best];
+}
+
+// Every stride-th cell along each axis, the stride growing with the grid and the dimensions so
+// there are at most FPS_MAX_CANDIDATES. Distances start from one batched search over the
+// samples, queries in flight count as samples.
+void RBFModel::build_lattice() {
+    const int D = dimensions, K = dimensionSize;
+    latticeStride = (K >= 128) ? 8 : (K >= 64 ? 4 : 1);
+    auto candidates = [&](int stride) {
+        long long count = 1, perAxis = (K + stride - 1) / stride;
+        for (int d = 0; d < D && count <= FPS_MAX_CANDIDATES; ++d) count *= perAxis;
+        return count;
+    };
+    while (candidates(latticeStride) > FPS_MAX_CANDIDATES) ++latticeStride;
+    latticePerAxis = (K + latticeStride - 1) / latticeStride;
+
+    lattice.reserve(candidates(latticeStride));
+    Coordinates c(D, 0);
+    while (true) {
+        lattice.push_back(c);
+        int d = D - 1;
+        while (d >= 0 && c[d] + latticeStride >= K) c[d--] = 0;
+        if (d < 0) break;
+        c[d] += latticeStride;
+    }
+
+    lattice_distance.assign(lattice.size(), std::numeric_limits<double>::infinity());
+    if (!sample_coords.empty()) {
+        std::vector<KDTreeStateSpace::Neighbor> nearest;
+        stateSpace->nearest_neighbors(lattice, nearest);
+        for (size_t i = 0; i < lattice.size(); ++i) lattice_distance[i] = nearest[i].squaredDistance;
+    }
+    lattice_heap = {};
+    for (size_t i = 0; i < lattice.size(); ++i) lattice_heap.push({lattice_distance[i], (int)i});
+    for (const auto& p : pending_coords) lower_lattice_distances(p);
+}
+
+// the candidate farthest from every sample, dropping heap entries its distance has outdated
+int RBFModel::farthest_candidate() {
+    while (lattice_heap.top().squaredDistance != lattice_distance[lattice_heap.top().index])
+        lattice_heap.pop();
+    return lattice_heap.top().index;
+}
+
+// Only candidates closer to point than the farthest candidate can get closer, and they all
+// lie in the box of that radius around it.
+void RBFModel::lower_lattice_distances(const Coordinates& point) {
+    if (lattice.empty()) return;
+    const int D = dimensions;
+    const double reach = std::sqrt(lattice_distance[farthest_candidate()]);
+
+    std::vector<int> low(D), high(D);
+    for (int d = 0; d < D; ++d) {
+        low[d] = (int)std::max(0.0, std::ceil((point[d] - reach) / latticeStride));
+        high[d] = (int)std::min(latticePerAxis - 1.0, std::floor((point[d] + reach) / latticeStride));
+        if (low[d] > high[d]) return;
+    }
+
+    std::vector<int> at(low);
+    while (true) {
+        int index = 0;
+        double squared = 0.0;
+        for (int d = 0; d < D; ++d) {
+            index = index * latticePerAxis + at[d];
+            double diff = (double)at[d] * latticeStride - point[d];
+            squared += diff * diff;
+        }
+        if (squared < lattice_distance[index]) {
+            lattice_distance[index] = squared;
+            lattice_heap.push({squared, index});
         }
+
+        int d = D - 1;
+        while (d >= 0 && at[d] == high[d]) { at[d] = low[d]; --d; }
+        if (d < 0) break;
+        ++at[d];
+    }
+
+    // stale entries pile up as the samples fill the grid in, start over from the live ones
+    if (lattice_heap.size() > 4 * lattice.size()) {
+        lattice_heap = {};
+        for (size_t i = 0; i < lattice.size(); ++i) lattice_heap.push({lattice_distance[i], (int)i});
     }
-    return best;
 }
 
 // ------------------------------ update & train ------------------------------
-void RBFModel::update_prediction(const std::vector<int>& query, double result) {
+void RBFModel::update_prediction(const Coordinates& query, double result) {
+    add_sample(query, result);
+
+    if (++answeredQueries == totalQueries) {
+        select_kernel_and_params();
+    }
+}
+
+void RBFModel::update_predictions(const std::vector<Coordinates>& queries, const std::vector<double>& results) {
+    sample_coords.reserve(sample_coords.size() + queries.size());
+    sample_values.reserve(sample_values.size() + queries.size());
+    for (size_t i = 0; i < queries.size(); ++i)
+        add_sample(queries[i], results[i]);
+
+    // train once for the whole block
+    answeredQueries += queries.size();
+    if (answeredQueries == totalQueries) {
+        select_kernel_and_params();
+    }
+}
+
+void RBFModel::set_partition_of_unity(bool enabled, int threads) {
+    if (threads < 0) throw std::invalid_argument("RBF: thread count must not be negative.");
+    partitioned = enabled;
+    trainThreads = threads;
+}
+
+void RBFModel::set_evaluation_tolerance(double tolerance) {
+    if (tolerance < 0.0) throw std::invalid_argument("RBF: evaluation tolerance must not be negative.");
+    evaluationTolerance = tolerance;
+    discard_grid();
+}
+
+void RBFModel::add_sample(const Coordinates& query, double result) {
     stateSpace->insert(query, result);
-    std::string key = coords_key(query);
 
-    if (seen_keys.insert(key).second) {
+    auto it = std::find(pending_coords.begin(), pending_coords.end(), query);
+    if (it != pending_coords.end()) pending_coords.erase(it);
+    lower_lattice_distances(query);
+
+    int slot = sample_slots.emplace(query, (int)sample_coords.size());
+    if (slot == (int)sample_coords.size()) {
         sample_coords.push_back(query);
         sample_values.push_back(result);
     } else {
-        for (size_t i = 0; i < sample_coords.size(); ++i)
-            if (sample_coords[i] == query)
-                sample_values[i] = result;
-    }
-
-    if (currentQuery == totalQueries) {
-        select_kernel_and_params();
+        sample_values[slot] = result;
     }
 }
 
-double RBFModel::get_value_at(const std::vector<int>& query) {
+double RBFModel::get_value_at(const Coordinates& query) {
+    if (trained() && patchesPerAxis > 0) return patch_sum(query);
+    if (trained() && kernel == WENDLAND) {
+        std::vector<KDTreeStateSpace::Neighbor> nearby;
+        return compact_sum(query, nearby);
+    }
     if (trained()) {
         double y = 0.0;
         for (size_t i = 0; i < sample_coords.size(); ++i)
@@ -107,13 +208,148 @@ double RBFModel::get_value_at(const std::vector<int>& query) {
     return nn ? nn->value : 0.0;
 }
 
+// Same sums as get_value_at, but the squared distance over every axis except the last
+// is kept per sample and only recomputed when the walk leaves the current row.
+void RBFModel::evaluate_range(long long begin, long long end, double* out) {
+    if (!trained()) {
+        Model::evaluate_range(begin, end, out);
+        return;
+    }
+    if (evaluationTolerance > 0.0 && patchesPerAxis == 0) {
+        if (const std::vector<double>* values = convolved_grid()) {
+            std::copy(values->begin() + begin, values->begin() + end, out);
+            return;
+        }
+    }
+    if (patchesPerAxis > 0) {
+        GridOdometer cell(dimensions, dimensionSize, begin);
+        for (long long c = begin; c < end; ++c, cell.next())
+            *out++ = patch_sum(cell.coords());
+        return;
+    }
+    if (kernel == WENDLAND) {
+        std::vector<KDTreeStateSpace::Neighbor> nearby;
+        GridOdometer cell(dimensions, dimensionSize, begin);
+        for (long long c = begin; c < end; ++c, cell.next())
+            *out++ = compact_sum(cell.coords(), nearby);
+        return;
+    }
+
+    const size_t N = sample_coords.size();
+    const int K = dimensionSize;
+    const int last = dimensions - 1;
+
+    std::vector<double> scaled(N * dimensions); // axis-major, scaled[d * N + i]
+    for (size_t i = 0; i < N; ++i)
+        for (int d = 0; d < dimensions; ++d)
+            scaled[d * N + i] = (double)sample_coords[i][d] / (K - 1);
+    std::vector<double> rowPartial(N, 0.0);
+    const double* lastAxis = scaled.data() + (size_t)last * N;
+
+    GridOdometer cell(dimensions, dimensionSize, begin);
+    int moved = -1;
+    for (long long c = begin; c < end; ++c, moved = cell.next()) {
+        const Coordinates& query = cell.coords();
+        if (moved < last) {
+            for (size_t i = 0; i < N; ++i) {
+                double s = 0.0;
+                for (int d = 0; d < last; ++d) {
+                    double diff = (double)query[d] / (K - 1) - scaled[d * N + i];
+                    s += diff * diff;
+                }
+                rowPartial[i] = s;
+            }
+        }
+
+        const double qa = (double)query[last] / (K - 1);
+        double y = 0.0;
+        for (size_t i = 0; i < N; ++i) {
+            double diff = qa - lastAxis[i];
+            y += weights[i] * phi(std::sqrt(rowPartial[i] + diff * diff));
+        }
+        if (kernel == TPS && tps_affine.size() == (size_t)(dimensions + 1)) {
+            y += tps_affine[0];
+            for (int d = 0; d < dimensions; ++d)
+                y += tps_affine[d + 1] * query[d];
+        }
+        *out++ = y;
+    }
+}
+
+// ------------------------------ snapshots ------------------------------
+void RBFModel::save_state(SnapshotWriter& out) const {
+    out.tag("RBFModel");
+    out.integer((long long)sample_coords.size());
+    for (const auto& c : sample_coords) out.integers(c);
+    out.reals(sample_values);
+
+    // trained state, restored as is so loading never solves the system again
+    out.integer(kernel);
+    out.real(epsilon);
+    out.real(lambda);
+    out.reals(weights);
+    out.reals(tps_affine);
+    out.integer(patchesPerAxis);
+    out.integers(patch_offsets);
+    out.integers(patch_members);
+}
+
+void RBFModel::load_state(SnapshotReader& in) {
+    in.expect("RBFModel");
+    long long n = in.integer();
+    if (n < 0) throw std::runtime_error("Corrupt RBF snapshot");
+    sample_coords.reserve(n);
+    for (long long i = 0; i < n; ++i) {
+        sample_coords.push_back(in.integers());
+        if ((int)sample_coords.back().size() != dimensions)
+            throw std::runtime_error("RBF snapshot sample has the wrong dimension");
+    }
+    sample_values = in.reals();
+    if ((long long)sample_values.size() != n)
+        throw std::runtime_error("Corrupt RBF snapshot");
+
+    kernel = (KernelType)in.integer();
+    epsilon = in.real();
+    lambda = in.real();
+    weights = in.reals();
+    tps_affine = in.reals();
+    discard_grid();
+    patchesPerAxis = (int)in.integer();
+    patch_offsets = in.integers();
+    patch_members = in.integers();
+    long long coefficients = patchesPerAxis > 0 ? (long long)patch_members.size() : n;
+    if (!weights.empty() && (long long)weights.size() != coefficients)
+        throw std::runtime_error("Corrupt RBF snapshot");
+    if (patchesPerAxis > 0 && (patch_offsets.empty() || patch_offsets.back() != (int)patch_members.size()))
+        throw std::runtime_error("Corrupt RBF snapshot");
+
+    // one balanced bulk build instead of n inserts
+    delete stateSpace;
+    stateSpace = new KDTreeStateSpace(dimensions, dimensionSize, sample_coords, sample_values);
+    for (long long i = 0; i < n; ++i)
+        sample_slots.emplace(sample_coords[i], (int)i);
+}
+
 // ------------------------------ kernel selection ------------------------------
 void RBFModel::select_kernel_and_params() {
     const int D = dimensions;
-    const int K = dimensionSize;
     double rho = budget_ratio();
-    double dnn = median_1nn_distance(sample_coords, K);
+    double dnn = median_1nn_distance();
     if (dnn <= 0.0) dnn = 1.0;
+    patchesPerAxis = 0;
+    patch_offsets.clear();
+    patch_members.clear();
+    discard_grid();
+
+    // a dense system no longer fits in time or memory: a compact kernel whose support holds
+    // about WENDLAND_NEIGHBOURS samples gives a sparse one. ln 2 samples lie within dnn.
+    if (!partitioned && (int)sample_coords.size() > DENSE_MAX_SAMPLES) {
+        kernel = WENDLAND;
+        epsilon = 1.0 / (dnn * std::pow(WENDLAND_NEIGHBOURS / std::log(2.0), 1.0 / D));
+        lambda = 1e-8;
+        compute_compact_weights();
+        return;
+    }
 
     // --- Adaptive kernel selection (robust) ---
     if (D == 2 && rho >= 0.05 && rho <= 0.3)
@@ -133,39 +369,268 @@ void RBFModel::select_kernel_and_params() {
 
     // --- Compute weights with fallback ---
     try {
-        compute_global_weights();
+        partitioned ? compute_patch_weights() : compute_global_weights();
     } catch (const std::exception& e) {
         std::cerr << "[RBF] Kernel " << kernel
                   << " failed (" << e.what() << "). Falling back to MQ.\n";
         kernel = MQ;
         lambda = 1e-6;
-        compute_global_weights();
+        partitioned ? compute_patch_weights() : compute_global_weights();
     }
 }
 
 // ------------------------------ training ------------------------------
 void RBFModel::compute_global_weights() {
     const int N = (int)sample_coords.size();
+    if (N == 0) return;
+    std::vector<int> members(N);
+    std::iota(members.begin(), members.end(), 0);
+    std::vector<double> x(N, 0.0);
+    solve_kernel_system(members.data(), N, x.data());
+    weights = std::move(x);
+}
+
+// interpolation weights of the n samples listed in members, written to out
+void RBFModel::solve_kernel_system(const int* members, int n, double* out) const {
+    // one contiguous matrix, factorised in place so 20k samples need 3.2 GB and not a second copy
+    Eigen::MatrixXd A(n, n);
+    Eigen::VectorXd b(n);
+    for (int i = 0; i < n; ++i) b[i] = sample_values[members[i]];
+    Eigen::Map<Eigen::VectorXd> solution(out, n);
+
+    // Gaussian and IMQ give positive definite systems: blocked Cholesky on the lower triangle.
+    // With a tiny ridge round-off can still break that, those systems take the general path.
+    bool solved = false;
+    if (kernel == GAUSSIAN || kernel == IMQ) {
+        assemble_kernel_matrix(A, members, false);
+        Eigen::LLT<Eigen::Ref<Eigen::MatrixXd>, Eigen::Lower> llt(A);
+        if (llt.info() == Eigen::Success) {
+            solution = llt.solve(b);
+            solved = true;
+        }
+    }
+    // MQ and TPS are indefinite. Eigen's symmetric LDLT only pivots on the diagonal and is not
+    // blocked, so they use blocked LU with partial pivoting, which is faster and more accurate here.
+    if (!solved) {
+        assemble_kernel_matrix(A, members, true);
+        Eigen::PartialPivLU<Eigen::Ref<Eigen::MatrixXd>> lu(A);
+        solution = lu.solve(b);
+    }
+
+    if (!solution.allFinite())
+        throw std::runtime_error("RBF: linear system solve failed (ill-conditioned).");
+}
+
+void RBFModel::assemble_kernel_matrix(Eigen::MatrixXd& A, const int* members, bool full) const {
+    const int n = (int)A.rows();
     const int K = dimensionSize;
+    for (int j = 0; j < n; ++j) {
+        A(j, j) = phi(0.0) + lambda;
+        for (int i = j + 1; i < n; ++i)
+            A(i, j) = phi(euclid_scaled(sample_coords[members[i]], sample_coords[members[j]], K));
+    }
+    if (full) {
+        for (int j = 0; j < n; ++j)
+            for (int i = j + 1; i < n; ++i) A(j, i) = A(i, j);
+    }
+}
+
+// ------------------------------ partition of unity ------------------------------
+// Patch centres sit on a regular m^D lattice over the unit cube, (i + 0.5) / m along each axis.
+// Each box reaches PATCH_OVERLAP / 2 of the spacing past its own lattice cell, so every point
+// lies strictly inside at least one box and at most two along any axis.
+
+// the patches along one axis whose box contains x, with their blending weights
+int RBFModel::patch_axis_range(double x, int axis[2], double psi[2]) const {
+    const int m = patchesPerAxis;
+    const double half = 0.5 * (1.0 + PATCH_OVERLAP) / m;
+    int first = std::max(0, (int)std::floor((x - half) * m - 0.5));
+    int last = std::min(m - 1, (int)std::ceil((x + half) * m - 0.5));
+    int count = 0;
+    for (int i = first; i <= last; ++i) {
+        double t = std::abs(x - (i + 0.5) / m) / half;
+        if (t >= 1.0) continue;
+        axis[count] = i;
+        psi[count] = pow_int(1.0 - t, 3) * (3.0 * t + 1.0); // C2 Wendland, zero at the box edge
+        count++;
+    }
+    return count;
+}
+
+// calls visit(patch, weight) for every patch whose box contains query, weight being the
+// product of the per-axis blending weights
+template <typename Visit>
+void RBFModel::for_each_patch(const Coordinates& query, Visit&& visit) const {
+    const int D = dimensions;
+    std::vector<int> axis(2 * D), count(D), pick(D, 0);
+    std::vector<double> psi(2 * D);
+    for (int d = 0; d < D; ++d)
+        count[d] = patch_axis_range((double)query[d] / (dimensionSize - 1), &axis[2 * d], &psi[2 * d]);
+
+    while (true) {
+        long long patch = 0;
+        double weight = 1.0;
+        for (int d = D - 1; d >= 0; --d) {
+            patch = patch * patchesPerAxis + axis[2 * d + pick[d]];
+            weight *= psi[2 * d + pick[d]];
+        }
+        visit(patch, weight);
+
+        int d = 0;
+        while (d < D && ++pick[d] == count[d]) pick[d++] = 0;
+        if (d == D) return;
+    }
+}
+
+void RBFModel::compute_patch_weights() {
+    const int N = (int)sample_coords.size();
     if (N == 0) return;
 
-    std::vector<std::vector<double>> A(N, std::vector<double>(N, 0.0));
-    for (int i = 0; i < N; ++i) {
-        A[i][i] = phi(0.0) + lambda;
-        for (int j = i + 1; j < N; ++j) {
-            double r = euclid_scaled(sample_coords[i], sample_coords[j], K);
-            double v = phi(r);
-            A[i][j] = A[j][i] = v;
+    // boxes of side (1 + PATCH_OVERLAP) / m hold about PATCH_SAMPLES samples
+    patchesPerAxis = std::max(1, (int)std::lround((1.0 + PATCH_OVERLAP) * std::pow(N / (double)PATCH_SAMPLES, 1.0 / dimensions)));
+    long long patches = 1;
+    for (int d = 0; d < dimensions; ++d) patches *= patchesPerAxis;
+
+    // members of every patch, counted then filled in sample order
+    patch_offsets.assign(patches + 1, 0);
+    for (int i = 0; i < N; ++i)
+        for_each_patch(sample_coords[i], [&](long long p, double) { patch_offsets[p + 1]++; });
+    for (long long p = 0; p < patches; ++p) patch_offsets[p + 1] += patch_offsets[p];
+    patch_members.resize(patch_offsets.back());
+    std::vector<int> fill(patch_offsets.begin(), patch_offsets.end() - 1);
+    for (int i = 0; i < N; ++i)
+        for_each_patch(sample_coords[i], [&](long long p, double) { patch_members[fill[p]++] = i; });
+
+    // independent solves, each thread takes the next unsolved patch
+    std::vector<double> x(patch_members.size(), 0.0);
+    std::atomic<long long> next{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto work = [&]() {
+        try {
+            long long p;
+            while (!failed.load(std::memory_order_relaxed) && (p = next.fetch_add(1)) < patches) {
+                int n = patch_offsets[p + 1] - patch_offsets[p];
+                if (n > 0) solve_kernel_system(&patch_members[patch_offsets[p]], n, &x[patch_offsets[p]]);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) error = std::current_exception();
+            failed.store(true, std::memory_order_relaxed);
+        }
+    };
+
+    int threads = trainThreads > 0 ? trainThreads : (int)std::max(1u, std::thread::hardware_concurrency());
+    threads = (int)std::min<long long>(threads, patches);
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (int t = 1; t < threads; ++t)
+        pool.emplace_back(work);
+    work();
+    for (auto& thread : pool)
+        thread.join();
+
+    if (error) std::rethrow_exception(error);
+    weights = std::move(x);
+}
+
+// Shepard blend of the local interpolants of the patches around query. Empty patches do not
+// vote, a cell covered by none falls back to its nearest sample.
+double RBFModel::patch_sum(const Coordinates& query) const {
+    double numerator = 0.0, denominator = 0.0;
+    for_each_patch(query, [&](long long p, double weight) {
+        if (patch_offsets[p] == patch_offsets[p + 1]) return;
+        double s = 0.0;
+        for (int k = patch_offsets[p]; k < patch_offsets[p + 1]; ++k)
+            s += weights[k] * phi(euclid_scaled(query, sample_coords[patch_members[k]], dimensionSize));
+        numerator += weight * s;
+        denominator += weight;
+    });
+    if (denominator > 0.0) return numerator / denominator;
+    auto* nn = stateSpace->nearest_neighbor(query);
+    return nn ? nn->value : 0.0;
+}
+
+// Only pairs of samples within the support are non-zero, they come from radius searches in the
+// tree. The system is positive definite and solved by conjugate gradients with an incomplete
+// Cholesky preconditioner, which needs no more memory than the matrix itself.
+void RBFModel::compute_compact_weights() {
+    const int N = (int)sample_coords.size();
+    if (N == 0) return;
+    const double radius = (dimensionSize - 1) / epsilon; // support in cells
+
+    std::vector<Eigen::Triplet<double>> entries;
+    entries.reserve((std::size_t)N * (std::size_t)(WENDLAND_NEIGHBOURS / 2 + 1));
+    std::vector<KDTreeStateSpace::Neighbor> nearby;
+    for (int j = 0; j < N; ++j) {
+        entries.emplace_back(j, j, phi(0.0) + lambda);
+        stateSpace->radius_neighbors(sample_coords[j], radius, nearby);
+        for (const auto& n : nearby) {
+            int i = sample_slots.find(n.node->coords);
+            if (i > j) entries.emplace_back(i, j, phi(std::sqrt(n.squaredDistance) / (dimensionSize - 1)));
         }
     }
 
-    std::vector<double> b = sample_values;
+    Eigen::SparseMatrix<double> A(N, N);
+    A.setFromTriplets(entries.begin(), entries.end());
+    entries = {};
+
+    Eigen::ConjugateGradient<Eigen::SparseMatrix<double>, Eigen::Lower, Eigen::IncompleteCholesky<double>> cg;
+    cg.setTolerance(1e-10);
+    cg.compute(A);
+    Eigen::Map<const Eigen::VectorXd> b(sample_values.data(), N);
     std::vector<double> x(N, 0.0);
-    if (!solve_linear_system(A, b, x))
-        throw std::runtime_error("RBF: linear system solve failed (ill-conditioned).");
+    Eigen::Map<Eigen::VectorXd> solution(x.data(), N);
+    solution = cg.solve(b);
+
+    if (cg.info() != Eigen::Success || !solution.allFinite())
+        throw std::runtime_error("RBF: sparse solve did not converge.");
     weights = std::move(x);
 }
 
+// the weighted kernels of the samples within the support of query, the only non-zero terms
+double RBFModel::compact_sum(const Coordinates& query, std::vector<KDTreeStateSpace::Neighbor>& nearby) const {
+    stateSpace->radius_neighbors(query, (dimensionSize - 1) / epsilon, nearby);
+    double y = 0.0;
+    for (const auto& n : nearby)
+        y += weights[sample_slots.find(n.node->coords)] * phi(std::sqrt(n.squaredDistance) / (dimensionSize - 1));
+    return y;
+}
+
+// ------------------------------ FFT grid evaluation ------------------------------
+// Every sample sits on a cell, so the sums of all cells are one convolution of the weights with
+// the kernel. Built once under the lock, evaluate_range calls from other threads only read it.
+const std::vector<double>* RBFModel::convolved_grid() {
+    std::lock_guard<std::mutex> lock(gridMutex);
+    if (!gridTried) {
+        gridTried = true;
+        GridConvolution convolution(dimensions, dimensionSize);
+        if (convolution.padded_points() <= FFT_MAX_POINTS) {
+            const double K = dimensionSize - 1;
+            double error = convolution.convolve(sample_coords, weights,
+                [&](double squared) { return phi(std::sqrt(squared) / K); }, grid);
+            if (error > evaluationTolerance) {
+                grid.clear();
+            } else if (kernel == TPS && tps_affine.size() == (size_t)(dimensions + 1)) {
+                GridOdometer cell(dimensions, dimensionSize, 0);
+                for (size_t c = 0; c < grid.size(); ++c, cell.next()) {
+                    grid[c] += tps_affine[0];
+                    for (int d = 0; d < dimensions; ++d)
+                        grid[c] += tps_affine[d + 1] * cell.coords()[d];
+                }
+            }
+        }
+    }
+    return grid.empty() ? nullptr : &grid;
+}
+
+void RBFModel::discard_grid() {
+    std::lock_guard<std::mutex> lock(gridMutex);
+    gridTried = false;
+    grid = {};
+}
+
 // ------------------------------ kernels ------------------------------
 double RBFModel::phi(double r) const {
     double er = epsilon * r;
@@ -174,12 +639,18 @@ double RBFModel::phi(double r) const {
         case MQ:       return std::sqrt(1.0 + (er * er));
         case IMQ:      return 1.0 / std::sqrt(1.0 + (er * er));
         case TPS:      return (r <= 0.0) ? 0.0 : (r * r) * std::log(r);
+        case WENDLAND: {
+            // Wendland's phi_{l,1}, positive definite in up to 2l - 3 dimensions
+            if (er >= 1.0) return 0.0;
+            int l = dimensions / 2 + 2;
+            return pow_int(1.0 - er, l + 1) * ((l + 1) * er + 1.0);
+        }
         default:       return 0.0;
     }
 }
 
 // ------------------------------ helpers ------------------------------
-double RBFModel::euclid_scaled(const std::vector<int>& a, const std::vector<int>& b, int K) {
+double RBFModel::euclid_scaled(const Coordinates& a, const Coordinates& b, int K) {
     double s = 0.0;
     for (size_t i = 0; i < a.size(); ++i) {
         double da = (double)a[i] / (K - 1);
@@ -190,14 +661,16 @@ double RBFModel::euclid_scaled(const std::vector<int>& a, const std::vector<int>
     return std::sqrt(s);
 }
 
-double RBFModel::median_1nn_distance(const std::vector<std::vector<int>>& X, int K) {
-    const int N = (int)X.size();
+// the closest other sample through the tree, each sample's nearest neighbour is itself
+double RBFModel::median_1nn_distance() const {
+    const int N = (int)sample_coords.size();
     if (N <= 1) return 1.0;
-    std::vector<double> nn(N, std::numeric_limits<double>::infinity());
-    for (int i = 0; i < N; ++i)
-        for (int j = 0; j < N; ++j)
-            if (i != j)
-                nn[i] = std::min(nn[i], euclid_scaled(X[i], X[j], K));
+    std::vector<double> nn(N);
+    std::vector<KDTreeStateSpace::Neighbor> closest;
+    for (int i = 0; i < N; ++i) {
+        stateSpace->nearest_k_neighbors(sample_coords[i], 2, closest);
+        nn[i] = std::sqrt(closest.back().squaredDistance) / (dimensionSize - 1);
+    }
     std::sort(nn.begin(), nn.end());
     return (N % 2) ? nn[N/2] : 0.5 * (nn[N/2 - 1] + nn[N/2]);
 }
@@ -216,36 +689,4 @@ double RBFModel::budget_ratio() const {
 
 bool RBFModel::is_dense_sampling() const { return budget_ratio() >= 0.25; }
 
-// ------------------------------ dense solver ------------------------------
-bool RBFModel::solve_linear_system(std::vector<std::vector<double>>& A,
-                                   std::vector<double>& b,
-                                   std::vector<double>& x) {
-    int n = (int)A.size();
-    if (n == 0) return true;
-    for (auto& row : A) if ((int)row.size() != n) return false;
-    if ((int)b.size() != n) return false;
-
-    for (int i = 0; i < n; ++i) A[i].push_back(b[i]);
-    for (int col = 0; col < n; ++col) {
-        int piv = col;
-        double best = std::fabs(A[col][col]);
-        for (int r = col + 1; r < n; ++r)
-            if (std::fabs(A[r][col]) > best) { best = std::fabs(A[r][col]); piv = r; }
-        if (best == 0.0) return false;
-        if (piv != col) std::swap(A[piv], A[col]);
-        double pivVal = A[col][col];
-        for (int c = col; c <= n; ++c) A[col][c] /= pivVal;
-        for (int r = col + 1; r < n; ++r) {
-            double f = A[r][col];
-            for (int c = col; c <= n; ++c) A[r][c] -= f * A[col][c];
-        }
-    }
-    x.assign(n, 0.0);
-    for (int i = n - 1; i >= 0; --i) {
-        double sum = A[i][n];
-        for (int c = i + 1; c < n; ++c) sum -= A[i][c] * x[c];
-        x[i] = sum;
-    }
-    return true;
-}
 #endif
@@ -4,30 +4,87 @@
 
 #include "Model.hpp"
 #include "../StateSpace/KDTreeStateSpace.hpp"
+#include "../StateSpace/CellSlotMap.hpp"
+#include "Tools/GridConvolution.hpp"
 #include <vector>
 #include <limits>
 #include <cmath>
 #include <stdexcept>
 #include <algorithm>
-#include <unordered_set>
-#include <sstream>
+#include <mutex>
+#include <queue>
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
 
 class RBFModel : public Model {
 public:
-    enum KernelType { GAUSSIAN, MQ, IMQ, TPS };
+    // WENDLAND is compactly supported, zero beyond 1 / epsilon
+    enum KernelType { GAUSSIAN, MQ, IMQ, TPS, WENDLAND };
+
+    // more samples than this train the compactly supported kernel through a sparse system
+    static constexpr int DENSE_MAX_SAMPLES = 10000;
 
     RBFModel(int dimensions, int dimensionSize, int totalQueries);
 
-    std::vector<int> get_next_query() override;
-    void update_prediction(const std::vector<int>& query, double result) override;
-    double get_value_at(const std::vector<int>& query) override;
+    Coordinates get_next_query() override;
+    void update_prediction(const Coordinates& query, double result) override;
+    double get_value_at(const Coordinates& query) override;
+    void evaluate_range(long long begin, long long end, double* out) override;
+    void update_predictions(const std::vector<Coordinates>& queries, const std::vector<double>& results) override;
+
+    /**
+     * @brief Train in partition-of-unity mode instead of one global system.
+     *
+     * The unit cube is covered by a regular lattice of overlapping box patches, each holding
+     * about PATCH_SAMPLES samples. Every patch solves its own small system with the selected
+     * kernel, on threads threads (0 for every hardware thread), and predictions blend the
+     * patches around a cell with smooth compactly supported weights. Takes effect at the next
+     * training.
+     */
+    void set_partition_of_unity(bool enabled, int threads = 0);
+
+    /**
+     * @brief Let evaluate_range trade exactness for speed, within tolerance of the exact sum.
+     *
+     * 0, the default, keeps evaluate_range equal to get_value_at. Above it, the first call
+     * convolves the weights with the kernel over the whole grid by FFT, when the padded grid
+     * fits in FFT_MAX_POINTS and the estimated round-off is within tolerance, and later calls
+     * copy from it. Otherwise, and for partition of unity models, cells are summed exactly.
+     */
+    void set_evaluation_tolerance(double tolerance);
+
+    bool supports_snapshots() const override { return true; }
+
+protected:
+    void save_state(SnapshotWriter& out) const override;
+    void load_state(SnapshotReader& in) override;
 
 private:
     // --- Core storage ---
     KDTreeStateSpace* stateSpace;
-    std::vector<std::vector<int>> sample_coords;  // size N x D
+    std::vector<Coordinates> sample_coords;  // size N x D
     std::vector<double> sample_values;            // size N
     std::vector<double> weights;                  // size N (after training)
+    std::vector<Coordinates> pending_coords; // queried, result not back yet
+
+    // --- Farthest point sampling ---
+    // Candidates on a strided lattice, built on first use, with the squared distance of each to
+    // its closest sample or query in flight. A new point only lowers the candidates closer to it
+    // than the farthest one. The max-heap keeps stale entries until they surface.
+    static constexpr long long FPS_MAX_CANDIDATES = 1LL << 18;
+    struct Candidate {
+        double squaredDistance;
+        int index;
+        // farthest first, the lowest index among equals
+        bool operator<(const Candidate& o) const {
+            return squaredDistance < o.squaredDistance || (squaredDistance == o.squaredDistance && index > o.index);
+        }
+    };
+    std::vector<Coordinates> lattice;
+    std::vector<double> lattice_distance;
+    std::priority_queue<Candidate> lattice_heap;
+    int latticeStride = 1;
+    int latticePerAxis = 0;
 
     // --- TPS affine term ---
     std::vector<double> tps_affine;               // (D+1) coefficients for TPS
@@ -37,27 +94,59 @@ private:
     double epsilon = 1.0;
     double lambda  = 1e-8;
 
+    // samples expected inside the Wendland support of a random sample
+    static constexpr double WENDLAND_NEIGHBOURS = 30.0;
+
+    // --- Partition of unity ---
+    // patch p holds patch_members[patch_offsets[p] .. patch_offsets[p + 1]), weights holds their
+    // coefficients in the same order. patchesPerAxis is 0 when trained on one global system.
+    static constexpr int PATCH_SAMPLES = 100;
+    static constexpr double PATCH_OVERLAP = 0.5; // share of the patch spacing added around each box
+    bool partitioned = false;
+    int trainThreads = 0;
+    int patchesPerAxis = 0;
+    std::vector<int> patch_offsets;
+    std::vector<int> patch_members;
+
+    // --- FFT grid evaluation ---
+    static constexpr long long FFT_MAX_POINTS = 1LL << 24;
+    double evaluationTolerance = 0.0;
+    std::mutex gridMutex;
+    bool gridTried = false;
+    std::vector<double> grid; // every cell, empty when the FFT was not usable
+
     // --- Deduplication ---
-    std::unordered_set<std::string> seen_keys;
-    static std::string coords_key(const std::vector<int>& c);
+    CellSlotMap sample_slots;                     // cell -> index into sample_coords
+
+    void add_sample(const Coordinates& query, double result);
 
     // --- Sampling helpers ---
-    std::vector<int> dense_uniform_query();
-    std::vector<int> farthest_point_query();
+    Coordinates dense_uniform_query();
+    Coordinates farthest_point_query();
+    void build_lattice();
+    int farthest_candidate();
+    void lower_lattice_distances(const Coordinates& point);
 
     // --- Training / selection ---
     void select_kernel_and_params();
     void compute_global_weights();
+    void assemble_kernel_matrix(Eigen::MatrixXd& A, const int* members, bool full) const;
+    void solve_kernel_system(const int* members, int n, double* out) const;
+    void compute_patch_weights();
+    int patch_axis_range(double x, int axis[2], double psi[2]) const;
+    double patch_sum(const Coordinates& query) const;
+    template <typename Visit>
+    void for_each_patch(const Coordinates& query, Visit&& visit) const;
+    const std::vector<double>* convolved_grid();
+    void discard_grid();
+    void compute_compact_weights();
+    double compact_sum(const Coordinates& query, std::vector<KDTreeStateSpace::Neighbor>& nearby) const;
 
     // --- Math helpers ---
-    static double euclid_scaled(const std::vector<int>& a, const std::vector<int>& b, int K);
-    static double median_1nn_distance(const std::vector<std::vector<int>>& X, int K);
+    static double euclid_scaled(const Coordinates& a, const Coordinates& b, int K);
+    double median_1nn_distance() const;
     double phi(double r) const;
 
-    static bool solve_linear_system(std::vector<std::vector<double>>& A,
-                                    std::vector<double>& b,
-                                    std::vector<double>& x);
-
     bool is_dense_sampling() const;
     double budget_ratio() const;
     double pow_int(double base, int exp) const;
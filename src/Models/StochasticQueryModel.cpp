@@ -1,5 +1,6 @@
 #include "StochasticQueryModel.hpp"
 #include "../InputOutput/InputOutput.hpp"
+#include <algorithm>
 
 
 StochasticQueryModel::StochasticQueryModel(int dimensions, int dimensionSize, int totalQueries) 
@@ -12,7 +13,7 @@ StochasticQueryModel::StochasticQueryModel(int dimensions, int dimensionSize, in
     scaledSize = floor(dimensionSize * scaleRatio);
     shouldQuery = 1.5*shouldQuery;
     qt = new QueryTree(dimensions, scaledSize, 30);
-    totalPoints = pow(scaledSize, dimensions);
+    totalPoints = StateSpace::cell_count(dimensions, scaledSize);
     queryWinTotal.resize(totalPoints);
     
     precomputedBounds.resize(scaledSize);
@@ -33,8 +34,8 @@ StochasticQueryModel::~StochasticQueryModel(){
     if (this->qt) delete this->qt;
 }
 
-std::vector<int> StochasticQueryModel::lowerResolution(const std::vector<int>& rawQuery) const {
-    std::vector<int> scaled(rawQuery.size());
+Coordinates StochasticQueryModel::lowerResolution(const Coordinates& rawQuery) const {
+    Coordinates scaled(rawQuery.size());
 
     for (size_t i = 0; i < rawQuery.size(); ++i) {
         int x = rawQuery[i];
@@ -52,8 +53,8 @@ std::vector<int> StochasticQueryModel::lowerResolution(const std::vector<int>& r
     return scaled;
 }
 
-std::vector<int> StochasticQueryModel::sample_unscaled_point_from_scaled(const std::vector<int>& scaledQuery) const{
-    std::vector<int> result(scaledQuery.size());
+Coordinates StochasticQueryModel::sample_unscaled_point_from_scaled(const Coordinates& scaledQuery) const{
+    Coordinates result(scaledQuery.size());
     static thread_local std::mt19937_64 rng(std::random_device{}());
 
     for (size_t i = 0; i < scaledQuery.size(); ++i) {
@@ -68,8 +69,8 @@ std::vector<int> StochasticQueryModel::sample_unscaled_point_from_scaled(const s
 }
 
 
-std::vector<int> StochasticQueryModel::unscale_midpoint(const std::vector<int>& scaledQuery) const {
-    std::vector<int> unscaled(scaledQuery.size());
+Coordinates StochasticQueryModel::unscale_midpoint(const Coordinates& scaledQuery) const {
+    Coordinates unscaled(scaledQuery.size());
     for (size_t i = 0; i < scaledQuery.size(); ++i) {
         int s = scaledQuery[i];
         unscaled[i] = (precomputedBounds[s].first + precomputedBounds[s].second) / 2;
@@ -77,29 +78,37 @@ std::vector<int> StochasticQueryModel::unscale_midpoint(const std::vector<int>&
     return unscaled;
 }
 
-inline int linear_index(const std::vector<int>& coords, int scaledSize) {
-    int idx = 0;
+inline long long linear_index(const Coordinates& coords, int scaledSize) {
+    long long idx = 0;
     for (size_t d = 0; d < coords.size(); ++d) {
         idx = idx * scaledSize + coords[d];
     }
     return idx;
 }
 
-std::vector<int> StochasticQueryModel::get_next_query() {
+Coordinates StochasticQueryModel::get_next_query() {
     currentQuery++;
 
-    if (repeatQueries == 0) {
+    auto active = sampling.find(currentQueryIDX);
+    while ((active == sampling.end() || active->second.remaining == 0) && !resumed.empty()) {
+        currentQueryIDX = resumed.front();
+        resumed.pop_front();
+        active = sampling.find(currentQueryIDX);
+    }
+    if (active == sampling.end() || active->second.remaining == 0) {
         // new point chosen
-        currentQueryPoint = qt->get_next_query();
-        currentQueryIDX = linear_index(currentQueryPoint, scaledSize);
-        repeatQueries = shouldQuery;
-        // reset per-point counters
-        wCount = tCount = 0;
+        Coordinates point = qt->get_next_query();
+        currentQueryIDX = linear_index(point, scaledSize);
+        active = sampling.try_emplace(currentQueryIDX).first;
+        active->second.scaledPoint = point;
+        active->second.remaining += shouldQuery;
     }
 
-    repeatQueries--;
+    active->second.remaining--;
 
-    return sample_unscaled_point_from_scaled(currentQueryPoint);
+    Coordinates sample = sample_unscaled_point_from_scaled(active->second.scaledPoint);
+    inFlight[sample].push_back(currentQueryIDX);
+    return sample;
 }
 
 
@@ -107,55 +116,185 @@ std::vector<int> StochasticQueryModel::get_next_query() {
 double priorProb = 0.315; // initial guess for unknown points
 double shrinkFactor = 0.3; // how strongly we shrink toward the prior
 
-void StochasticQueryModel::update_prediction(const std::vector<int>& query, double result) {
-    if (result >= 0.9) wCount++;
-    tCount++;
+void StochasticQueryModel::finish_point(long long idx, SampledPoint& point,
+                                        std::vector<Coordinates>& finished, std::vector<double>& probs) {
+    // compute raw probability
+    double rawProb = double(point.wCount) / point.tCount;
 
-    if (tCount >= shouldQuery || (currentQuery == totalQueries && tCount >= 0.75 * shouldQuery)) {
-        
-        // compute raw probability
-        double rawProb = double(wCount) / tCount;
+    // shrink toward prior to reduce variance
+    double prob = shrinkFactor * rawProb + (1.0 - shrinkFactor) * priorProb;
 
-        // shrink toward prior to reduce variance
-        double prob = shrinkFactor * rawProb + (1.0 - shrinkFactor) * priorProb;
+    queryWinTotal[idx] = { point.wCount, point.tCount };
+    finished.push_back(point.scaledPoint);
+    probs.push_back(prob);
+
+    // reset counters
+    point.wCount = point.tCount = 0;
+}
+
+void StochasticQueryModel::record_result(const Coordinates& query, double result,
+                                         std::vector<Coordinates>& finished, std::vector<double>& probs) {
+    auto owner = inFlight.find(query);
+    if (owner == inFlight.end()) return; // not a sample we handed out
+
+    long long idx = owner->second.front();
+    owner->second.pop_front();
+    if (owner->second.empty()) inFlight.erase(owner);
+
+    auto it = sampling.find(idx);
+    SampledPoint& point = it->second;
+    if (result >= 0.9) point.wCount++;
+    point.tCount++;
+
+    if (point.tCount >= shouldQuery) {
+        finish_point(idx, point, finished, probs);
+        if (point.remaining == 0) sampling.erase(it);
+    }
+}
+
+void StochasticQueryModel::flush_partial_points(std::vector<Coordinates>& finished, std::vector<double>& probs) {
+    for (auto& [idx, point] : sampling)
+        if (point.tCount > 0 && point.tCount >= 0.75 * shouldQuery)
+            finish_point(idx, point, finished, probs);
+}
+
+void StochasticQueryModel::update_prediction(const Coordinates& query, double result) {
+    std::vector<Coordinates> finished;
+    std::vector<double> probs;
+
+    record_result(query, result, finished, probs);
 
-        queryWinTotal[currentQueryIDX] = { wCount, tCount };
-        qt->update_prediction(currentQueryPoint, prob);
+    bool last = ++answeredQueries >= totalQueries;
+    if (last) flush_partial_points(finished, probs);
 
-        // reset counters
-        wCount = tCount = repeatQueries = 0;
+    for (size_t i = 0; i < finished.size(); i++) {
+        qt->update_prediction(finished[i], probs[i]);
+        treeResults.emplace_back(probs[i], finished[i]);
     }
 
-    if (currentQuery >= totalQueries) {
-        // build interpolator
-        data.clear();
-        for (int i = 0; i < queryWinTotal.size(); i++) {
-            if (queryWinTotal[i].empty()) continue;
+    if (last) build_interpolator();
+}
+
+void StochasticQueryModel::update_predictions(const std::vector<Coordinates>& queries, const std::vector<double>& results) {
+    std::vector<Coordinates> finished;
+    std::vector<double> probs;
+
+    for (size_t i = 0; i < queries.size(); i++)
+        record_result(queries[i], results[i], finished, probs);
 
-            double rawProb = double(queryWinTotal[i][0]) / queryWinTotal[i][1];
-            double prob = shrinkFactor * rawProb + (1.0 - shrinkFactor) * priorProb;
+    answeredQueries += queries.size();
+    bool last = answeredQueries >= totalQueries;
+    if (last) flush_partial_points(finished, probs);
 
-            // clamp predictions to avoid extremes
-            // prob = std::clamp(prob, 0.05, 0.95);
+    qt->update_predictions(finished, probs);
+    for (size_t i = 0; i < finished.size(); i++)
+        treeResults.emplace_back(probs[i], finished[i]);
+
+    if (last) build_interpolator();
+}
+
+void StochasticQueryModel::build_interpolator() {
+    // build interpolator
+    data.clear();
+    for (long long i = 0; i < (long long)queryWinTotal.size(); i++) {
+        if (queryWinTotal[i].empty()) continue;
+
+        double rawProb = double(queryWinTotal[i][0]) / queryWinTotal[i][1];
+        double prob = shrinkFactor * rawProb + (1.0 - shrinkFactor) * priorProb;
 
-            std::vector<int> cQ = unscale_midpoint(InputOutput::index_to_coords(i, dimensions, scaledSize));
-            data.emplace_back(prob, cQ);
+        // clamp predictions to avoid extremes
+        // prob = std::clamp(prob, 0.05, 0.95);
 
-            // optional wraparound for Y-dimension
-            cQ[1] -= dimensionSize;
-            data.emplace_back(prob, cQ);
-            cQ[1] += 2 * dimensionSize;
-            data.emplace_back(prob, cQ);
-        }
+        Coordinates cQ = unscale_midpoint(InputOutput::index_to_coords(i, dimensions, scaledSize));
+        data.emplace_back(prob, cQ);
 
-        int neigh = std::clamp(0.01 * data.size(), 2.0, 8.0);
-        maper = new IDW(data, neigh, 2, 0.1);
+        // optional wraparound for Y-dimension
+        cQ[1] -= dimensionSize;
+        data.emplace_back(prob, cQ);
+        cQ[1] += 2 * dimensionSize;
+        data.emplace_back(prob, cQ);
     }
+
+    int neigh = std::clamp(0.01 * data.size(), 2.0, 8.0);
+    if (maper) delete maper;
+    maper = new IDW(data, neigh, 2, 0.1);
 }
 
 // Modified get_value_at to fallback to prior if IDW is not ready
-double StochasticQueryModel::get_value_at(const std::vector<int>& query) {
+double StochasticQueryModel::get_value_at(const Coordinates& query) {
     if (!maper) return priorProb; // fallback
     double val = maper->predict(query);
     return val;
-}
\ No newline at end of file
+}
+
+void StochasticQueryModel::evaluate_range(long long begin, long long end, double* out) {
+    if (!maper) {
+        std::fill(out, out + (end - begin), priorProb);
+        return;
+    }
+    maper->predict_range(begin, end, dimensions, dimensionSize, out);
+}
+
+void StochasticQueryModel::save_state(SnapshotWriter& out) const {
+    out.tag("StochasticQueryModel");
+    out.integer(currentQueryIDX);
+
+    // only the scaled points sampled so far
+    for (long long i = 0; i < (long long)queryWinTotal.size(); i++) {
+        if (queryWinTotal[i].empty()) continue;
+        out.integer(i);
+        out.integers(queryWinTotal[i]);
+    }
+    out.integer(-1);
+
+    // samples still in flight are handed out again after a restart
+    std::unordered_map<long long, int> outstanding;
+    for (const auto& [sample, owners] : inFlight)
+        for (long long idx : owners) outstanding[idx]++;
+
+    out.integer((long long)sampling.size());
+    for (const auto& [idx, point] : sampling) {
+        auto waiting = outstanding.find(idx);
+        out.integer(idx);
+        out.integers(point.scaledPoint);
+        out.integer(point.remaining + (waiting == outstanding.end() ? 0 : waiting->second));
+        out.integer(point.wCount);
+        out.integer(point.tCount);
+    }
+
+    out.points(treeResults, dimensions);
+}
+
+void StochasticQueryModel::load_state(SnapshotReader& in) {
+    in.expect("StochasticQueryModel");
+    currentQueryIDX = in.integer();
+
+    for (long long idx = in.integer(); idx != -1; idx = in.integer()) {
+        if (idx < 0 || idx >= (long long)queryWinTotal.size())
+            throw std::runtime_error("Stochastic snapshot point outside the scaled space");
+        queryWinTotal[idx] = in.integers();
+    }
+
+    long long points = in.integer();
+    for (long long i = 0; i < points; i++) {
+        long long idx = in.integer();
+        SampledPoint& point = sampling[idx];
+        point.scaledPoint = in.integers();
+        point.remaining = (int)in.integer();
+        point.wCount = (int)in.integer();
+        point.tCount = (int)in.integer();
+        if (point.remaining > 0 && idx != currentQueryIDX) resumed.push_back(idx);
+    }
+    std::sort(resumed.begin(), resumed.end());
+
+    treeResults = in.points(dimensions);
+    if (answeredQueries < totalQueries) {
+        for (const auto& [prob, point] : treeResults)
+            qt->update_prediction(point, prob);
+        // points still being sampled stay pending in the tree, as they were before the restart
+        for (const auto& [idx, point] : sampling)
+            qt->mark_pending(point.scaledPoint);
+    } else {
+        build_interpolator();
+    }
+}
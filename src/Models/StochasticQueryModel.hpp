@@ -4,6 +4,8 @@
 #include "Mapping/IDW.hpp"
 
 #include <unordered_map>
+#include <map>
+#include <deque>
 #include <vector>
 #include <functional>
 
@@ -11,29 +13,57 @@ class StochasticQueryModel : public Model {
 public:
     StochasticQueryModel(int dimensions, int dimensionSize, int totalQueries);
     ~StochasticQueryModel();
-    std::vector<int> get_next_query() override;
-    void update_prediction(const std::vector<int>& query, double result) override;
-    double get_value_at(const std::vector<int>& query) override;
+    Coordinates get_next_query() override;
+    void update_prediction(const Coordinates& query, double result) override;
+    double get_value_at(const Coordinates& query) override;
+    void evaluate_range(long long begin, long long end, double* out) override;
+    void update_predictions(const std::vector<Coordinates>& queries, const std::vector<double>& results) override;
+    bool supports_snapshots() const override { return true; }
+
+protected:
+    void save_state(SnapshotWriter& out) const override;
+    void load_state(SnapshotReader& in) override;
 private:
+    // Running tally for a scaled point that is still being sampled
+    struct SampledPoint {
+        Coordinates scaledPoint;
+        int remaining = 0; // samples not handed out yet
+        int wCount = 0, tCount = 0;
+    };
+
     QueryTree* qt;
     IDW* maper = nullptr;
-    std::vector<std::pair<double, std::vector<int>>> data;
+    std::vector<std::pair<double, Coordinates>> data;
     int currentQuery = 0;
-    int totalPoints = 0;
-    int repeatQueries = 0, shouldQuery = 0;
-    int wCount = 0, tCount = 0;
+    long long totalPoints = 0;
+    int shouldQuery = 0;
     double scaleRatio = 1, invScale = 1;
     int scaledSize = 1;
 
-    int currentQueryIDX;
-    std::vector<int> currentQueryPoint;
+    // Several points can be sampled at once when queries are batched, so every
+    // issued sample remembers which scaled point it belongs to.
+    long long currentQueryIDX = -1;
+    std::unordered_map<long long, SampledPoint> sampling;
+    std::map<Coordinates, std::deque<long long>> inFlight;
+    // points restored from a snapshot with samples left to hand out, asked before any new point
+    std::deque<long long> resumed;
 
     std::vector<std::vector<int>> queryWinTotal;
+
+    // every (probability, scaled point) given to the query tree, in order, so a snapshot can rebuild it
+    std::vector<std::pair<double, Coordinates>> treeResults;
     
     std::vector<std::pair<int, int>> precomputedBounds;
 
-    inline std::vector<int> lowerResolution(const std::vector<int>& rawQuery) const;
-    inline std::vector<std::pair<int,int>> get_unscaled_int_bounds(const std::vector<int>& rawQuery) const;
-    inline std::vector<int> sample_unscaled_point_from_scaled(const std::vector<int>& scaledCandidate) const;
-    inline std::vector<int> unscale_midpoint(const std::vector<int>& scaledQuery) const;
+    inline Coordinates lowerResolution(const Coordinates& rawQuery) const;
+    inline std::vector<std::pair<int,int>> get_unscaled_int_bounds(const Coordinates& rawQuery) const;
+    inline Coordinates sample_unscaled_point_from_scaled(const Coordinates& scaledCandidate) const;
+    inline Coordinates unscale_midpoint(const Coordinates& scaledQuery) const;
+
+    void record_result(const Coordinates& query, double result,
+                       std::vector<Coordinates>& finished, std::vector<double>& probs);
+    void finish_point(long long idx, SampledPoint& point,
+                      std::vector<Coordinates>& finished, std::vector<double>& probs);
+    void flush_partial_points(std::vector<Coordinates>& finished, std::vector<double>& probs);
+    void build_interpolator();
 };
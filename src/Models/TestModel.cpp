@@ -1,6 +1,9 @@
 #include "TestModel.hpp"
 
 #include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
 
 TestModel::TestModel(int dimensions, int dimensionSize, int totalQueries)
     : Model(dimensions, dimensionSize, totalQueries) 
@@ -13,23 +16,61 @@ TestModel::~TestModel(){
     if (this->qt) delete this->qt;
 }
 
-std::vector<int> TestModel::get_next_query() {
-    std::vector<int> candidate;
+Coordinates TestModel::get_next_query() {
+    Coordinates candidate;
     candidate = qt->get_next_query();
     return candidate;
 }
 
-void TestModel::update_prediction(const std::vector<int> &query, double result) {
-    currentQuery++;
+void TestModel::update_prediction(const Coordinates &query, double result) {
+    answeredQueries++;
     qt->update_prediction(query, result);
     data.emplace_back(result, query);
 
-    if (currentQuery == totalQueries) {
+    if (answeredQueries == totalQueries) {
         maper = new IDW(data, 15, 2);
     }
 }
 
-double TestModel::get_value_at(const std::vector<int> &query) {
+void TestModel::update_predictions(const std::vector<Coordinates>& queries, const std::vector<double>& results) {
+    answeredQueries += queries.size();
+    qt->update_predictions(queries, results);
+    data.reserve(data.size() + queries.size());
+    for (size_t i = 0; i < queries.size(); i++)
+        data.emplace_back(results[i], queries[i]);
+
+    if (answeredQueries == totalQueries) {
+        maper = new IDW(data, 15, 2);
+    }
+}
+
+double TestModel::get_value_at(const Coordinates &query) {
     if (maper) return maper->predict(query);
     return 0.0;
 }
+
+void TestModel::evaluate_range(long long begin, long long end, double* out) {
+    if (maper) maper->predict_range(begin, end, dimensions, dimensionSize, out);
+    else std::fill(out, out + (end - begin), 0.0);
+}
+
+void TestModel::save_state(SnapshotWriter& out) const {
+    out.tag("TestModel");
+    out.points(data, dimensions);
+}
+
+void TestModel::load_state(SnapshotReader& in) {
+    in.expect("TestModel");
+    data = in.points(dimensions);
+    if ((int)data.size() != answeredQueries)
+        throw std::runtime_error("Snapshot holds " + std::to_string(data.size()) + " results for " +
+                                 std::to_string(answeredQueries) + " answered queries");
+
+    // the tree is only needed to pick further queries, the IDW mapping only once they are all in
+    if (answeredQueries < totalQueries) {
+        for (const auto& [result, query] : data)
+            qt->update_prediction(query, result);
+    } else {
+        maper = new IDW(data, 15, 2);
+    }
+}
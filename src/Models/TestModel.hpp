@@ -9,13 +9,20 @@ class TestModel : public Model {
 public:
     TestModel(int dimensions, int dimensionSize, int totalQueries);
     ~TestModel();
-    std::vector<int> get_next_query() override;
-    void update_prediction(const std::vector<int>& query, double result) override;
-    double get_value_at(const std::vector<int>& query) override;
+    Coordinates get_next_query() override;
+    void update_prediction(const Coordinates& query, double result) override;
+    double get_value_at(const Coordinates& query) override;
+    void evaluate_range(long long begin, long long end, double* out) override;
+    void update_predictions(const std::vector<Coordinates>& queries, const std::vector<double>& results) override;
+
+    bool supports_snapshots() const override { return true; }
+
+protected:
+    void save_state(SnapshotWriter& out) const override;
+    void load_state(SnapshotReader& in) override;
 
 private:
     QueryTree* qt;
     IDW* maper = nullptr;
-    std::vector<std::pair<double, std::vector<int>>> data;
-    int currentQuery = 0;
+    std::vector<std::pair<double, Coordinates>> data; // every result, in the order received
 };
@@ -8,6 +8,8 @@
 
 #include <iostream>
 
+#include "../../StateSpace/Coordinates.hpp"
+
 struct CandidateNode {
     std::unordered_map<int, int> itemIdx;
     std::vector<std::pair<int, CandidateNode*>> itemNode;
@@ -41,7 +43,7 @@ private:
         delete node;
     }
 
-    bool addHelper(const std::vector<int>& query, CandidateNode* node, int idx) {
+    bool addHelper(const Coordinates& query, CandidateNode* node, int idx) {
         auto it = node->itemIdx.find(query[idx]);
         if (it == node->itemIdx.end()) {
             return false;
@@ -89,12 +91,12 @@ public:
     ~CandidateGenerator() { freeNode(root); }
     
 
-    void addQueriedPoint(const std::vector<int>& query){
+    void addQueriedPoint(const Coordinates& query){
         addHelper(query, root, 0);
     }
 
-    std::vector<std::vector<int>> getCandidates(int count) {
-        std::vector<std::vector<int>> candidates(count, std::vector<int>(dims));
+    std::vector<Coordinates> getCandidates(int count) {
+        std::vector<Coordinates> candidates(count, Coordinates(dims));
         std::vector<CandidateNode*> runners(count, root);
 
         for (int i = 0; i < dims; i++) {
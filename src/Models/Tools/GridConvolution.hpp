@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <vector>
+
+#include <unsupported/Eigen/FFT>
+
+#include "../../StateSpace/Coordinates.hpp"
+
+/**
+ * @brief Sums a radial kernel centred on weighted cells at every cell of a
+ * dimensionSize^dimensions grid, by FFT.
+ *
+ * The sum at every cell is the linear convolution of the grid of weights with the kernel
+ * sampled at every cell offset. Both are zero padded to n >= 2 * dimensionSize - 1 points per
+ * axis so the circular convolution of the FFT never wraps, which costs O(n^D log n) however
+ * many centres there are.
+ */
+class GridConvolution {
+private:
+    int dimensions;
+    int dimensionSize;
+    int n; // padded points per axis, only factors 2, 3 and 5 for a fast transform
+    long long total;
+    Eigen::FFT<double> fft;
+
+    // transforms every line along axis in place, all-zero lines stay zero and are skipped
+    void transform(std::vector<std::complex<double>>& values, int axis, bool inverse) {
+        long long stride = 1;
+        for (int d = dimensions - 1; d > axis; --d) stride *= n;
+        std::vector<std::complex<double>> line(n), result(n);
+        for (long long block = 0; block < total; block += stride * n) {
+            for (long long offset = 0; offset < stride; ++offset) {
+                const long long start = block + offset;
+                bool zero = true;
+                for (int i = 0; i < n; ++i) {
+                    line[i] = values[start + i * stride];
+                    zero = zero && line[i] == 0.0;
+                }
+                if (zero) continue;
+                if (inverse) fft.inv(result, line);
+                else fft.fwd(result, line);
+                for (int i = 0; i < n; ++i) values[start + i * stride] = result[i];
+            }
+        }
+    }
+
+public:
+    GridConvolution(int dimensions, int dimensionSize)
+        : dimensions(dimensions), dimensionSize(dimensionSize), n(2 * dimensionSize - 1), total(1)
+    {
+        auto smooth = [](int m) {
+            for (int f : {2, 3, 5}) while (m % f == 0) m /= f;
+            return m == 1;
+        };
+        while (!smooth(n)) ++n;
+        for (int d = 0; d < dimensions; ++d) total *= n;
+    }
+
+    /** @brief Points of each padded grid, the convolution holds two of them as complex values. */
+    long long padded_points() const { return total; }
+
+    /**
+     * @brief out[cell] = sum of weights[i] * kernel(squared offset in cells from centres[i]),
+     * for every cell in row-major order.
+     * @return an estimate of the largest absolute round-off error of any cell
+     */
+    template <typename Kernel>
+    double convolve(const std::vector<Coordinates>& centres, const std::vector<double>& weights,
+                    Kernel kernel, std::vector<double>& out) {
+        const int K = dimensionSize;
+        std::vector<std::complex<double>> w(total), k(total);
+        double wNorm = 0.0, kNorm = 0.0;
+        for (size_t i = 0; i < centres.size(); ++i) {
+            long long index = 0;
+            for (int d = 0; d < dimensions; ++d) index = index * n + centres[i][d];
+            w[index] += weights[i];
+            wNorm += weights[i] * weights[i];
+        }
+
+        // kernel at every offset in [-(K - 1), K - 1]^D, negative offsets wrap to the top
+        std::vector<int> offset(dimensions, -(K - 1));
+        while (true) {
+            long long index = 0;
+            double squared = 0.0;
+            for (int d = 0; d < dimensions; ++d) {
+                index = index * n + (offset[d] < 0 ? n + offset[d] : offset[d]);
+                squared += (double)offset[d] * offset[d];
+            }
+            double value = kernel(squared);
+            k[index] = value;
+            kNorm += value * value;
+
+            int d = dimensions - 1;
+            while (d >= 0 && offset[d] == K - 1) offset[d--] = -(K - 1);
+            if (d < 0) break;
+            ++offset[d];
+        }
+
+        for (int d = dimensions - 1; d >= 0; --d) {
+            transform(w, d, false);
+            transform(k, d, false);
+        }
+        for (long long i = 0; i < total; ++i) w[i] *= k[i];
+        k = {};
+        for (int d = dimensions - 1; d >= 0; --d) transform(w, d, true);
+
+        long long cells = 1;
+        for (int d = 0; d < dimensions; ++d) cells *= K;
+        out.resize(cells);
+        std::vector<int> cell(dimensions, 0);
+        for (long long c = 0; c < cells; ++c) {
+            long long index = 0;
+            for (int d = 0; d < dimensions; ++d) index = index * n + cell[d];
+            out[c] = w[index].real();
+            for (int d = dimensions - 1; d >= 0 && ++cell[d] == K; --d) cell[d] = 0;
+        }
+
+        // round-off of an FFT convolution grows with log n and the 2-norms of both inputs
+        return std::numeric_limits<double>::epsilon() * std::log2((double)total)
+             * std::sqrt(wNorm) * std::sqrt(kNorm);
+    }
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+
+#include "../../StateSpace/Coordinates.hpp"
+
+/**
+ * @brief Walks the cells of a dimensionSize^dimensions grid in row-major order (last
+ * coordinate fastest) without allocating per cell.
+ */
+class GridOdometer {
+private:
+    int dimensionSize;
+    Coordinates current;
+
+public:
+    GridOdometer(int dimensions, int dimensionSize, long long index)
+        : dimensionSize(dimensionSize), current(dimensions, 0)
+    {
+        for (int d = dimensions - 1; d >= 0; --d) {
+            current[d] = index % dimensionSize;
+            index /= dimensionSize;
+        }
+    }
+
+    const Coordinates& coords() const { return current; }
+
+    /**
+     * @brief Step to the next cell.
+     * @return the outermost axis whose coordinate changed, so dimensions-1 means only the
+     * last coordinate moved by one
+     */
+    int next() {
+        int d = (int)current.size() - 1;
+        while (d > 0 && current[d] == dimensionSize - 1) {
+            current[d] = 0;
+            --d;
+        }
+        ++current[d];
+        return d;
+    }
+};
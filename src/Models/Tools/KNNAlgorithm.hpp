@@ -4,15 +4,19 @@
 #include <cmath>
 #include <algorithm>
 #include <limits>
+#include <numeric>
+#include <stdexcept>
+#include "../../StateSpace/Coordinates.hpp"
 
 struct KDNode {
-    std::vector<int> point;
+    Coordinates point;
     double value;
+    int index; // position in the data the tree was built from, breaks distance ties
     KDNode* left;
     KDNode* right;
 
-    KDNode(const std::vector<int>& pt, double val)
-        : point(pt), value(val), left(nullptr), right(nullptr) {}
+    KDNode(const Coordinates& pt, double val, int idx)
+        : point(pt), value(val), index(idx), left(nullptr), right(nullptr) {}
 };
 
 class KNNTree {
@@ -20,90 +24,144 @@ public:
     struct KDResult {
         double distance;
         double value;
-        std::vector<int> point;
+        Coordinates point;
     };
 
-    KNNTree(const std::vector<std::pair<double, std::vector<int>>>& data) {
-        root = build(data, 0);
+    /**
+     * @brief A neighbour without a copy of its coordinates. Ordered by (distance, index)
+     * so the K nearest are the same set whatever order the tree is walked in.
+     */
+    struct Neighbour {
+        double distance;
+        double value;
+        int index;
+
+        bool operator<(const Neighbour& other) const {
+            return distance < other.distance || (distance == other.distance && index < other.index);
+        }
+    };
+
+    /**
+     * @brief Opt-in approximate search, for high dimensions where an exact one visits most nodes.
+     * Every neighbour returned is within (1 + epsilon) of the distance of the true one, and
+     * after maxChecks points (0 for no limit) no further branches are explored.
+     */
+    struct Approximation {
+        double epsilon = 0.0;
+        int maxChecks = 0;
+    };
+
+    KNNTree(const std::vector<std::pair<double, Coordinates>>& data) {
+        std::vector<int> order(data.size());
+        std::iota(order.begin(), order.end(), 0);
+        nodes.resize(data.size(), nullptr);
+        root = build(data, order, 0, (int)order.size(), 0);
     }
 
     ~KNNTree() {
         destroy(root);
     }
 
-    std::vector<KDResult> getKNearest(const std::vector<int>& query, int K) const {
-        if (!root || K <= 0) return {}; // no tree or invalid K
-
-        std::priority_queue<std::pair<double, KDNode*>> best; // (distance, node)
-        search(root, query, K, 0, best);
+    std::vector<KDResult> getKNearest(const Coordinates& query, int K) const {
+        std::vector<Neighbour> found;
+        getKNearest(query, K, found);
 
         std::vector<KDResult> result;
-        result.reserve(std::min(K, (int)best.size()));
-
-        while (!best.empty()) {
-            auto [dist, node] = best.top();
-            best.pop();
-            result.push_back({ dist, node->value, node->point });
-        }
-
-        std::reverse(result.begin(), result.end());
+        result.reserve(found.size());
+        for (const Neighbour& n : found)
+            result.push_back({ n.distance, n.value, nodes[n.index]->point });
         return result;
     }
 
+    /**
+     * @brief Fill out with the K nearest points to query, nearest first, reusing its storage.
+     *
+     * Points further than maxDistance are ignored. A caller that knows K points lie within
+     * some radius (e.g. from the neighbouring cell) passes it to prune most of the tree.
+     */
+    void getKNearest(const Coordinates& query, int K, std::vector<Neighbour>& out,
+                     double maxDistance = std::numeric_limits<double>::infinity()) const {
+        out.clear();
+        if (!root || K <= 0) return; // no tree or invalid K
+
+        // out is kept as a max-heap on (distance, index) while searching
+        int checksLeft = approximation.maxChecks > 0 ? approximation.maxChecks : std::numeric_limits<int>::max();
+        search(root, query, K, 0, maxDistance, out, checksLeft);
+        std::sort_heap(out.begin(), out.end());
+    }
 
+    /**
+     * @brief Make getKNearest approximate, or exact again with the default Approximation.
+     */
+    void setApproximation(const Approximation& approximation) {
+        if (approximation.epsilon < 0.0 || approximation.maxChecks < 0)
+            throw std::invalid_argument("Approximation needs epsilon >= 0 and maxChecks >= 0");
+        this->approximation = approximation;
+    }
 
+    const Approximation& getApproximation() const { return approximation; }
 
 private:
     KDNode* root = nullptr;
+    std::vector<KDNode*> nodes; // by data index
+    Approximation approximation; // exact by default
 
-    static double distance(const std::vector<int>& a, const std::vector<int>& b) {
+    static double distance(const Coordinates& a, const Coordinates& b) {
         double sum = 0.0;
         for (size_t i = 0; i < a.size(); ++i)
             sum += (a[i] - b[i]) * (a[i] - b[i]);
         return std::sqrt(sum);
     }
 
-    KDNode* build(std::vector<std::pair<double, std::vector<int>>> data, int depth) {
-        if (data.empty()) return nullptr;
+    KDNode* build(const std::vector<std::pair<double, Coordinates>>& data, std::vector<int>& order,
+                  int begin, int end, int depth) {
+        if (begin >= end) return nullptr;
 
         size_t axis = depth % data[0].second.size();
-        std::sort(data.begin(), data.end(),
-            [axis](const auto& a, const auto& b) {
-                return a.second[axis] < b.second[axis];
+        int median = begin + (end - begin) / 2;
+        std::nth_element(order.begin() + begin, order.begin() + median, order.begin() + end,
+            [&data, axis](int a, int b) {
+                return data[a].second[axis] < data[b].second[axis];
             });
 
-        size_t median = data.size() / 2;
-        KDNode* node = new KDNode(data[median].second, data[median].first);
-
-        std::vector<std::pair<double, std::vector<int>>> left(data.begin(), data.begin() + median);
-        std::vector<std::pair<double, std::vector<int>>> right(data.begin() + median + 1, data.end());
+        int idx = order[median];
+        KDNode* node = new KDNode(data[idx].second, data[idx].first, idx);
+        nodes[idx] = node;
 
-        node->left = build(left, depth + 1);
-        node->right = build(right, depth + 1);
+        node->left = build(data, order, begin, median, depth + 1);
+        node->right = build(data, order, median + 1, end, depth + 1);
         return node;
     }
 
-    void search(KDNode* node, const std::vector<int>& query, int K, int depth,
-                std::priority_queue<std::pair<double, KDNode*>>& best) const {
+    void search(KDNode* node, const Coordinates& query, int K, int depth, double maxDistance,
+                std::vector<Neighbour>& best, int& checksLeft) const {
         if (!node) return;
 
         double dist = distance(query, node->point);
-        if ((int)best.size() < K)
-            best.push({ dist, node });
-        else if (dist < best.top().first) {
-            best.pop();
-            best.push({ dist, node });
+        --checksLeft;
+        if (dist <= maxDistance) {
+            Neighbour candidate{ dist, node->value, node->index };
+            if ((int)best.size() < K) {
+                best.push_back(candidate);
+                std::push_heap(best.begin(), best.end());
+            } else if (candidate < best.front()) {
+                std::pop_heap(best.begin(), best.end());
+                best.back() = candidate;
+                std::push_heap(best.begin(), best.end());
+            }
         }
 
         size_t axis = depth % query.size();
         KDNode* next = (query[axis] < node->point[axis]) ? node->left : node->right;
         KDNode* other = (query[axis] < node->point[axis]) ? node->right : node->left;
 
-        search(next, query, K, depth + 1, best);
+        search(next, query, K, depth + 1, maxDistance, best, checksLeft);
 
-        // Check if we need to search the other side
-        if ((int)best.size() < K || std::abs(query[axis] - node->point[axis]) < best.top().first)
-            search(other, query, K, depth + 1, best);
+        // Check if we need to search the other side, ties included so the index tie-break holds
+        double diff = std::abs(query[axis] - node->point[axis]);
+        if (checksLeft > 0 && diff <= maxDistance &&
+            ((int)best.size() < K || diff * (1.0 + approximation.epsilon) <= best.front().distance))
+            search(other, query, K, depth + 1, maxDistance, best, checksLeft);
     }
 
     void destroy(KDNode* node) {
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../../StateSpace/Coordinates.hpp"
+
+/**
+ * @brief Binary encoding of a model's state for checkpoints, see Model::save_snapshot.
+ *
+ * Every field is little-endian: integers as int64, reals as IEEE f64, vectors as an int64
+ * length followed by their elements. Arrays go through in one block on little-endian hosts,
+ * so a snapshot of a trained model loads at about the speed of the disk.
+ */
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(std::ostream& out) : out(out) {}
+
+    void integer(long long value) { put(&value, 1); }
+    void real(double value) { put(&value, 1); }
+    void tag(const std::string& name) {
+        integer((long long)name.size());
+        out.write(name.data(), (std::streamsize)name.size());
+    }
+
+    /**
+     * @brief Any sized range of ints, such as std::vector<int> or Coordinates.
+     */
+    template <typename Ints>
+    void integers(const Ints& values) {
+        integer((long long)values.size());
+        std::vector<long long> wide(values.begin(), values.end());
+        put(wide.data(), wide.size());
+    }
+
+    void reals(const std::vector<double>& values) {
+        integer((long long)values.size());
+        put(values.data(), values.size());
+    }
+
+    /**
+     * @brief (value, coordinates) pairs of equal dimension, as stored by the models and mappings.
+     */
+    void points(const std::vector<std::pair<double, Coordinates>>& values, int dimensions) {
+        integer((long long)values.size());
+        std::vector<double> results;
+        std::vector<long long> coords;
+        results.reserve(values.size());
+        coords.reserve(values.size() * dimensions);
+        for (const auto& [value, point] : values) {
+            if ((int)point.size() != dimensions)
+                throw std::invalid_argument("Snapshot point has the wrong dimension");
+            results.push_back(value);
+            coords.insert(coords.end(), point.begin(), point.end());
+        }
+        put(results.data(), results.size());
+        put(coords.data(), coords.size());
+    }
+
+private:
+    std::ostream& out;
+
+    template <typename T>
+    void put(const T* values, std::size_t count) {
+        static_assert(sizeof(T) == 8);
+        if constexpr (std::endian::native == std::endian::little) {
+            out.write(reinterpret_cast<const char*>(values), (std::streamsize)(count * 8));
+        } else {
+            for (std::size_t i = 0; i < count; ++i) {
+                std::uint64_t bits;
+                std::memcpy(&bits, values + i, 8);
+                unsigned char le[8];
+                for (int b = 0; b < 8; ++b) le[b] = (unsigned char)(bits >> (8 * b));
+                out.write(reinterpret_cast<const char*>(le), 8);
+            }
+        }
+        if (!out) throw std::runtime_error("Failed to write snapshot");
+    }
+};
+
+/**
+ * @brief Reads what SnapshotWriter wrote, throwing std::runtime_error on truncated or foreign data.
+ */
+class SnapshotReader {
+public:
+    explicit SnapshotReader(std::istream& in) : in(in) {}
+
+    long long integer() { long long v; get(&v, 1); return v; }
+    double real() { double v; get(&v, 1); return v; }
+
+    /**
+     * @brief Read a tag and check it is the expected one.
+     */
+    void expect(const std::string& name) {
+        long long size = integer();
+        std::string found(size == (long long)name.size() ? name.size() : 0, '\0');
+        if (!found.empty()) in.read(found.data(), (std::streamsize)found.size());
+        if (!in || found != name)
+            throw std::runtime_error("Snapshot is not a " + name + " snapshot");
+    }
+
+    std::vector<int> integers() {
+        std::vector<long long> wide(length());
+        get(wide.data(), wide.size());
+        return std::vector<int>(wide.begin(), wide.end());
+    }
+
+    std::vector<double> reals() {
+        std::vector<double> values(length());
+        get(values.data(), values.size());
+        return values;
+    }
+
+    std::vector<std::pair<double, Coordinates>> points(int dimensions) {
+        std::size_t count = length();
+        std::vector<double> results(count);
+        std::vector<long long> coords(count * dimensions);
+        get(results.data(), results.size());
+        get(coords.data(), coords.size());
+
+        std::vector<std::pair<double, Coordinates>> values;
+        values.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+            values.emplace_back(results[i], Coordinates(coords.begin() + i * dimensions,
+                                                             coords.begin() + (i + 1) * dimensions));
+        return values;
+    }
+
+private:
+    std::istream& in;
+
+    std::size_t length() {
+        long long size = integer();
+        if (size < 0 || size > (1LL << 40)) throw std::runtime_error("Corrupt snapshot");
+        return (std::size_t)size;
+    }
+
+    template <typename T>
+    void get(T* values, std::size_t count) {
+        static_assert(sizeof(T) == 8);
+        in.read(reinterpret_cast<char*>(values), (std::streamsize)(count * 8));
+        if (!in) throw std::runtime_error("Snapshot is truncated");
+        if constexpr (std::endian::native != std::endian::little) {
+            for (std::size_t i = 0; i < count; ++i) {
+                unsigned char le[8];
+                std::memcpy(le, values + i, 8);
+                std::uint64_t bits = 0;
+                for (int b = 0; b < 8; ++b) bits |= (std::uint64_t)le[b] << (8 * b);
+                std::memcpy(values + i, &bits, 8);
+            }
+        }
+    }
+};
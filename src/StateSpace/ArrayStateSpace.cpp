@@ -1,12 +1,25 @@
 #include "ArrayStateSpace.hpp"
+#include "../InputOutput/BinaryStateWriter.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
 #include <string>
+#include <utility>
 
-int ArrayStateSpace::coords_to_index(const std::vector<int>& coords) const {
+#if defined(__unix__) || defined(__APPLE__)
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+    #define MASS_HAVE_MMAP 1
+#endif
+
+long long ArrayStateSpace::coords_to_index(const Coordinates& coords) const {
     if (coords.size() != this->dimensions) 
         throw std::invalid_argument("Index has Invalid Number of Dimensions");
-    int rawIndex = 0;
-    int multiplier = 1;
+    long long rawIndex = 0;
+    long long multiplier = 1;
     for (int i = dimensions - 1; i > -1; i--) {
         if (coords[i] < 0 || coords[i] >= this->dimensionSize) 
             throw std::out_of_range("Coordinate at index [" + std::to_string(i) + "] out of range");
@@ -17,10 +30,55 @@ int ArrayStateSpace::coords_to_index(const std::vector<int>& coords) const {
 }
 
 ArrayStateSpace::ArrayStateSpace(int dimensions, int dimensionSize, double initialValues) :
-        StateSpace(dimensions, dimensionSize),
-        stateSpaceArray(std::pow(dimensionSize, dimensions), initialValues)
+        DenseStateSpace(dimensions, dimensionSize),
+        memory(cell_count(dimensions, dimensionSize), initialValues),
+        stateSpaceArray(memory)
+    {}
+
+ArrayStateSpace::ArrayStateSpace(int dimensions, int dimensionSize, const std::string& path, Access access,
+                                 double initialValues) :
+        DenseStateSpace(dimensions, dimensionSize)
+{
+    map_file(path);
+    advise(access);
+    // a new file reads as zeros, other values have to touch every page
+    if (initialValues != 0.0) std::fill(stateSpaceArray.begin(), stateSpaceArray.end(), initialValues);
+}
+
+ArrayStateSpace::ArrayStateSpace(const ArrayStateSpace& other) :
+        DenseStateSpace(other),
+        memory(other.stateSpaceArray.begin(), other.stateSpaceArray.end()),
+        stateSpaceArray(memory)
+    {}
+
+ArrayStateSpace::ArrayStateSpace(ArrayStateSpace&& other) noexcept :
+        DenseStateSpace(other),
+        memory(std::move(other.memory)),
+        mapping(std::exchange(other.mapping, nullptr)),
+        mappingSize(std::exchange(other.mappingSize, 0)),
+        stateSpaceArray(std::exchange(other.stateSpaceArray, {}))
     {}
 
+ArrayStateSpace& ArrayStateSpace::operator=(const ArrayStateSpace& other) {
+    if (this != &other) *this = ArrayStateSpace(other);
+    return *this;
+}
+
+ArrayStateSpace& ArrayStateSpace::operator=(ArrayStateSpace&& other) noexcept {
+    if (this == &other) return *this;
+    unmap();
+    StateSpace::operator=(other);
+    memory = std::move(other.memory);
+    mapping = std::exchange(other.mapping, nullptr);
+    mappingSize = std::exchange(other.mappingSize, 0);
+    stateSpaceArray = std::exchange(other.stateSpaceArray, {});
+    return *this;
+}
+
+ArrayStateSpace::~ArrayStateSpace() {
+    unmap();
+}
+
 
 int ArrayStateSpace::get_dimensions() const {
     return this->dimensions;
@@ -30,14 +88,70 @@ int ArrayStateSpace::get_dimension_size() const {
     return this->dimensionSize;
 }
 
-double ArrayStateSpace::get(const std::vector<int>& coords) const {
+double ArrayStateSpace::get(const Coordinates& coords) const {
     return this->stateSpaceArray[coords_to_index(coords)];
 }
 
 std::vector<double> ArrayStateSpace::get_raw_representation() const {
-    return this->stateSpaceArray;
+    return {this->stateSpaceArray.begin(), this->stateSpaceArray.end()};
 }
 
-double ArrayStateSpace::set(const std::vector<int>& coords, double value) {
+double ArrayStateSpace::set(const Coordinates& coords, double value) {
     return this->stateSpaceArray[coords_to_index(coords)] = value;
-}
\ No newline at end of file
+}
+
+void ArrayStateSpace::advise(Access access) {
+#ifdef MASS_HAVE_MMAP
+    if (mapping) ::madvise(mapping, mappingSize, access == SEQUENTIAL ? MADV_SEQUENTIAL : MADV_RANDOM);
+#else
+    (void)access;
+#endif
+}
+
+void ArrayStateSpace::flush() {
+#ifdef MASS_HAVE_MMAP
+    if (mapping && ::msync(mapping, mappingSize, MS_SYNC) != 0)
+        throw std::runtime_error("Failed to write the state space file: " + std::string(std::strerror(errno)));
+#endif
+}
+
+void ArrayStateSpace::map_file(const std::string& path) {
+#ifdef MASS_HAVE_MMAP
+    const long long cells = cell_count(dimensions, dimensionSize);
+    const std::size_t total = BinaryStateWriter::HEADER_SIZE + (std::size_t)cells * sizeof(double);
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        throw std::runtime_error("Failed to open " + path + ": " + std::strerror(errno));
+    if (::ftruncate(fd, (off_t)total) != 0) {
+        int error = errno;
+        ::close(fd);
+        throw std::runtime_error("Failed to size " + path + ": " + std::strerror(error));
+    }
+
+    void* region = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int error = errno;
+    ::close(fd); // the mapping keeps the file alive
+    if (region == MAP_FAILED)
+        throw std::runtime_error("Failed to map " + path + ": " + std::strerror(error));
+
+    mapping = static_cast<unsigned char*>(region);
+    mappingSize = total;
+    BinaryStateWriter::encode_header(mapping, dimensions, dimensionSize, BinaryStateWriter::FLOAT64);
+    // the 32 byte header keeps the cells 8 byte aligned on the page aligned mapping
+    stateSpaceArray = {reinterpret_cast<double*>(mapping + BinaryStateWriter::HEADER_SIZE), (std::size_t)cells};
+#else
+    throw std::runtime_error("File-backed state spaces are not supported on this platform, cannot map " + path);
+#endif
+}
+
+void ArrayStateSpace::unmap() {
+#ifdef MASS_HAVE_MMAP
+    if (mapping) {
+        ::munmap(mapping, mappingSize);
+        mapping = nullptr;
+        mappingSize = 0;
+        stateSpaceArray = {};
+    }
+#endif
+}
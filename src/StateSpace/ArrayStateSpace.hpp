@@ -11,28 +11,84 @@ Implements a ArrayStateSpace class that allows for interactions with an n-dimens
 #include <vector>
 #include <iostream>
 #include <cmath>
+#include <cstddef>
+#include <span>
+#include <string>
 
-#include "StateSpace.hpp"
+#include "DenseStateSpace.hpp"
+
+class ArrayStateSpace : public DenseStateSpace {
+public:
+    /**
+     * @brief How a file-backed state space will be read, passed on to the kernel as a paging hint.
+     */
+    enum Access { SEQUENTIAL, RANDOM };
 
-class ArrayStateSpace : public StateSpace {
 private:
-    std::vector<double> stateSpaceArray;
-    
-    int coords_to_index(const std::vector<int>& coords) const;
+    std::vector<double> memory;
+    unsigned char* mapping = nullptr;
+    std::size_t mappingSize = 0;
+
+protected:
+    // the cells, in memory or in the mapped file
+    std::span<double> stateSpaceArray;
+
+private:
+    long long coords_to_index(const Coordinates& coords) const;
+    void map_file(const std::string& path);
+    void unmap();
 
 public:
     ArrayStateSpace(int dimensions, int dimensionSize, double initialValues = 0.0);
 
+    /**
+     * @brief A state space stored in a memory-mapped file at path, replacing any file there,
+     * so grids larger than RAM are paged in and out by the OS.
+     *
+     * The file has the layout of BinaryStateWriter FLOAT64 output (header, then the cells in
+     * native byte order), so on little-endian hosts it is itself the final f64 state space.
+     * Throws std::runtime_error where files cannot be mapped.
+     */
+    ArrayStateSpace(int dimensions, int dimensionSize, const std::string& path, Access access = RANDOM,
+                    double initialValues = 0.0);
+
+    // copies are held in memory, moves keep the mapping
+    ArrayStateSpace(const ArrayStateSpace& other);
+    ArrayStateSpace(ArrayStateSpace&& other) noexcept;
+    ArrayStateSpace& operator=(const ArrayStateSpace& other);
+    ArrayStateSpace& operator=(ArrayStateSpace&& other) noexcept;
+    ~ArrayStateSpace() override;
+
     int get_dimensions() const override;
 
     int get_dimension_size() const override;
     
-    double get(const std::vector<int>& coords) const override;
+    double get(const Coordinates& coords) const override;
 
-    std::vector<double> get_raw_representation() const;
+    std::vector<double> get_raw_representation() const override;
+
+    /**
+     * @brief The cells in row-major order (last coordinate fastest), without copying them.
+     */
+    std::span<const double> raw_view() const { return stateSpaceArray; }
+    std::span<double> raw_view() { return stateSpaceArray; }
+
+    double set(const Coordinates& coords, double value) override;
+
+    bool is_file_backed() const { return mapping != nullptr; }
+
+    /**
+     * @brief Change the paging hint of a file-backed state space, e.g. RANDOM while the model
+     * fills it and SEQUENTIAL for a final pass. Does nothing in memory.
+     */
+    void advise(Access access);
+
+    /**
+     * @brief Write the dirty pages of a file-backed state space to the file and wait for them.
+     * Unmapping writes them too, flush makes the file complete while the state space is in use.
+     */
+    void flush();
 
-    double set(const std::vector<int>& coords, double value);
-    
 };
 
 #endif // ARRAY_STATE_SPACE_H
\ No newline at end of file
@@ -0,0 +1,168 @@
+/**
+ * @file ArrayStateSpaceN.hpp
+ * @brief Declares ArrayStateSpaceN, an ArrayStateSpace whose number of dimensions is fixed at compile time.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef ARRAY_STATE_SPACE_N_H
+#define ARRAY_STATE_SPACE_N_H
+
+#include <array>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ArrayStateSpace.hpp"
+#include "PackedArrayStateSpace.hpp"
+
+/**
+ * @brief A D dimensional ArrayStateSpace addressed by std::array coordinates.
+ *
+ * The strides are computed once and the index loops have a constant trip count, so they are
+ * fully unrolled. at() checks the coordinates like ArrayStateSpace::get, operator[] does not
+ * and is meant for loops that already stay inside the grid. The Coordinates interface of
+ * ArrayStateSpace still works, and goes through the same unrolled indexing.
+ */
+template <int D>
+class ArrayStateSpaceN : public ArrayStateSpace {
+    static_assert(D >= 1, "a state space needs at least one dimension");
+
+public:
+    using Coords = std::array<int, D>;
+
+    explicit ArrayStateSpaceN(int dimensionSize, double initialValues = 0.0)
+        : ArrayStateSpace(D, dimensionSize, initialValues)
+    {
+        init_strides();
+    }
+
+    /**
+     * @brief A file-backed ArrayStateSpaceN, see the matching ArrayStateSpace constructor.
+     */
+    ArrayStateSpaceN(int dimensionSize, const std::string& path, Access access = RANDOM, double initialValues = 0.0)
+        : ArrayStateSpace(D, dimensionSize, path, access, initialValues)
+    {
+        init_strides();
+    }
+
+    /**
+     * @brief Row-major index of coords, which must lie inside the grid.
+     */
+    long long index(const Coords& coords) const noexcept {
+        long long rawIndex = 0;
+        for (int d = 0; d < D; ++d) rawIndex += coords[d] * strides[d];
+        return rawIndex;
+    }
+
+    double at(const Coords& coords) const { return stateSpaceArray[checked_index(coords)]; }
+    double& at(const Coords& coords) { return stateSpaceArray[checked_index(coords)]; }
+
+    double operator[](const Coords& coords) const noexcept { return stateSpaceArray[index(coords)]; }
+    double& operator[](const Coords& coords) noexcept { return stateSpaceArray[index(coords)]; }
+
+    double get(const Coordinates& coords) const override {
+        if (coords.size() != D)
+            throw std::invalid_argument("Index has Invalid Number of Dimensions");
+        return stateSpaceArray[checked_index(coords)];
+    }
+
+    double set(const Coordinates& coords, double value) override {
+        if (coords.size() != D)
+            throw std::invalid_argument("Index has Invalid Number of Dimensions");
+        return stateSpaceArray[checked_index(coords)] = value;
+    }
+
+private:
+    std::array<long long, D> strides;
+
+    void init_strides() {
+        long long stride = 1;
+        for (int d = D - 1; d >= 0; --d) {
+            strides[d] = stride;
+            stride *= dimensionSize;
+        }
+    }
+
+    // bounds check and index in one unrolled pass, for std::array or Coordinates
+    template <typename C>
+    long long checked_index(const C& coords) const {
+        long long rawIndex = 0;
+        for (int d = 0; d < D; ++d) {
+            if (coords[d] < 0 || coords[d] >= dimensionSize)
+                throw std::out_of_range("Coordinate at index [" + std::to_string(d) + "] out of range");
+            rawIndex += coords[d] * strides[d];
+        }
+        return rawIndex;
+    }
+};
+
+/**
+ * @brief An ArrayStateSpaceN for 1 to 8 dimensions, the generic ArrayStateSpace otherwise.
+ */
+inline std::unique_ptr<ArrayStateSpace> make_array_state_space(int dimensions, int dimensionSize, double initialValues = 0.0) {
+    switch (dimensions) {
+        case 1: return std::make_unique<ArrayStateSpaceN<1>>(dimensionSize, initialValues);
+        case 2: return std::make_unique<ArrayStateSpaceN<2>>(dimensionSize, initialValues);
+        case 3: return std::make_unique<ArrayStateSpaceN<3>>(dimensionSize, initialValues);
+        case 4: return std::make_unique<ArrayStateSpaceN<4>>(dimensionSize, initialValues);
+        case 5: return std::make_unique<ArrayStateSpaceN<5>>(dimensionSize, initialValues);
+        case 6: return std::make_unique<ArrayStateSpaceN<6>>(dimensionSize, initialValues);
+        case 7: return std::make_unique<ArrayStateSpaceN<7>>(dimensionSize, initialValues);
+        case 8: return std::make_unique<ArrayStateSpaceN<8>>(dimensionSize, initialValues);
+        default: return std::make_unique<ArrayStateSpace>(dimensions, dimensionSize, initialValues);
+    }
+}
+
+/**
+ * @brief make_array_state_space backed by a memory-mapped file at path.
+ */
+inline std::unique_ptr<ArrayStateSpace> make_array_state_space(int dimensions, int dimensionSize, const std::string& path,
+                                                               ArrayStateSpace::Access access = ArrayStateSpace::RANDOM,
+                                                               double initialValues = 0.0) {
+    switch (dimensions) {
+        case 1: return std::make_unique<ArrayStateSpaceN<1>>(dimensionSize, path, access, initialValues);
+        case 2: return std::make_unique<ArrayStateSpaceN<2>>(dimensionSize, path, access, initialValues);
+        case 3: return std::make_unique<ArrayStateSpaceN<3>>(dimensionSize, path, access, initialValues);
+        case 4: return std::make_unique<ArrayStateSpaceN<4>>(dimensionSize, path, access, initialValues);
+        case 5: return std::make_unique<ArrayStateSpaceN<5>>(dimensionSize, path, access, initialValues);
+        case 6: return std::make_unique<ArrayStateSpaceN<6>>(dimensionSize, path, access, initialValues);
+        case 7: return std::make_unique<ArrayStateSpaceN<7>>(dimensionSize, path, access, initialValues);
+        case 8: return std::make_unique<ArrayStateSpaceN<8>>(dimensionSize, path, access, initialValues);
+        default: return std::make_unique<ArrayStateSpace>(dimensions, dimensionSize, path, access, initialValues);
+    }
+}
+
+/**
+ * @brief How a dense model stores its state space.
+ */
+struct DenseStorage {
+    enum CellType { F64, F32, BF16, F16, U16 };
+    CellType cellType = F64;
+    // when set, the cells are kept in a memory-mapped file there instead of in memory, F64 only
+    std::string path;
+    ArrayStateSpace::Access access = ArrayStateSpace::RANDOM;
+};
+
+/**
+ * @brief make_array_state_space for F64 cells, in the file at storage.path when one is given,
+ * a PackedArrayStateSpace of the cell type otherwise.
+ */
+inline std::unique_ptr<DenseStateSpace> make_dense_state_space(int dimensions, int dimensionSize,
+                                                               const DenseStorage& storage, double initialValues = 0.0) {
+    if (!storage.path.empty()) {
+        if (storage.cellType != DenseStorage::F64)
+            throw std::invalid_argument("Only f64 state spaces can be backed by a file");
+        return make_array_state_space(dimensions, dimensionSize, storage.path, storage.access, initialValues);
+    }
+    switch (storage.cellType) {
+        case DenseStorage::F32: return std::make_unique<PackedArrayStateSpace<float>>(dimensions, dimensionSize, initialValues);
+        case DenseStorage::BF16: return std::make_unique<PackedArrayStateSpace<BFloat16>>(dimensions, dimensionSize, initialValues);
+        case DenseStorage::F16: return std::make_unique<PackedArrayStateSpace<Half>>(dimensions, dimensionSize, initialValues);
+        case DenseStorage::U16: return std::make_unique<PackedArrayStateSpace<UNorm16>>(dimensions, dimensionSize, initialValues);
+        default: return make_array_state_space(dimensions, dimensionSize, initialValues);
+    }
+}
+
+#endif // ARRAY_STATE_SPACE_N_H
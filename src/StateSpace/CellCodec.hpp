@@ -0,0 +1,147 @@
+/**
+ * @file CellCodec.hpp
+ * @brief Declares the reduced-precision cell types and their conversions to and from double.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef CELL_CODEC_H
+#define CELL_CODEC_H
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#define MASS_HAVE_F16C 1
+#endif
+
+/**
+ * @brief bfloat16, the top half of a float: float's range with an 8 bit mantissa.
+ */
+struct BFloat16 { std::uint16_t bits; };
+
+/**
+ * @brief IEEE 754 binary16: 5 bit exponent, 10 bit mantissa, largest finite value 65504.
+ */
+struct Half { std::uint16_t bits; };
+
+/**
+ * @brief 16-bit fixed point over [0, 1] in steps of 1/65535, values outside are clamped.
+ * Exact enough for the normalised function values and probabilities the models produce.
+ */
+struct UNorm16 { std::uint16_t bits; };
+
+/**
+ * @brief encode(double) and decode(cell) for every cell type. Conversions round to nearest,
+ * the 16-bit float types round through float.
+ */
+template <typename Cell>
+struct CellCodec;
+
+template <>
+struct CellCodec<double> {
+    static double encode(double value) { return value; }
+    static double decode(double cell) { return cell; }
+};
+
+template <>
+struct CellCodec<float> {
+    static float encode(double value) { return (float)value; }
+    static double decode(float cell) { return cell; }
+};
+
+template <>
+struct CellCodec<BFloat16> {
+    static BFloat16 encode(double value) {
+        std::uint32_t x = std::bit_cast<std::uint32_t>((float)value);
+        if ((x & 0x7fffffffu) > 0x7f800000u) return {(std::uint16_t)((x >> 16) | 0x40)}; // keep NaN quiet
+        x += 0x7fffu + ((x >> 16) & 1); // round half to even
+        return {(std::uint16_t)(x >> 16)};
+    }
+    static double decode(BFloat16 cell) { return std::bit_cast<float>((std::uint32_t)cell.bits << 16); }
+};
+
+template <>
+struct CellCodec<Half> {
+    static Half encode(double value) {
+        std::uint32_t x = std::bit_cast<std::uint32_t>((float)value);
+        std::uint16_t sign = (std::uint16_t)((x >> 16) & 0x8000);
+        x &= 0x7fffffffu;
+        std::uint16_t h;
+        if (x >= 0x47800000u) {
+            // too large for a half, infinity or NaN
+            h = x > 0x7f800000u ? 0x7e00 : 0x7c00;
+        } else if (x < 0x38800000u) {
+            // subnormal half or zero, the float addition does the rounding
+            h = (std::uint16_t)(std::bit_cast<std::uint32_t>(std::bit_cast<float>(x) + 0.5f) - 0x3f000000u);
+        } else {
+            std::uint32_t odd = (x >> 13) & 1;
+            x += 0xc8000fffu + odd; // rebias the exponent by 15 - 127 and round half to even
+            h = (std::uint16_t)(x >> 13);
+        }
+        return {(std::uint16_t)(h | sign)};
+    }
+    static double decode(Half cell) {
+        std::uint32_t x = (std::uint32_t)(cell.bits & 0x7fff) << 13;
+        std::uint32_t exponent = x & 0x0f800000u;
+        x += (127 - 15) << 23;
+        if (exponent == 0x0f800000u) {
+            x += (128 - 16) << 23; // infinity or NaN
+        } else if (exponent == 0) {
+            x += 1 << 23; // subnormal, renormalised by the float subtraction
+            x = std::bit_cast<std::uint32_t>(std::bit_cast<float>(x) - std::bit_cast<float>(113u << 23));
+        }
+        return std::bit_cast<float>(x | (std::uint32_t)(cell.bits & 0x8000) << 16);
+    }
+};
+
+template <>
+struct CellCodec<UNorm16> {
+    static UNorm16 encode(double value) {
+        // NaN falls to 0 through the comparisons
+        double clamped = std::min(1.0, std::max(0.0, value));
+        return {(std::uint16_t)(clamped * 65535.0 + 0.5)};
+    }
+    static double decode(UNorm16 cell) { return cell.bits * (1.0 / 65535.0); }
+};
+
+/**
+ * @brief Convert count doubles to cells. Plain loops over the scalar codecs, which the
+ * compiler vectorises; halves use the F16C instructions when the build targets them.
+ */
+template <typename Cell>
+inline void encode_cells(const double* values, Cell* cells, std::size_t count) {
+    std::size_t i = 0;
+#ifdef MASS_HAVE_F16C
+    if constexpr (std::is_same_v<Cell, Half>) {
+        for (; i + 4 <= count; i += 4) {
+            __m128 f = _mm256_cvtpd_ps(_mm256_loadu_pd(values + i));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(cells + i), _mm_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT));
+        }
+    }
+#endif
+    for (; i < count; ++i) cells[i] = CellCodec<Cell>::encode(values[i]);
+}
+
+/**
+ * @brief Convert count cells back to doubles.
+ */
+template <typename Cell>
+inline void decode_cells(const Cell* cells, double* values, std::size_t count) {
+    std::size_t i = 0;
+#ifdef MASS_HAVE_F16C
+    if constexpr (std::is_same_v<Cell, Half>) {
+        for (; i + 4 <= count; i += 4) {
+            __m128 f = _mm_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(cells + i)));
+            _mm256_storeu_pd(values + i, _mm256_cvtps_pd(f));
+        }
+    }
+#endif
+    for (; i < count; ++i) values[i] = CellCodec<Cell>::decode(cells[i]);
+}
+
+#endif // CELL_CODEC_H
@@ -0,0 +1,131 @@
+/**
+ * @file CellSlotMap.hpp
+ * @brief Declares CellSlotMap, a flat hash from grid cells to the slots where their samples are stored.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef CELL_SLOT_MAP_H
+#define CELL_SLOT_MAP_H
+
+#include <cstdint>
+#include <vector>
+
+#include "StateSpace.hpp"
+
+/**
+ * @brief Open-addressing hash from a cell's 64-bit row-major index to a sample slot.
+ *
+ * Keys and slots live in one flat array probed linearly, so a lookup is a hash and usually a
+ * single cache line, with no allocation, string building or exceptions.
+ * Coordinates outside the grid, or of the wrong dimension, are never found. Samples are only
+ * ever added, so there is no erase.
+ */
+class CellSlotMap {
+public:
+    static constexpr int NONE = -1;
+
+    CellSlotMap(int dimensions, int dimensionSize)
+        : dimensions(dimensions), dimensionSize(dimensionSize)
+    {
+        StateSpace::cell_count(dimensions, dimensionSize); // the row-major index must fit 64 bits
+        table.assign(16, Entry{});
+        mask = table.size() - 1;
+    }
+
+    /**
+     * @brief Row-major index of coords, or -1 if they are not a cell of the grid.
+     */
+    long long cell_index(const Coordinates& coords) const noexcept {
+        if ((int)coords.size() != dimensions) return -1;
+        long long index = 0;
+        for (int c : coords) {
+            if (c < 0 || c >= dimensionSize) return -1;
+            index = index * dimensionSize + c;
+        }
+        return index;
+    }
+
+    /**
+     * @brief The slot stored for a cell, or NONE.
+     */
+    int find(long long cell) const noexcept {
+        if (cell < 0) return NONE;
+        for (std::size_t i = bucket(cell);; i = (i + 1) & mask) {
+            if (table[i].cell == cell) return table[i].slot;
+            if (table[i].cell == EMPTY) return NONE;
+        }
+    }
+
+    int find(const Coordinates& coords) const noexcept { return find(cell_index(coords)); }
+
+    bool contains(const Coordinates& coords) const noexcept { return find(coords) != NONE; }
+
+    /**
+     * @brief Store slot for a cell that has none yet.
+     * @return the cell's slot, which is the existing one if the cell was already present
+     */
+    int emplace(long long cell, int slot) {
+        if (cell < 0) return NONE;
+        if (2 * (count + 1) > table.size()) grow();
+        std::size_t i = bucket(cell);
+        for (; table[i].cell != EMPTY; i = (i + 1) & mask)
+            if (table[i].cell == cell) return table[i].slot;
+        table[i] = Entry{cell, slot};
+        ++count;
+        return slot;
+    }
+
+    int emplace(const Coordinates& coords, int slot) { return emplace(cell_index(coords), slot); }
+
+    /**
+     * @brief Make room for n cells without rehashing.
+     */
+    void reserve(std::size_t n) {
+        while (2 * n > table.size()) grow();
+    }
+
+    std::size_t size() const noexcept { return count; }
+
+    void clear() {
+        table.assign(16, Entry{});
+        mask = table.size() - 1;
+        count = 0;
+    }
+
+private:
+    static constexpr long long EMPTY = -1;
+
+    struct Entry {
+        long long cell = EMPTY;
+        int slot = NONE;
+    };
+
+    int dimensions;
+    int dimensionSize;
+    std::vector<Entry> table;
+    std::size_t mask;
+    std::size_t count = 0;
+
+    // the splitmix64 finaliser, row-major indices of nearby cells differ only in their low bits
+    std::size_t bucket(long long cell) const noexcept {
+        std::uint64_t z = (std::uint64_t)cell + 0x9e3779b97f4a7c15ULL;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return (std::size_t)(z ^ (z >> 31)) & mask;
+    }
+
+    void grow() {
+        std::vector<Entry> old = std::move(table);
+        table.assign(old.size() * 2, Entry{});
+        mask = table.size() - 1;
+        for (const Entry& entry : old) {
+            if (entry.cell == EMPTY) continue;
+            std::size_t i = bucket(entry.cell);
+            while (table[i].cell != EMPTY) i = (i + 1) & mask;
+            table[i] = entry;
+        }
+    }
+};
+
+#endif // CELL_SLOT_MAP_H
@@ -0,0 +1,194 @@
+/**
+ * @file Coordinates.hpp
+ * @brief Declares Coordinates, the integer grid coordinates passed between models, IO and state spaces.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef COORDINATES_H
+#define COORDINATES_H
+
+#include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief A point of the grid, stored inline for up to INLINE_CAPACITY dimensions.
+ *
+ * Behaves like the std::vector<int> it replaces, but copying, returning and storing the
+ * coordinates of a grid of 8 or fewer dimensions never touches the heap. Larger grids spill
+ * to a heap buffer. Converts implicitly from std::vector<int> so existing callers keep working.
+ */
+class Coordinates {
+public:
+    static constexpr std::size_t INLINE_CAPACITY = 8;
+
+    using value_type = int;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = int&;
+    using const_reference = const int&;
+    using pointer = int*;
+    using const_pointer = const int*;
+    using iterator = int*;
+    using const_iterator = const int*;
+
+    Coordinates() noexcept = default;
+
+    explicit Coordinates(size_type count, int value = 0) { assign(count, value); }
+
+    Coordinates(std::initializer_list<int> values) { assign(values.begin(), values.end()); }
+
+    template <typename It>
+        requires (!std::is_integral_v<It>)
+    Coordinates(It first, It last) { assign(first, last); }
+
+    Coordinates(const std::vector<int>& values) { assign(values.begin(), values.end()); }
+
+    Coordinates(const Coordinates& other) { assign(other.begin(), other.end()); }
+
+    Coordinates(Coordinates&& other) noexcept { take(other); }
+
+    Coordinates& operator=(const Coordinates& other) {
+        if (this != &other) assign(other.begin(), other.end());
+        return *this;
+    }
+
+    Coordinates& operator=(Coordinates&& other) noexcept {
+        if (this != &other) {
+            release();
+            take(other);
+        }
+        return *this;
+    }
+
+    Coordinates& operator=(std::initializer_list<int> values) {
+        assign(values.begin(), values.end());
+        return *this;
+    }
+
+    ~Coordinates() { release(); }
+
+    void assign(size_type count, int value) {
+        length = 0;
+        reserve(count);
+        std::fill_n(items, count, value);
+        length = (std::uint32_t)count;
+    }
+
+    template <typename It>
+        requires (!std::is_integral_v<It>)
+    void assign(It first, It last) {
+        length = 0;
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<It>::iterator_category>) {
+            reserve((size_type)std::distance(first, last));
+            for (; first != last; ++first) items[length++] = (int)*first;
+        } else {
+            for (; first != last; ++first) push_back((int)*first);
+        }
+    }
+
+    size_type size() const noexcept { return length; }
+    bool empty() const noexcept { return length == 0; }
+    size_type capacity() const noexcept { return allocated; }
+
+    int* data() noexcept { return items; }
+    const int* data() const noexcept { return items; }
+
+    int& operator[](size_type i) noexcept { return items[i]; }
+    int operator[](size_type i) const noexcept { return items[i]; }
+
+    int& front() noexcept { return items[0]; }
+    int front() const noexcept { return items[0]; }
+    int& back() noexcept { return items[length - 1]; }
+    int back() const noexcept { return items[length - 1]; }
+
+    iterator begin() noexcept { return items; }
+    iterator end() noexcept { return items + length; }
+    const_iterator begin() const noexcept { return items; }
+    const_iterator end() const noexcept { return items + length; }
+    const_iterator cbegin() const noexcept { return items; }
+    const_iterator cend() const noexcept { return items + length; }
+
+    void reserve(size_type wanted) {
+        if (wanted <= allocated) return;
+        size_type grown = std::max<size_type>(wanted, 2 * (size_type)allocated);
+        int* spilled = new int[grown];
+        std::memcpy(spilled, items, length * sizeof(int));
+        release();
+        items = spilled;
+        allocated = (std::uint32_t)grown;
+    }
+
+    void resize(size_type count, int value = 0) {
+        reserve(count);
+        if (count > length) std::fill(items + length, items + count, value);
+        length = (std::uint32_t)count;
+    }
+
+    void push_back(int value) {
+        if (length == allocated) reserve(length + 1);
+        items[length++] = value;
+    }
+
+    int& emplace_back(int value) {
+        push_back(value);
+        return back();
+    }
+
+    void pop_back() noexcept { --length; }
+    void clear() noexcept { length = 0; }
+
+    std::vector<int> to_vector() const { return std::vector<int>(begin(), end()); }
+
+    friend bool operator==(const Coordinates& a, const Coordinates& b) noexcept {
+        return a.length == b.length && std::equal(a.begin(), a.end(), b.begin());
+    }
+
+    friend std::strong_ordering operator<=>(const Coordinates& a, const Coordinates& b) noexcept {
+        return std::lexicographical_compare_three_way(a.begin(), a.end(), b.begin(), b.end());
+    }
+
+    friend std::ostream& operator<<(std::ostream& out, const Coordinates& coords) {
+        out << '(';
+        for (size_type i = 0; i < coords.size(); ++i) out << (i ? ", " : "") << coords[i];
+        return out << ')';
+    }
+
+private:
+    int inlineItems[INLINE_CAPACITY];
+    int* items = inlineItems;
+    std::uint32_t length = 0;
+    std::uint32_t allocated = INLINE_CAPACITY;
+
+    bool spilled() const noexcept { return items != inlineItems; }
+
+    void release() noexcept {
+        if (spilled()) delete[] items;
+        items = inlineItems;
+        allocated = INLINE_CAPACITY;
+    }
+
+    // steal a heap buffer, copy an inline one, and leave other empty
+    void take(Coordinates& other) noexcept {
+        if (other.spilled()) {
+            items = other.items;
+            allocated = other.allocated;
+        } else {
+            std::memcpy(inlineItems, other.inlineItems, other.length * sizeof(int));
+        }
+        length = other.length;
+        other.items = other.inlineItems;
+        other.allocated = INLINE_CAPACITY;
+        other.length = 0;
+    }
+};
+
+#endif // COORDINATES_H
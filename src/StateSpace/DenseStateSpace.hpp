@@ -0,0 +1,36 @@
+/**
+ * @file DenseStateSpace.hpp
+ * @brief Declares DenseStateSpace, the interface of state spaces that store every cell.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef DENSE_STATE_SPACE_H
+#define DENSE_STATE_SPACE_H
+
+#include <vector>
+
+#include "StateSpace.hpp"
+
+/**
+ * @brief A StateSpace holding a value for every cell, which can be written cell by cell.
+ *
+ * The dense models fill one of these without knowing how the cells are stored.
+ */
+class DenseStateSpace : public StateSpace {
+public:
+    using StateSpace::StateSpace;
+
+    /**
+     * @brief Store value in the cell at coords.
+     * @return the value as stored, which may be rounded to the cell type
+     */
+    virtual double set(const Coordinates& coords, double value) = 0;
+
+    /**
+     * @brief Every cell in row-major order, as doubles.
+     */
+    virtual std::vector<double> get_raw_representation() const = 0;
+};
+
+#endif // DENSE_STATE_SPACE_H
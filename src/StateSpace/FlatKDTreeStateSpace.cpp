@@ -0,0 +1,208 @@
+/**
+ * @file FlatKDTreeStateSpace.cpp
+ * @brief Implements FlatKDTreeStateSpace, a bucketed k-d tree kept in a few contiguous pools.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#include "FlatKDTreeStateSpace.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+FlatKDTreeStateSpace::FlatKDTreeStateSpace(int dimensions, int dimensionSize, int bucketSize)
+    : StateSpace(dimensions, dimensionSize), bucketSize(bucketSize), cellSlots(dimensions, dimensionSize)
+{
+    if (this->bucketSize <= 0)
+        this->bucketSize = static_cast<int>(std::log2(static_cast<double>(cell_count(dimensions, dimensionSize))));
+    // a full leaf must hold two distinct samples to be split
+    this->bucketSize = std::max(2, this->bucketSize);
+
+    nodes.push_back(Node{LEAF, 0, new_block(), 0});
+}
+
+void FlatKDTreeStateSpace::reserve(int points) {
+    values.reserve(points);
+    location.reserve(points);
+    cellSlots.reserve(points);
+}
+
+std::uint32_t FlatKDTreeStateSpace::new_block() {
+    std::size_t blocks = blockPoints.size() / bucketSize;
+    if ((blocks + 1) * bucketSize > std::numeric_limits<std::uint32_t>::max())
+        throw std::overflow_error("FlatKDTreeStateSpace bucket pool exceeds 32-bit indices");
+    blockCoords.resize((blocks + 1) * bucketSize * dimensions);
+    blockPoints.resize((blocks + 1) * bucketSize);
+    return (std::uint32_t)blocks;
+}
+
+void FlatKDTreeStateSpace::store(std::uint32_t block, std::uint32_t slot, int point, const Coordinates& coords) {
+    for (int d = 0; d < dimensions; ++d) row(block, d)[slot] = coords[d];
+    blockPoints[(std::size_t)block * bucketSize + slot] = point;
+    location[point] = block * bucketSize + slot;
+}
+
+void FlatKDTreeStateSpace::move_slot(std::uint32_t fromBlock, std::uint32_t from, std::uint32_t toBlock, std::uint32_t to) {
+    for (int d = 0; d < dimensions; ++d) row(toBlock, d)[to] = row(fromBlock, d)[from];
+    int point = blockPoints[(std::size_t)fromBlock * bucketSize + from];
+    blockPoints[(std::size_t)toBlock * bucketSize + to] = point;
+    location[point] = toBlock * bucketSize + to;
+}
+
+double FlatKDTreeStateSpace::insert(const Coordinates& coords, double value) {
+    if (coords.size() != static_cast<size_t>(dimensions))
+        throw std::invalid_argument("Coordinate dimensionality mismatch");
+
+    long long cell = cellSlots.cell_index(coords);
+    int existing = cell >= 0 ? cellSlots.find(cell) : find_point(coords);
+    if (existing >= 0) {
+        values[existing] = value;
+        return value;
+    }
+
+    int point = (int)values.size();
+    values.push_back(value);
+    location.push_back(0);
+    if (cell >= 0) cellSlots.emplace(cell, point);
+
+    std::uint32_t n = 0;
+    while (true) {
+        const Node& node = nodes[n];
+        if (node.axis != LEAF) {
+            n = coords[node.axis] < node.split ? node.first : node.second;
+        } else if (node.second == (std::uint32_t)bucketSize) {
+            split(n); // n is now internal, descend from it again
+        } else {
+            store(node.first, node.second, point, coords);
+            nodes[n].second++;
+            return value;
+        }
+    }
+}
+
+// split a full leaf at the median of its widest axis, keeping its block for the left half
+void FlatKDTreeStateSpace::split(std::uint32_t leaf) {
+    const std::uint32_t block = nodes[leaf].first;
+    const std::uint32_t count = nodes[leaf].second;
+
+    int axis = 0, widest = -1, lowest = 0;
+    for (int d = 0; d < dimensions; ++d) {
+        const int* r = row(block, d);
+        auto [lo, hi] = std::minmax_element(r, r + count);
+        if (*hi - *lo > widest) {
+            widest = *hi - *lo;
+            axis = d;
+            lowest = *lo;
+        }
+    }
+
+    splitScratch.assign(row(block, axis), row(block, axis) + count);
+    std::nth_element(splitScratch.begin(), splitScratch.begin() + count / 2, splitScratch.end());
+    int split = splitScratch[count / 2];
+    if (split == lowest) {
+        // the lower half is all one value, split just above it so neither side is empty
+        split = std::numeric_limits<int>::max();
+        for (int c : splitScratch)
+            if (c > lowest) split = std::min(split, c);
+    }
+
+    std::uint32_t rightBlock = new_block();
+    std::uint32_t leftCount = 0, rightCount = 0;
+    for (std::uint32_t j = 0; j < count; ++j) {
+        if (row(block, axis)[j] < split) {
+            if (j != leftCount) move_slot(block, j, block, leftCount);
+            leftCount++;
+        } else {
+            move_slot(block, j, rightBlock, rightCount++);
+        }
+    }
+
+    std::uint32_t left = (std::uint32_t)nodes.size();
+    nodes.push_back(Node{LEAF, 0, block, leftCount});
+    nodes.push_back(Node{LEAF, 0, rightBlock, rightCount});
+    nodes[leaf] = Node{axis, split, left, left + 1};
+}
+
+double FlatKDTreeStateSpace::get(const Coordinates& coords) const {
+    if (coords.size() != static_cast<size_t>(dimensions))
+        throw std::invalid_argument("Coordinate dimensionality mismatch");
+    return find(coords).value_or(0.0);
+}
+
+std::optional<double> FlatKDTreeStateSpace::find(const Coordinates& coords) const noexcept {
+    if (coords.size() != static_cast<size_t>(dimensions)) return std::nullopt;
+    long long cell = cellSlots.cell_index(coords);
+    int point = cell >= 0 ? cellSlots.find(cell) : find_point(coords);
+    if (point < 0) return std::nullopt;
+    return values[point];
+}
+
+// walk to the leaf that would hold coords, -1 if it is not there
+int FlatKDTreeStateSpace::find_point(const Coordinates& coords) const noexcept {
+    std::uint32_t n = 0;
+    while (nodes[n].axis != LEAF)
+        n = coords[nodes[n].axis] < nodes[n].split ? nodes[n].first : nodes[n].second;
+
+    const Node& leaf = nodes[n];
+    for (std::uint32_t j = 0; j < leaf.second; ++j) {
+        int d = 0;
+        while (d < dimensions && row(leaf.first, d)[j] == coords[d]) ++d;
+        if (d == dimensions) return blockPoints[(std::size_t)leaf.first * bucketSize + j];
+    }
+    return -1;
+}
+
+std::optional<FlatKDTreeStateSpace::Neighbor> FlatKDTreeStateSpace::nearest_neighbor(const Coordinates& coords) const noexcept {
+    if (coords.size() != static_cast<size_t>(dimensions) || values.empty()) return std::nullopt;
+    Neighbor best{-1, std::numeric_limits<double>::infinity()};
+    nearest_recursive(0, coords, best);
+    return best;
+}
+
+void FlatKDTreeStateSpace::nearest_recursive(std::uint32_t n, const Coordinates& target, Neighbor& best) const noexcept {
+    const Node& node = nodes[n];
+    if (node.axis == LEAF) {
+        for (std::uint32_t j = 0; j < node.second; ++j) {
+            double dist = 0.0;
+            for (int d = 0; d < dimensions; ++d) {
+                double diff = static_cast<double>(row(node.first, d)[j] - target[d]);
+                dist += diff * diff;
+            }
+            if (dist < best.squaredDistance)
+                best = Neighbor{blockPoints[(std::size_t)node.first * bucketSize + j], dist};
+        }
+        return;
+    }
+
+    bool goLeft = target[node.axis] < node.split;
+    nearest_recursive(goLeft ? node.first : node.second, target, best);
+
+    // coordinates are integers, the left side ends at split - 1
+    double gap = goLeft ? node.split - target[node.axis] : target[node.axis] - (node.split - 1);
+    if (gap * gap < best.squaredDistance)
+        nearest_recursive(goLeft ? node.second : node.first, target, best);
+}
+
+Coordinates FlatKDTreeStateSpace::coords_of(int point) const {
+    std::uint32_t block = location[point] / bucketSize, slot = location[point] % bucketSize;
+    Coordinates coords(dimensions);
+    for (int d = 0; d < dimensions; ++d) coords[d] = row(block, d)[slot];
+    return coords;
+}
+
+int FlatKDTreeStateSpace::depth() const {
+    int deepest = 0;
+    std::vector<std::pair<std::uint32_t, int>> stack{{0, 1}};
+    while (!stack.empty()) {
+        auto [n, level] = stack.back();
+        stack.pop_back();
+        deepest = std::max(deepest, level);
+        if (nodes[n].axis != LEAF) {
+            stack.push_back({nodes[n].first, level + 1});
+            stack.push_back({nodes[n].second, level + 1});
+        }
+    }
+    return deepest;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file FlatKDTreeStateSpace.hpp
+ * @brief Declares FlatKDTreeStateSpace, a bucketed k-d tree kept in a few contiguous pools.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef FLAT_KD_TREE_STATE_SPACE_H
+#define FLAT_KD_TREE_STATE_SPACE_H
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "StateSpace.hpp"
+#include "CellSlotMap.hpp"
+
+/**
+ * @brief The samples of a KDTreeStateSpace without an allocation per point.
+ *
+ * Nodes live in one pool and refer to their children by 32-bit index. Every sample sits in a
+ * leaf, and every leaf owns a fixed-size block of the bucket pool. A block stores its
+ * coordinates dimension by dimension (structure of arrays), so a bucket scan reads each axis as
+ * one contiguous run. Internal nodes only hold the split axis and value. A sample keeps the id
+ * it was inserted with, which indexes its value and its current place in the bucket pool.
+ *
+ * Lookups return std::optional and never throw. get and insert throw std::invalid_argument
+ * for coordinates of the wrong dimension, like the other state spaces.
+ */
+class FlatKDTreeStateSpace : public StateSpace {
+public:
+    struct Neighbor {
+        int point; // sample id, for coords_of and value_of
+        double squaredDistance;
+    };
+
+    /**
+     * @param bucketSize samples in a leaf before it splits, 0 for the log2(cells) heuristic of KDTreeStateSpace
+     */
+    FlatKDTreeStateSpace(int dimensions, int dimensionSize, int bucketSize = 0);
+
+    int get_dimensions() const override { return dimensions; }
+    int get_dimension_size() const override { return dimensionSize; }
+
+    /**
+     * @brief The value stored at coords, 0 for cells never inserted.
+     */
+    double get(const Coordinates& coords) const override;
+
+    /**
+     * @brief The value stored at coords, if a sample was inserted there.
+     */
+    std::optional<double> find(const Coordinates& coords) const noexcept;
+
+    /**
+     * @brief Store a sample, replacing the value of an existing one at the same coordinates.
+     * Coordinates outside the grid are accepted and only found through the tree.
+     */
+    double insert(const Coordinates& coords, double value);
+
+    /**
+     * @brief The closest sample by Euclidean distance, none if the tree is empty or coords has
+     * the wrong dimension.
+     */
+    std::optional<Neighbor> nearest_neighbor(const Coordinates& coords) const noexcept;
+
+    int size() const noexcept { return (int)values.size(); }
+
+    /**
+     * @brief Make room for points samples without reallocating.
+     */
+    void reserve(int points);
+
+    Coordinates coords_of(int point) const;
+    double value_of(int point) const { return values[point]; }
+
+    int bucket_size() const noexcept { return bucketSize; }
+
+    /**
+     * @brief Number of nodes on the longest root to leaf path.
+     */
+    int depth() const;
+
+private:
+    static constexpr int LEAF = -1;
+
+    struct Node {
+        int axis;            // split axis, LEAF for a leaf
+        int split;           // samples with coords[axis] < split are on the left
+        std::uint32_t first; // left child, or the block of a leaf
+        std::uint32_t second; // right child, or the number of samples in a leaf
+    };
+
+    int bucketSize;
+    std::vector<Node> nodes; // nodes[0] is the root
+    // block b holds coordinate d of slot j at blockCoords[(b * dimensions + d) * bucketSize + j]
+    std::vector<int> blockCoords;
+    std::vector<int> blockPoints; // sample id in each slot
+    std::vector<double> values; // by sample id
+    std::vector<std::uint32_t> location; // by sample id, block * bucketSize + slot
+    CellSlotMap cellSlots; // in-grid cells to sample ids
+    std::vector<int> splitScratch;
+
+    const int* row(std::uint32_t block, int d) const { return &blockCoords[((std::size_t)block * dimensions + d) * bucketSize]; }
+    int* row(std::uint32_t block, int d) { return &blockCoords[((std::size_t)block * dimensions + d) * bucketSize]; }
+
+    std::uint32_t new_block();
+    void store(std::uint32_t block, std::uint32_t slot, int point, const Coordinates& coords);
+    void move_slot(std::uint32_t fromBlock, std::uint32_t from, std::uint32_t toBlock, std::uint32_t to);
+    void split(std::uint32_t leaf);
+    int find_point(const Coordinates& coords) const noexcept;
+    void nearest_recursive(std::uint32_t node, const Coordinates& target, Neighbor& best) const noexcept;
+};
+
+#endif // FLAT_KD_TREE_STATE_SPACE_H
@@ -3,27 +3,60 @@
 
 // Constructor
 KDTreeStateSpace::KDTreeStateSpace(int dimensions, int dimensionSize)
-    : StateSpace(dimensions, dimensionSize), root(nullptr) {
+    : StateSpace(dimensions, dimensionSize), root(nullptr), cellSlots(dimensions, dimensionSize) {
         // Weigh max depth by number of dimensions and dimension size.
 
 
         // Can also just choose a fixed max depth. This is a heuristic.
         // Setting maxDepth to -1 means no limit.
-        int totalPoints = 1;
-        for (int d = 0; d < dimensions; ++d)
-            totalPoints *= dimensionSize;
+        long long totalPoints = cell_count(dimensions, dimensionSize);
 
-        this->bucketSizeThreshold = static_cast<int>(std::log2(totalPoints)); // log2(N) heuristic
+        this->bucketSizeThreshold = static_cast<int>(std::log2(static_cast<double>(totalPoints))); // log2(N) heuristic
 
     }
 
+KDTreeStateSpace::KDTreeStateSpace(int dimensions, int dimensionSize, const std::vector<Coordinates>& coords,
+                                   const std::vector<double>& values)
+    : KDTreeStateSpace(dimensions, dimensionSize) {
+    if (coords.size() != values.size()) {
+        throw std::invalid_argument("Bulk load needs one value per coordinate");
+    }
+
+    std::vector<TreeNode*> samples;
+    std::vector<std::size_t> outside; // off-grid samples go through insert, which also deduplicates them
+    samples.reserve(coords.size());
+    this->values.reserve(coords.size());
+    cellSlots.reserve(coords.size());
+    for (std::size_t i = 0; i < coords.size(); ++i) {
+        if (coords[i].size() != static_cast<size_t>(dimensions)) {
+            for (auto* sample : samples) delete sample;
+            throw std::invalid_argument("Coordinate dimensionality mismatch");
+        }
+        long long cell = cellSlots.cell_index(coords[i]);
+        if (cell < 0) {
+            outside.push_back(i);
+            continue;
+        }
+        int slot = cellSlots.emplace(cell, (int)samples.size());
+        if (slot == (int)samples.size()) {
+            samples.push_back(new TreeNode(coords[i], values[i], 0));
+            this->values.push_back(values[i]);
+        } else {
+            samples[slot]->value = this->values[slot] = values[i];
+        }
+    }
+
+    root = build(samples.data(), samples.data() + samples.size());
+    for (std::size_t i : outside) insert(coords[i], values[i]);
+}
+
 // Destructor
 KDTreeStateSpace::~KDTreeStateSpace() {
     destroy(root);
 }
 
 // Helper
-std::string KDTreeStateSpace::coordsToString(std::vector<int> coords) const {
+std::string KDTreeStateSpace::coordsToString(Coordinates coords) const {
     std::string key;
     for (int c : coords) {
         key += std::to_string(c) + ",";
@@ -55,17 +88,158 @@ int KDTreeStateSpace::get_dimension_size() const {
 }
 
 // Public insert entry point
-double KDTreeStateSpace::insert(const std::vector<int>& coords, double value) {
+double KDTreeStateSpace::insert(const Coordinates& coords, double value) {
     if (coords.size() != static_cast<size_t>(dimensions)) {
         throw std::invalid_argument("Coordinate dimensionality mismatch");
     }
+    // points outside the grid are kept in the tree only, see find_node
+    long long cell = cellSlots.cell_index(coords);
+    bool added;
+    if (cell >= 0) {
+        int slot = cellSlots.emplace(cell, (int)values.size());
+        added = slot == (int)values.size();
+        if (added) values.push_back(value);
+        else values[slot] = value;
+    } else {
+        added = find_node(coords) == nullptr;
+    }
+
+    if (!added) {
+        const_cast<TreeNode*>(find_node(coords))->value = value;
+        return value;
+    }
+
     root = insert_recursive(root, coords, value, 0);
+    rebalance(coords);
     return value;
 }
 
+int KDTreeStateSpace::subtree_size(const TreeNode* node) {
+    return node ? node->size : 0;
+}
+
+// Rebuild the highest subtree on the path to coords that has become too lopsided. Subtrees
+// of only a couple of buckets are left alone, rebuilding them would not shorten anything.
+void KDTreeStateSpace::rebalance(const Coordinates& coords) {
+    TreeNode** link = &root;
+    while (*link && !(*link)->isBucket) {
+        TreeNode* node = *link;
+        int heavier = std::max(subtree_size(node->left), subtree_size(node->right));
+        if (node->size > 2 * (bucketSizeThreshold + 1) && heavier > REBALANCE_ALPHA * node->size) {
+            *link = rebuild(node);
+            return;
+        }
+        if (coords == node->coords) return;
+        link = coords[node->axis] < node->coords[node->axis] ? &node->left : &node->right;
+    }
+}
+
+KDTreeStateSpace::TreeNode* KDTreeStateSpace::rebuild(TreeNode* node) {
+    std::vector<TreeNode*> samples;
+    samples.reserve(node->size);
+    collect_samples(node, samples);
+    return build(samples.data(), samples.data() + samples.size());
+}
+
+// Unlink every sample node of the subtree into samples, bucket nodes themselves are freed
+void KDTreeStateSpace::collect_samples(TreeNode* node, std::vector<TreeNode*>& samples) {
+    if (!node) return;
+    if (node->isBucket) {
+        samples.insert(samples.end(), node->bucket.begin(), node->bucket.end());
+        delete node;
+        return;
+    }
+    collect_samples(node->left, samples);
+    collect_samples(node->right, samples);
+    node->left = node->right = nullptr;
+    samples.push_back(node);
+}
+
+// Balanced subtree over the sample nodes in [first, last): at most bucketSizeThreshold samples
+// become a bucket, larger ranges are split at the median of their widest axis
+KDTreeStateSpace::TreeNode* KDTreeStateSpace::build(TreeNode** first, TreeNode** last) {
+    const std::ptrdiff_t n = last - first;
+    if (n == 0) return nullptr;
+
+    if (n <= bucketSizeThreshold) {
+        TreeNode* bucketNode = new TreeNode((*first)->coords, (*first)->value, 0);
+        bucketNode->isBucket = true;
+        bucketNode->bucket.assign(first, last);
+        bucketNode->size = (int)n;
+        for (auto* sample : bucketNode->bucket) {
+            sample->left = sample->right = nullptr;
+            sample->isBucket = false;
+            sample->size = 1;
+        }
+        return bucketNode;
+    }
+
+    int axis = 0;
+    int maxRange = -1;
+    for (int d = 0; d < dimensions; ++d) {
+        auto [lo, hi] = std::minmax_element(first, last, [d](TreeNode* a, TreeNode* b) {
+            return a->coords[d] < b->coords[d];
+        });
+        int range = (*hi)->coords[d] - (*lo)->coords[d];
+        if (range > maxRange) {
+            maxRange = range;
+            axis = d;
+        }
+    }
+
+    TreeNode** mid = first + n / 2;
+    std::nth_element(first, mid, last, [axis](TreeNode* a, TreeNode* b) {
+        return a->coords[axis] < b->coords[axis];
+    });
+    // the left subtree must be strictly below the split value, ties below the median go right
+    const int split = (*mid)->coords[axis];
+    TreeNode** pivot = std::partition(first, mid, [axis, split](TreeNode* t) { return t->coords[axis] < split; });
+    std::iter_swap(pivot, mid);
+
+    TreeNode* node = *pivot;
+    node->axis = axis;
+    node->isBucket = false;
+    node->bucket.clear();
+    node->left = build(first, pivot);
+    node->right = build(pivot + 1, last);
+    node->size = (int)n;
+    return node;
+}
+
+int KDTreeStateSpace::depth() const {
+    int deepest = 0;
+    std::vector<std::pair<const TreeNode*, int>> stack;
+    if (root) stack.push_back({root, 1});
+    while (!stack.empty()) {
+        auto [node, level] = stack.back();
+        stack.pop_back();
+        deepest = std::max(deepest, level);
+        if (node->left) stack.push_back({node->left, level + 1});
+        if (node->right) stack.push_back({node->right, level + 1});
+    }
+    return deepest;
+}
+
+std::vector<KDTreeStateSpace::TreeNode*> KDTreeStateSpace::get_leaves() const {
+    std::vector<TreeNode*> leaves;
+    std::vector<TreeNode*> stack;
+    if (root) stack.push_back(root);
+    while (!stack.empty()) {
+        TreeNode* node = stack.back();
+        stack.pop_back();
+        if (node->isBucket || (!node->left && !node->right)) {
+            leaves.push_back(node);
+            continue;
+        }
+        if (node->left) stack.push_back(node->left);
+        if (node->right) stack.push_back(node->right);
+    }
+    return leaves;
+}
+
 // Recursive insert
 KDTreeStateSpace::TreeNode* KDTreeStateSpace::insert_recursive(
-    TreeNode* node, const std::vector<int>& coords, double value, int depth)
+    TreeNode* node, const Coordinates& coords, double value, int depth)
 {
     int axis = depth % this->dimensions;
 
@@ -74,7 +248,6 @@ KDTreeStateSpace::TreeNode* KDTreeStateSpace::insert_recursive(
         TreeNode* newNode = new TreeNode(coords, value, axis);
         newNode->isBucket = true; 
         newNode->bucket.push_back(new TreeNode(coords, value, axis)); // Adding itself to its bucket
-        leafNodes.insert(newNode);
         return newNode;
     }
 
@@ -91,7 +264,7 @@ KDTreeStateSpace::TreeNode* KDTreeStateSpace::insert_recursive(
         // Insert new point into bucket
         TreeNode* newNode = new TreeNode(coords, value, axis);
         node->bucket.push_back(newNode);
-        leafNodes.insert(newNode);
+        node->size = (int)node->bucket.size();
 
         // Split only if threshold exceeded
         if (node->bucket.size() > static_cast<size_t>(bucketSizeThreshold)) {
@@ -127,7 +300,6 @@ KDTreeStateSpace::TreeNode* KDTreeStateSpace::insert_recursive(
             node->axis   = bestAxis;
             // Node is no longer a bucket
             node->isBucket = false;
-            leafNodes.erase(node);
 
             // Reinsert all other points
             std::vector<TreeNode*> tmp = std::move(node->bucket);
@@ -159,61 +331,48 @@ KDTreeStateSpace::TreeNode* KDTreeStateSpace::insert_recursive(
         return node;
     }
 
-    bool goLeft = (coords[axis] < node->coords[axis]);
-    if (!node->left && !node->right && !node->isBucket) leafNodes.erase(node);
+    // descend along the axis the node was split on, which a bucket split may have chosen
+    bool goLeft = (coords[node->axis] < node->coords[node->axis]);
 
     if (goLeft) {
         node->left = insert_recursive(node->left, coords, value, depth + 1);
     } else {
         node->right = insert_recursive(node->right, coords, value, depth + 1);
     }
-
-    // Maintain leafNodes
-    if (!node->left && !node->right && !node->isBucket) leafNodes.insert(node);
-    else leafNodes.erase(node);
+    node->size = 1 + subtree_size(node->left) + subtree_size(node->right);
 
     return node;
 }
 
 
 
-// Public get entry point
-double KDTreeStateSpace::get(const std::vector<int>& coords) const {
+// Public get entry point, cells never inserted read as 0
+double KDTreeStateSpace::get(const Coordinates& coords) const {
     if (coords.size() != static_cast<size_t>(dimensions)) {
         throw std::invalid_argument("Coordinate dimensionality mismatch");
     }
-
-    try {
-        return get_recursive(root, coords, 0);
-    } catch (std::out_of_range&) {
-        // Return default value if not present
-        return 0.0;
+    long long cell = cellSlots.cell_index(coords);
+    if (cell < 0) {
+        const TreeNode* node = find_node(coords);
+        return node ? node->value : 0.0;
     }
+    int slot = cellSlots.find(cell);
+    return slot == CellSlotMap::NONE ? 0.0 : values[slot];
 }
 
-
-// Recursive search
-double KDTreeStateSpace::get_recursive(TreeNode* node, const std::vector<int>& coords, int depth) const {
-    if (!node) throw std::out_of_range("Coordinates not found in KDTree");
-
-    // If this is a bucket node, check all children
-    if (node->isBucket) {
-        for (auto* child : node->bucket) {
-            if (child->coords == coords) {
-                return child->value;
-            }
+// Walk the tree to the node holding coords, nullptr if there is none
+const KDTreeStateSpace::TreeNode* KDTreeStateSpace::find_node(const Coordinates& coords) const {
+    const TreeNode* node = root;
+    while (node) {
+        if (node->isBucket) {
+            for (const auto* child : node->bucket)
+                if (child->coords == coords) return child;
+            return nullptr;
         }
-        throw std::out_of_range("Coordinates not found in bucket");
-    }
-
-    if (coords == node->coords) return node->value;
-
-    int axis = node->axis;
-    if (coords[axis] < node->coords[axis]) {
-        return get_recursive(node->left, coords, depth + 1);
-    } else {
-        return get_recursive(node->right, coords, depth + 1);
+        if (coords == node->coords) return node;
+        node = coords[node->axis] < node->coords[node->axis] ? node->left : node->right;
     }
+    return nullptr;
 }
 
 
@@ -223,8 +382,8 @@ KDTreeStateSpace::TreeNode* KDTreeStateSpace::get_root() {
 
 
 // Compute squared Euclidean distance (faster than sqrt)
-double KDTreeStateSpace::squared_distance(const std::vector<int>& a,
-                                          const std::vector<int>& b) const {
+double KDTreeStateSpace::squared_distance(const Coordinates& a,
+                                          const Coordinates& b) const {
     double sum = 0.0;
     for (size_t i = 0; i < a.size(); i++) {
         double diff = static_cast<double>(a[i] - b[i]);
@@ -235,7 +394,7 @@ double KDTreeStateSpace::squared_distance(const std::vector<int>& a,
 
 // Public entry point
 KDTreeStateSpace::TreeNode*
-KDTreeStateSpace::nearest_neighbor(const std::vector<int>& coords) const {
+KDTreeStateSpace::nearest_neighbor(const Coordinates& coords) const {
     if (coords.size() != static_cast<size_t>(dimensions)) {
         throw std::invalid_argument("Coordinate dimensionality mismatch");
     }
@@ -247,8 +406,9 @@ KDTreeStateSpace::nearest_neighbor(const std::vector<int>& coords) const {
 
     TreeNode* nearestNode = nullptr;
     double bestDist = std::numeric_limits<double>::max();
+    int checksLeft = check_budget();
 
-    nearest_recursive(root, coords, 0, nearestNode, bestDist);
+    nearest_recursive(root, coords, nearestNode, bestDist, checksLeft);
 
     if (!nearestNode) {
         throw std::out_of_range("KDTree is empty");
@@ -261,14 +421,15 @@ KDTreeStateSpace::nearest_neighbor(const std::vector<int>& coords) const {
 
 // // Recursive nearest search
 void KDTreeStateSpace::nearest_recursive(TreeNode* node,
-                                         const std::vector<int>& target,
-                                         int depth,
+                                         const Coordinates& target,
                                          TreeNode*& bestNode,
-                                         double& bestDist) const {
+                                         double& bestDist,
+                                         int& checksLeft) const {
     if (!node) return;
 
     // If this node is a bucket container, stop here — this bucket is the closest
     if (node->isBucket) {
+        checksLeft -= (int)node->bucket.size();
         for (auto* child : node->bucket) {
             double dist = squared_distance(target, child->coords);
             if (dist < bestDist) {
@@ -281,106 +442,177 @@ void KDTreeStateSpace::nearest_recursive(TreeNode* node,
 
 
     double dist = squared_distance(target, node->coords);
+    --checksLeft;
     if (dist < bestDist) {
         bestDist = dist;
         bestNode = node;
     }
 
-    int axis = depth % dimensions;
+    int axis = node->axis;
     TreeNode* near = (target[axis] < node->coords[axis]) ? node->left : node->right;
     TreeNode* far  = (target[axis] < node->coords[axis]) ? node->right : node->left;
 
     // Explore near side first
-    nearest_recursive(near, target, depth + 1, bestNode, bestDist);
+    nearest_recursive(near, target, bestNode, bestDist, checksLeft);
 
     double diff = static_cast<double>(target[axis] - node->coords[axis]);
-    if (diff * diff < bestDist) {
-        nearest_recursive(far, target, depth + 1, bestNode, bestDist);
+    if (checksLeft > 0 && diff * diff * farScale < bestDist) {
+        nearest_recursive(far, target, bestNode, bestDist, checksLeft);
+    }
+}
+
+void KDTreeStateSpace::set_approximation(const Approximation& approximation) {
+    if (approximation.epsilon < 0.0 || approximation.maxChecks < 0) {
+        throw std::invalid_argument("Approximation needs epsilon >= 0 and maxChecks >= 0");
+    }
+    this->approximation = approximation;
+    farScale = (1.0 + approximation.epsilon) * (1.0 + approximation.epsilon);
+}
+
+static bool closer(const KDTreeStateSpace::Neighbor& a, const KDTreeStateSpace::Neighbor& b) {
+    return a.squaredDistance < b.squaredDistance;
+}
+
+void KDTreeStateSpace::nearest_k_neighbors(const Coordinates& coords, int k, std::vector<Neighbor>& out) const {
+    if (coords.size() != static_cast<size_t>(dimensions)) {
+        throw std::invalid_argument("Coordinate dimensionality mismatch");
+    }
+    out.clear();
+    if (k <= 0) return;
+
+    int checksLeft = check_budget();
+    nearest_recursive_k(root, coords, (std::size_t)k, out, checksLeft);
+    std::sort_heap(out.begin(), out.end(), closer);
+}
+
+// out is a max-heap on distance holding at most k neighbours, its top is the one to beat
+void KDTreeStateSpace::nearest_recursive_k(const TreeNode* node, const Coordinates& target, std::size_t k,
+                                           std::vector<Neighbor>& heap, int& checksLeft) const {
+    if (!node) return;
+
+    auto offer = [&](const TreeNode* candidate) {
+        --checksLeft;
+        double dist = squared_distance(target, candidate->coords);
+        if (heap.size() < k) {
+            heap.push_back({candidate, dist});
+            std::push_heap(heap.begin(), heap.end(), closer);
+        } else if (dist < heap.front().squaredDistance) {
+            std::pop_heap(heap.begin(), heap.end(), closer);
+            heap.back() = {candidate, dist};
+            std::push_heap(heap.begin(), heap.end(), closer);
+        }
+    };
+
+    if (node->isBucket) {
+        for (const auto* child : node->bucket) offer(child);
+        return;
     }
+    offer(node);
+
+    int axis = node->axis;
+    bool goLeft = target[axis] < node->coords[axis];
+    nearest_recursive_k(goLeft ? node->left : node->right, target, k, heap, checksLeft);
+
+    double diff = static_cast<double>(target[axis] - node->coords[axis]);
+    if (checksLeft > 0 && (heap.size() < k || diff * diff * farScale < heap.front().squaredDistance))
+        nearest_recursive_k(goLeft ? node->right : node->left, target, k, heap, checksLeft);
 }
 
+void KDTreeStateSpace::nearest_neighbors(const std::vector<Coordinates>& targets, std::vector<Neighbor>& out) const {
+    for (const auto& target : targets) {
+        if (target.size() != static_cast<size_t>(dimensions)) {
+            throw std::invalid_argument("Coordinate dimensionality mismatch");
+        }
+    }
+    out.assign(targets.size(), Neighbor{nullptr, std::numeric_limits<double>::max()});
 
+    std::vector<int> group(targets.size());
+    for (std::size_t i = 0; i < group.size(); ++i) group[i] = (int)i;
+    batch_recursive(root, targets.data(), group.data(), group.data() + group.size(), out);
+}
 
-// std::vector<KDTreeStateSpace::TreeNode*>
-// KDTreeStateSpace::nearest_k_neighbors(const std::vector<int>& coords, int k) const {
-//     if (coords.size() != static_cast<size_t>(dimensions)) {
-//         throw std::invalid_argument("Coordinate dimensionality mismatch");
-//     }
-
-//     if (!root) return {};
-
-//     // Min-heap (largest distance at top)
-//     using Neighbor = std::pair<double, TreeNode*>;
-//     std::priority_queue<
-//         Neighbor,
-//         std::vector<Neighbor>,
-//         std::less<Neighbor>
-//     > bestNeighbors;
-
-
-//     nearest_recursive_k(root, coords, 0, k, bestNeighbors);
-
-//     // Extract nodes from heap
-//     std::vector<TreeNode*> results;
-//     results.reserve(bestNeighbors.size());
-//     while (!bestNeighbors.empty()) {
-//         results.push_back(bestNeighbors.top().second);
-//         bestNeighbors.pop();
-//     }
-
-//     // Reverse so closest is first
-//     std::reverse(results.begin(), results.end());
-//     return results;
-// }
-
-    
-// void KDTreeStateSpace::nearest_recursive_k(
-//     TreeNode* node,
-//     const std::vector<int>& target,
-//     int depth,
-//     int k,
-//     std::priority_queue<
-//         std::pair<double, TreeNode*>,
-//         std::vector<std::pair<double, TreeNode*>>,
-//         std::less<std::pair<double, TreeNode*>>
-//     >& bestNeighbors
-// ) const {
-
-//     if (!node) return;
-
-//     // If bucket node → check all bucket children
-//     if (node->isBucket) {
-//         for (auto* child : node->bucket) {
-//             double dist = squared_distance(target, child->coords);
-//             if (bestNeighbors.size() < (size_t)k) {
-//                 bestNeighbors.emplace(dist, child);
-//             } else if (dist < bestNeighbors.top().first) {
-//                 bestNeighbors.pop();
-//                 bestNeighbors.emplace(dist, child);
-//             }
-//         }
-//         return;
-//     }
-
-//     // Distance to current node
-//     double dist = squared_distance(target, node->coords);
-//     if (bestNeighbors.size() < (size_t)k) {
-//         bestNeighbors.emplace(dist, node);
-//     } else if (dist < bestNeighbors.top().first) {
-//         bestNeighbors.pop();
-//         bestNeighbors.emplace(dist, node);
-//     }
-
-//     int axis = depth % dimensions;
-//     TreeNode* near = (target[axis] < node->coords[axis]) ? node->left : node->right;
-//     TreeNode* far  = (target[axis] < node->coords[axis]) ? node->right : node->left;
-
-//     // Explore near branch first
-//     nearest_recursive_k(near, target, depth + 1, k, bestNeighbors);
-
-//     // Check if far branch might contain closer neighbors
-//     double diff = static_cast<double>(target[axis] - node->coords[axis]);
-//     if (bestNeighbors.size() < (size_t)k || diff * diff < bestNeighbors.top().first) {
-//         nearest_recursive_k(far, target, depth + 1, k, bestNeighbors);
-//     }
-// }
+// [first, last) are the indices of the targets that still need this subtree. They are
+// reordered in place to form the groups for the children, so no scratch is allocated.
+void KDTreeStateSpace::batch_recursive(const TreeNode* node, const Coordinates* targets, int* first, int* last,
+                                       std::vector<Neighbor>& out) const {
+    if (!node || first == last) return;
+
+    // a handful of targets share too little to pay for the partitioning, they finish alone,
+    // starting from the sample the previous one settled on, which is usually close by
+    if (last - first <= BATCH_MIN_GROUP) {
+        for (int* t = first; t != last; ++t) {
+            if (t != first) {
+                const TreeNode* seed = out[t[-1]].node;
+                double dist = squared_distance(targets[*t], seed->coords);
+                if (dist < out[*t].squaredDistance) out[*t] = {seed, dist};
+            }
+            TreeNode* bestNode = const_cast<TreeNode*>(out[*t].node);
+            int unlimited = std::numeric_limits<int>::max();
+            nearest_recursive(const_cast<TreeNode*>(node), targets[*t], bestNode, out[*t].squaredDistance, unlimited);
+            out[*t].node = bestNode;
+        }
+        return;
+    }
+
+    auto offer = [&](const TreeNode* candidate) {
+        for (int* t = first; t != last; ++t) {
+            double dist = squared_distance(targets[*t], candidate->coords);
+            if (dist < out[*t].squaredDistance) out[*t] = {candidate, dist};
+        }
+    };
+
+    if (node->isBucket) {
+        for (const auto* child : node->bucket) offer(child);
+        return;
+    }
+    offer(node);
+
+    const int axis = node->axis;
+    const int split = node->coords[axis];
+    int* middle = std::partition(first, last, [&](int t) { return targets[t][axis] < split; });
+
+    batch_recursive(node->left, targets, first, middle, out);
+    batch_recursive(node->right, targets, middle, last, out);
+
+    // the far side, only for the targets whose best distance reaches across the split
+    auto reaches = [&](int t) {
+        double diff = static_cast<double>(targets[t][axis] - split);
+        return diff * diff * farScale < out[t].squaredDistance;
+    };
+    batch_recursive(node->right, targets, first, std::partition(first, middle, reaches), out);
+    batch_recursive(node->left, targets, middle, std::partition(middle, last, reaches), out);
+}
+
+void KDTreeStateSpace::radius_neighbors(const Coordinates& coords, double radius, std::vector<Neighbor>& out) const {
+    if (coords.size() != static_cast<size_t>(dimensions)) {
+        throw std::invalid_argument("Coordinate dimensionality mismatch");
+    }
+    out.clear();
+    if (radius < 0.0) return;
+
+    radius_recursive(root, coords, radius * radius, out);
+    std::sort(out.begin(), out.end(), closer);
+}
+
+void KDTreeStateSpace::radius_recursive(const TreeNode* node, const Coordinates& target, double radius2,
+                                        std::vector<Neighbor>& out) const {
+    if (!node) return;
+
+    if (node->isBucket) {
+        for (const auto* child : node->bucket) {
+            double dist = squared_distance(target, child->coords);
+            if (dist <= radius2) out.push_back({child, dist});
+        }
+        return;
+    }
+    double dist = squared_distance(target, node->coords);
+    if (dist <= radius2) out.push_back({node, dist});
+
+    int axis = node->axis;
+    bool goLeft = target[axis] < node->coords[axis];
+    radius_recursive(goLeft ? node->left : node->right, target, radius2, out);
+
+    double diff = static_cast<double>(target[axis] - node->coords[axis]);
+    if (diff * diff <= radius2)
+        radius_recursive(goLeft ? node->right : node->left, target, radius2, out);
+}
@@ -7,14 +7,14 @@
 #include <cmath>
 #include <limits>
 #include <unordered_map>
-#include <unordered_set>
 
 #include "StateSpace.hpp"
+#include "CellSlotMap.hpp"
 
 class KDTreeStateSpace : public StateSpace {
 private:
     struct TreeNode {
-        std::vector<int> coords;
+        Coordinates coords;
         double value;
         int axis;
         TreeNode* left;
@@ -22,50 +22,150 @@ private:
 
         std::vector<TreeNode*> bucket; // optional for bucket nodes
         bool isBucket;
+        int size = 1; // samples in the subtree, for a bucket node the samples in its bucket
 
-        TreeNode(const std::vector<int>& c, double v, int a)
+        TreeNode(const Coordinates& c, double v, int a)
             : coords(c), value(v), axis(a), left(nullptr), right(nullptr), isBucket(false) {}
     };
 
 
     TreeNode* root;
     int bucketSizeThreshold = 0; // No limit by default
-    std::unordered_set<TreeNode*> leafNodes;
+
+    // a subtree is rebuilt once one child holds more than this share of its samples
+    static constexpr double REBALANCE_ALPHA = 0.7;
+    // smaller groups of nearest_neighbors targets are searched one by one
+    static constexpr int BATCH_MIN_GROUP = 8;
+
+    // every stored value by cell, so get() never walks the tree
+    CellSlotMap cellSlots;
+    std::vector<double> values;
 
     // Helpers
-    TreeNode* insert_recursive(TreeNode* node, const std::vector<int>& coords, double value, int depth);
-    double get_recursive(TreeNode* node, const std::vector<int>& coords, int depth) const;
+    TreeNode* insert_recursive(TreeNode* node, const Coordinates& coords, double value, int depth);
+    const TreeNode* find_node(const Coordinates& coords) const;
     void destroy(TreeNode* node);
+    static int subtree_size(const TreeNode* node);
+    void rebalance(const Coordinates& coords);
+    TreeNode* rebuild(TreeNode* node);
+    void collect_samples(TreeNode* node, std::vector<TreeNode*>& samples);
+    TreeNode* build(TreeNode** first, TreeNode** last);
     void nearest_recursive(TreeNode* node,
-                                         const std::vector<int>& target,
-                                         int depth,
+                                         const Coordinates& target,
                                          TreeNode*& bestNode,
-                                         double& bestDist) const;
-    std::string coordsToString(std::vector<int> coords) const;
-    
+                                         double& bestDist,
+                                         int& checksLeft) const;
+    std::string coordsToString(Coordinates coords) const;
+
+public:
+    struct Neighbor {
+        const TreeNode* node;
+        double squaredDistance;
+    };
+
+    /**
+     * @brief Opt-in approximate nearest neighbour search. At 6 or more dimensions an exact
+     * search ends up comparing against most of the tree, these knobs trade accuracy for time.
+     */
+    struct Approximation {
+        // a far subtree is only entered if it may hold a sample (1 + epsilon) times closer than
+        // the current best, so every neighbour returned is within (1 + epsilon) of the true one
+        double epsilon = 0.0;
+        // samples compared before no more far subtrees are entered, 0 for no limit. The
+        // descent to the target's own bucket always completes.
+        int maxChecks = 0;
+    };
+
+private:
+    Approximation approximation; // exact by default
+    double farScale = 1.0;       // (1 + epsilon)^2, applied to squared distances to split planes
+
+    int check_budget() const { return approximation.maxChecks > 0 ? approximation.maxChecks : std::numeric_limits<int>::max(); }
+    void nearest_recursive_k(const TreeNode* node, const Coordinates& target, std::size_t k,
+                             std::vector<Neighbor>& heap, int& checksLeft) const;
+    void radius_recursive(const TreeNode* node, const Coordinates& target, double radius2,
+                          std::vector<Neighbor>& out) const;
+    void batch_recursive(const TreeNode* node, const Coordinates* targets, int* first, int* last,
+                         std::vector<Neighbor>& out) const;
+
 public:
     KDTreeStateSpace(int dimensions, int dimensionSize);
 
+    /**
+     * @brief Build a balanced tree over a batch of samples at once, splitting at the median of
+     * the widest axis (nth_element) down to buckets. A repeated cell keeps its last value.
+     */
+    KDTreeStateSpace(int dimensions, int dimensionSize, const std::vector<Coordinates>& coords,
+                     const std::vector<double>& values);
+
+    KDTreeStateSpace(const KDTreeStateSpace&) = delete;
+    KDTreeStateSpace& operator=(const KDTreeStateSpace&) = delete;
+
     ~KDTreeStateSpace();
 
     int get_dimensions() const override;
     int get_dimension_size() const override;
     
-    double get(const std::vector<int>& coords) const override;
-    double insert(const std::vector<int>& coords, double value);
+    double get(const Coordinates& coords) const override;
+    /**
+     * @brief Store a sample, replacing the value of an existing one at the same coordinates.
+     * When the insert leaves a subtree with more than REBALANCE_ALPHA of its samples on one
+     * side, the highest such subtree on the path is rebuilt balanced (scapegoat style), so the
+     * depth stays logarithmic whatever order the samples arrive in.
+     */
+    double insert(const Coordinates& coords, double value);
+
+    /**
+     * @brief Number of samples stored.
+     */
+    int size() const { return root ? root->size : 0; }
+
+    /**
+     * @brief Number of nodes on the longest root to leaf path, bucket entries not counted.
+     */
+    int depth() const;
 
     TreeNode* get_root();
-    KDTreeStateSpace::TreeNode* nearest_neighbor(const std::vector<int>& coords) const;
+    KDTreeStateSpace::TreeNode* nearest_neighbor(const Coordinates& coords) const;
+
+    /**
+     * @brief Make nearest_neighbor, nearest_k_neighbors and nearest_neighbors approximate,
+     * or exact again with the default Approximation. nearest_neighbors honours epsilon only.
+     * radius_neighbors always stays exact.
+     */
+    void set_approximation(const Approximation& approximation);
+    const Approximation& get_approximation() const { return approximation; }
+
+    /**
+     * @brief The k samples closest to coords, nearest first, written to out.
+     *
+     * out doubles as the bounded max-heap of the search, so a caller that keeps one vector
+     * per thread and passes it to every query allocates nothing once it has held k neighbours.
+     */
+    void nearest_k_neighbors(const Coordinates& coords, int k, std::vector<Neighbor>& out) const;
+
+    /**
+     * @brief The nearest sample of every target at once, out[i] for targets[i], with a null
+     * node if the tree is empty.
+     *
+     * The targets are split by the same planes as the tree on the way down, so each node is
+     * visited once for the whole group of targets that reaches it, and a far subtree is only
+     * entered with the targets whose current best can still improve there. Small groups finish
+     * one target at a time, each starting from the sample its neighbour in the group found.
+     */
+    void nearest_neighbors(const std::vector<Coordinates>& targets, std::vector<Neighbor>& out) const;
+
+    /**
+     * @brief Every sample at most radius from coords, nearest first, written to out.
+     */
+    void radius_neighbors(const Coordinates& coords, double radius, std::vector<Neighbor>& out) const;
 
-    double squared_distance(const std::vector<int>& a, const std::vector<int>& b) const;
+    double squared_distance(const Coordinates& a, const Coordinates& b) const;
 
-    std::vector<TreeNode*> get_leaves() const {
-        std::vector<TreeNode*> leafNodesVec;
-        for (const auto& node : leafNodes) {
-            leafNodesVec.push_back(node);
-        }
-        return leafNodesVec;
-    }
+    /**
+     * @brief The bucket nodes, and the nodes without children, of the current tree.
+     */
+    std::vector<TreeNode*> get_leaves() const;
 };
 
 #endif // KD_TREE_STATE_SPACE
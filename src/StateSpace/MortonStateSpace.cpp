@@ -0,0 +1,136 @@
+#include "MortonStateSpace.hpp"
+
+#include <algorithm>
+#include <string>
+
+#include "../Models/Tools/GridOdometer.hpp"
+
+// bits needed to address 0..dimensionSize-1 along one axis
+static int axis_bits(int dimensionSize) {
+    int bits = 0;
+    while ((1LL << bits) < dimensionSize) bits++;
+    return bits;
+}
+
+MortonStateSpace::MortonStateSpace(int dimensions, int dimensionSize, double initialValues) :
+        StateSpace(dimensions, dimensionSize)
+{
+    long long gridCells = cell_count(dimensions, dimensionSize); // validates the shape
+    if (dimensions == 0 || dimensionSize == 0) {
+        tileBits = 0;
+        tileMask = 0;
+        tileCells = 1;
+        tilesPerAxis = 0;
+        cells.assign(gridCells, initialValues);
+        return;
+    }
+
+    tileBits = std::max(1, std::min(TILE_BITS_TOTAL / dimensions, axis_bits(dimensionSize)));
+    if (tileBits * dimensions > 63)
+        throw std::invalid_argument("Too many dimensions for a Morton tile");
+    tileMask = (1u << tileBits) - 1;
+    tileCells = 1LL << (tileBits * dimensions);
+    tilesPerAxis = (dimensionSize + tileMask) >> tileBits;
+
+    long long tiles = cell_count(dimensions, (int)tilesPerAxis);
+    if (tiles > std::numeric_limits<long long>::max() / tileCells)
+        throw std::overflow_error("Padded Morton grid does not fit a 64-bit index");
+
+    tileStrides.assign(dimensions, 1);
+    for (int d = dimensions - 2; d >= 0; --d) tileStrides[d] = tileStrides[d + 1] * tilesPerAxis;
+
+    // bit k of axis d lands at k * dimensions + (dimensions - 1 - d), so axis 0 is the most
+    // significant of every group, matching row-major order inside a 2^dimensions block
+    axisMasks.assign(dimensions, 0);
+    for (int d = 0; d < dimensions; ++d)
+        for (int k = 0; k < tileBits; ++k)
+            axisMasks[d] |= 1ULL << (k * dimensions + (dimensions - 1 - d));
+
+#ifndef MASS_HAVE_BMI2
+    spread.assign((std::size_t)dimensions << tileBits, 0);
+    for (int d = 0; d < dimensions; ++d)
+        for (unsigned c = 0; c <= tileMask; ++c)
+            for (int k = 0; k < tileBits; ++k)
+                if (c >> k & 1) spread[((std::size_t)d << tileBits) + c] |= 1ULL << (k * dimensions + (dimensions - 1 - d));
+#endif
+
+    cells.assign(tiles * tileCells, initialValues);
+}
+
+int MortonStateSpace::get_dimensions() const {
+    return this->dimensions;
+}
+
+int MortonStateSpace::get_dimension_size() const {
+    return this->dimensionSize;
+}
+
+unsigned MortonStateSpace::extract(int axis, std::uint64_t inner) const noexcept {
+#ifdef MASS_HAVE_BMI2
+    return (unsigned)_pext_u64(inner, axisMasks[axis]);
+#else
+    unsigned value = 0;
+    for (int k = 0; k < tileBits; ++k)
+        value |= (unsigned)(inner >> (k * dimensions + (dimensions - 1 - axis)) & 1) << k;
+    return value;
+#endif
+}
+
+long long MortonStateSpace::checked_index(const Coordinates& coords) const {
+    if (coords.size() != static_cast<size_t>(this->dimensions))
+        throw std::invalid_argument("Index has Invalid Number of Dimensions");
+    // bounds check and interleave in one pass
+    long long tile = 0;
+    std::uint64_t inner = 0;
+    for (int d = 0; d < dimensions; ++d) {
+        if (coords[d] < 0 || coords[d] >= this->dimensionSize)
+            throw std::out_of_range("Coordinate at index [" + std::to_string(d) + "] out of range");
+        unsigned c = (unsigned)coords[d];
+        tile += (long long)(c >> tileBits) * tileStrides[d];
+        inner |= deposit(d, c & tileMask);
+    }
+    return tile * tileCells + (long long)inner;
+}
+
+double MortonStateSpace::get(const Coordinates& coords) const {
+    return cells[checked_index(coords)];
+}
+
+double MortonStateSpace::set(const Coordinates& coords, double value) {
+    return cells[checked_index(coords)] = value;
+}
+
+Coordinates MortonStateSpace::coords_of(long long storageIndex) const {
+    if (storageIndex < 0 || storageIndex >= (long long)cells.size())
+        throw std::out_of_range("Storage index " + std::to_string(storageIndex) + " out of range");
+    long long tile = storageIndex / tileCells;
+    std::uint64_t inner = (std::uint64_t)(storageIndex % tileCells);
+
+    Coordinates coords(dimensions);
+    for (int d = dimensions - 1; d >= 0; --d) {
+        coords[d] = (int)((tile % tilesPerAxis) << tileBits) | (int)extract(d, inner);
+        tile /= tilesPerAxis;
+    }
+    return coords;
+}
+
+void MortonStateSpace::copy_row_major(std::span<double> out) const {
+    long long total = cell_count(dimensions, dimensionSize);
+    if ((long long)out.size() != total)
+        throw std::invalid_argument("Row-major output holds " + std::to_string(out.size()) + " values, not " +
+                                    std::to_string(total));
+    if (total == 0 || dimensions == 0) {
+        std::copy_n(cells.begin(), total, out.begin());
+        return;
+    }
+
+    GridOdometer cell(dimensions, dimensionSize, 0);
+    for (long long i = 0; i < total; ++i, cell.next())
+        out[i] = cells[index(cell.coords())];
+}
+
+std::vector<double> MortonStateSpace::get_raw_representation() const {
+    std::vector<double> rowMajor(cell_count(dimensions, dimensionSize));
+    copy_row_major(rowMajor);
+    return rowMajor;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file MortonStateSpace.hpp
+ * @brief Declares MortonStateSpace, an array state space stored in tiled Morton (Z-order) layout.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef MORTON_STATE_SPACE_H
+#define MORTON_STATE_SPACE_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "StateSpace.hpp"
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#define MASS_HAVE_BMI2 1
+#endif
+
+/**
+ * @brief A dense state space whose cells are grouped into cubic tiles, with the cells of a
+ * tile in Morton order.
+ *
+ * Row-major storage puts neighbours along the first axes a whole row or slab apart, so
+ * stencils and neighbourhood scans over a large grid miss the cache on almost every step.
+ * Here a cell and its neighbours share a tile of at most TILE_BITS_TOTAL address bits
+ * (32 KiB of doubles) unless they straddle a tile edge. Tiles are laid out row-major.
+ *
+ * The per-axis bit interleave uses BMI2 pdep/pext when the build targets it (-mbmi2 or
+ * -march=native), and small lookup tables otherwise. Each axis is padded up to a whole
+ * number of tiles, so raw_view() is longer than the number of cells. get_raw_representation()
+ * and copy_row_major() read the grid out in the row-major order used by ArrayStateSpace.
+ */
+class MortonStateSpace : public StateSpace {
+public:
+    static constexpr int TILE_BITS_TOTAL = 12;
+
+    MortonStateSpace(int dimensions, int dimensionSize, double initialValues = 0.0);
+
+    int get_dimensions() const override;
+
+    int get_dimension_size() const override;
+
+    double get(const Coordinates& coords) const override;
+
+    double set(const Coordinates& coords, double value);
+
+    /**
+     * @brief Storage index of coords, which must lie inside the grid.
+     */
+    long long index(const Coordinates& coords) const noexcept {
+        long long tile = 0;
+        std::uint64_t inner = 0;
+        for (int d = 0; d < dimensions; ++d) {
+            unsigned c = (unsigned)coords[d];
+            tile += (long long)(c >> tileBits) * tileStrides[d];
+            inner |= deposit(d, c & tileMask);
+        }
+        return tile * tileCells + (long long)inner;
+    }
+
+    /**
+     * @brief The cell stored at a storage index, the inverse of index().
+     */
+    Coordinates coords_of(long long storageIndex) const;
+
+    /**
+     * @brief The cells in row-major order (last coordinate fastest), as ArrayStateSpace stores them.
+     */
+    std::vector<double> get_raw_representation() const;
+
+    /**
+     * @brief Write the cells in row-major order into out, which holds cell_count() values.
+     */
+    void copy_row_major(std::span<double> out) const;
+
+    /**
+     * @brief The storage, padding included, in tile then Morton order.
+     */
+    std::span<const double> raw_view() const { return cells; }
+    std::span<double> raw_view() { return cells; }
+
+    int tile_side() const { return 1 << tileBits; }
+
+private:
+    int tileBits;
+    unsigned tileMask;
+    long long tileCells;
+    long long tilesPerAxis;
+    std::vector<long long> tileStrides;   // row-major strides of the tile grid
+    std::vector<std::uint64_t> axisMasks; // bits of an inner index that belong to each axis
+#ifndef MASS_HAVE_BMI2
+    std::vector<std::uint64_t> spread;    // [axis * tileSide + c], c's bits moved onto the axis mask
+#endif
+    std::vector<double> cells;
+
+    std::uint64_t deposit(int axis, unsigned value) const noexcept {
+#ifdef MASS_HAVE_BMI2
+        return _pdep_u64(value, axisMasks[axis]);
+#else
+        return spread[((std::size_t)axis << tileBits) + value];
+#endif
+    }
+
+    unsigned extract(int axis, std::uint64_t inner) const noexcept;
+
+    long long checked_index(const Coordinates& coords) const;
+};
+
+#endif // MORTON_STATE_SPACE_H
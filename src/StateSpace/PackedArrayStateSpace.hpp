@@ -0,0 +1,107 @@
+/**
+ * @file PackedArrayStateSpace.hpp
+ * @brief Declares PackedArrayStateSpace, a dense state space whose cells are stored in a chosen element type.
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+#ifndef PACKED_ARRAY_STATE_SPACE_H
+#define PACKED_ARRAY_STATE_SPACE_H
+
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "DenseStateSpace.hpp"
+#include "CellCodec.hpp"
+
+/**
+ * @brief An ArrayStateSpace with the cells stored as Cell instead of double.
+ *
+ * float halves the memory of a dense grid, BFloat16, Half and UNorm16 quarter it. The
+ * interface still reads and writes doubles: get/set convert one cell, read/write convert
+ * whole runs of cells through the vectorised encode_cells/decode_cells. The layout is
+ * row-major like ArrayStateSpace.
+ */
+template <typename Cell>
+class PackedArrayStateSpace : public DenseStateSpace {
+public:
+    PackedArrayStateSpace(int dimensions, int dimensionSize, double initialValues = 0.0)
+        : DenseStateSpace(dimensions, dimensionSize),
+          cells(cell_count(dimensions, dimensionSize), CellCodec<Cell>::encode(initialValues))
+    {}
+
+    int get_dimensions() const override { return dimensions; }
+
+    int get_dimension_size() const override { return dimensionSize; }
+
+    double get(const Coordinates& coords) const override {
+        return CellCodec<Cell>::decode(cells[coords_to_index(coords)]);
+    }
+
+    /**
+     * @brief Store value, rounded to the cell type.
+     * @return the value as stored
+     */
+    double set(const Coordinates& coords, double value) override {
+        Cell& cell = cells[coords_to_index(coords)];
+        cell = CellCodec<Cell>::encode(value);
+        return CellCodec<Cell>::decode(cell);
+    }
+
+    /**
+     * @brief Decode out.size() cells starting at row-major index begin.
+     */
+    void read(long long begin, std::span<double> out) const {
+        check_range(begin, out.size());
+        decode_cells(cells.data() + begin, out.data(), out.size());
+    }
+
+    /**
+     * @brief Encode values into the cells starting at row-major index begin.
+     */
+    void write(long long begin, std::span<const double> values) {
+        check_range(begin, values.size());
+        encode_cells(values.data(), cells.data() + begin, values.size());
+    }
+
+    std::vector<double> get_raw_representation() const override {
+        std::vector<double> values(cells.size());
+        read(0, values);
+        return values;
+    }
+
+    /**
+     * @brief The encoded cells in row-major order, without copying them.
+     */
+    std::span<const Cell> raw_view() const { return cells; }
+    std::span<Cell> raw_view() { return cells; }
+
+private:
+    std::vector<Cell> cells;
+
+    long long coords_to_index(const Coordinates& coords) const {
+        if (coords.size() != static_cast<size_t>(this->dimensions))
+            throw std::invalid_argument("Index has Invalid Number of Dimensions");
+        long long rawIndex = 0;
+        for (int i = 0; i < dimensions; i++) {
+            if (coords[i] < 0 || coords[i] >= this->dimensionSize)
+                throw std::out_of_range("Coordinate at index [" + std::to_string(i) + "] out of range");
+            rawIndex = rawIndex * dimensionSize + coords[i];
+        }
+        return rawIndex;
+    }
+
+    void check_range(long long begin, std::size_t count) const {
+        if (begin < 0 || begin > (long long)cells.size() || count > cells.size() - begin)
+            range_error(begin, count);
+    }
+
+    [[noreturn]] static void range_error(long long begin, std::size_t count) {
+        throw std::out_of_range("Cells [" + std::to_string(begin) + ", " + std::to_string(begin + (long long)count) +
+                                ") are not in the state space");
+    }
+};
+
+#endif // PACKED_ARRAY_STATE_SPACE_H
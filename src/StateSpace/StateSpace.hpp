@@ -15,6 +15,11 @@
 #include <vector>
 #include <iostream>
 #include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "Coordinates.hpp"
 
 class StateSpace {
 protected:
@@ -22,12 +27,30 @@ protected:
     int dimensionSize;
 public:
     StateSpace(int dimensions, int dimensionSize): dimensions(dimensions), dimensionSize(dimensionSize) {}
+    virtual ~StateSpace() = default;
     
     virtual int get_dimensions() const = 0;
 
     virtual int get_dimension_size() const = 0;
     
-    virtual double get(const std::vector<int>& coords) const = 0;
+    virtual double get(const Coordinates& coords) const = 0;
+
+    /**
+     * @brief Number of cells, dimensionSize^dimensions, as a 64-bit linear index bound.
+     * Throws std::overflow_error rather than wrapping if it does not fit.
+     */
+    static long long cell_count(int dimensions, int dimensionSize) {
+        if (dimensions < 0 || dimensionSize < 0)
+            throw std::invalid_argument("Negative state space shape");
+        long long cells = 1;
+        for (int d = 0; d < dimensions; d++) {
+            if (dimensionSize != 0 && cells > std::numeric_limits<long long>::max() / dimensionSize)
+                throw std::overflow_error(std::to_string(dimensionSize) + "^" + std::to_string(dimensions) +
+                                          " cells do not fit a 64-bit index");
+            cells *= dimensionSize;
+        }
+        return cells;
+    }
 };
 
 #endif // STATE_SPACE_H
\ No newline at end of file
@@ -1,7 +1,14 @@
 #include <vector>
 #include <iostream>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
 
 #include "InputOutput/CommandLineInputOutput.hpp"
+#include "InputOutput/BufferedStreamIO.hpp"
+#include "InputOutput/CoroutineDriver.hpp"
+#include "InputOutput/ProcessPoolInputOutput.hpp"
+#include "StateSpace/ArrayStateSpaceN.hpp"
 
 #if defined(LINEAR)
     #include "Models/LinearModel.hpp"
@@ -25,32 +32,170 @@
     #error "Algorthim was not defined please check readme for build instructions"
 #endif
 
-void algorithm(int dimensions, int dimensionSize, int totalQueries){
+// options only some models take, main rejects them for the others
+struct ModelOptions {
+    DenseStorage storage; // LINEAR and DUMB
+    bool partitionOfUnity = false; // RBF
+    double evaluationTolerance = 0.0; // RBF
+};
+
+int algorithm(int dimensions, int dimensionSize, int totalQueries, int batchSize, int inFlight,
+              const std::string &checkpointPath, const std::string &resumeFrom, const ModelOptions &options){
     InputOutput *io = InputOutput::get_instance();
 
+#if defined(LINEAR) || defined(DUMB)
+    CurrentModel model(dimensions, dimensionSize, totalQueries, options.storage);
+#else
     CurrentModel model(dimensions, dimensionSize, totalQueries);
+#endif
+#if defined(RBF)
+    model.set_partition_of_unity(options.partitionOfUnity);
+    model.set_evaluation_tolerance(options.evaluationTolerance);
+#endif
+    if ((!checkpointPath.empty() || !resumeFrom.empty()) && !model.supports_snapshots()) {
+        std::cerr << "--checkpoint and --resume are not supported by this model\n";
+        return 1;
+    }
+    if (!resumeFrom.empty()) model.load_snapshot(resumeFrom);
+    const int resumedAt = model.answered_queries();
 
-    for (int i = 0; i < totalQueries; i++){
-        std::vector<int> query = model.get_next_query();
-        double result = io->send_query_recieve_result(query);
-        model.update_prediction(query, result);
+    if (inFlight > 1) {
+        auto *oracle = dynamic_cast<AsyncOracle*>(io);
+        if (!oracle) throw std::runtime_error("IO does not support queries in flight");
+        CoroutineDriver(*oracle, inFlight).run(model, totalQueries);
+    } else {
+        io->run_queries(model, totalQueries, batchSize);
     }
+    // the final snapshot holds the trained model, so reconstruction can be redone without the oracle
+    if (model.answered_queries() != resumedAt) InputOutput::checkpoint(model, -1);
     io->output_state(model);
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 4) { // program name + 3 integers
-        std::cerr << "Usage: " << argv[0] << " Dimensions : int,  Array size : int,  Maximum number of totalQueries : int\n";
+    if (argc < 4) { // program name + 3 integers
+        std::cerr << "Usage: " << argv[0] << " Dimensions : int,  Array size : int,  Maximum number of totalQueries : int"
+                  << "  [--batch queriesPerRoundTrip : int]  [--output-format text|f64|f32|bf16|f16|u16]  [--output-file path]"
+                  << "  [--threads reconstructionThreads : int]  [--in-flight outstandingQueries : int]"
+                  << "  [--buffered-io]  [--checkpoint path]  [--checkpoint-every results : int]  [--resume path]"
+                  << "  [--cell-type f64|f32|bf16|f16|u16]  [--state-file path]  [--partition-of-unity]  [--evaluation-tolerance tolerance : double]  [--oracles processes : int -- oracle command...]\n";
         return 1;
     }
     
     int dimensions = std::atoi(argv[1]);
     int dimensionSize = std::atoi(argv[2]);
     int totalQueries = std::atoi(argv[3]);
+    int batchSize = 1;
+    int threads = 1;
+    int inFlight = 0; // 0 until given, defaults to one per oracle process
+    int oracles = 0;
+    bool bufferedIO = false;
+    std::string checkpointPath, resumeFrom;
+    int checkpointEvery = 1000;
+    std::vector<std::string> oracleCommand;
+    auto outputFormat = CommandLineInputOutput::TEXT;
+    std::string outputFile;
+    ModelOptions options;
+    DenseStorage &storage = options.storage;
+    bool denseStorageSet = false;
 
-    CommandLineInputOutput::set_IO();
+    for (int i = 4; i < argc; i++){
+        std::string opt = argv[i];
+        if (opt == "--batch" && i + 1 < argc){
+            batchSize = std::max(1, std::atoi(argv[++i]));
+        } else if (opt == "--output-format" && i + 1 < argc){
+            std::string format = argv[++i];
+            if (format == "text") outputFormat = CommandLineInputOutput::TEXT;
+            else if (format == "f64") outputFormat = CommandLineInputOutput::BINARY_F64;
+            else if (format == "f32") outputFormat = CommandLineInputOutput::BINARY_F32;
+            else if (format == "bf16") outputFormat = CommandLineInputOutput::BINARY_BF16;
+            else if (format == "f16") outputFormat = CommandLineInputOutput::BINARY_F16;
+            else if (format == "u16") outputFormat = CommandLineInputOutput::BINARY_U16;
+            else {
+                std::cerr << "Unknown output format " << format << "\n";
+                return 1;
+            }
+        } else if (opt == "--cell-type" && i + 1 < argc){
+            std::string type = argv[++i];
+            if (type == "f64") storage.cellType = DenseStorage::F64;
+            else if (type == "f32") storage.cellType = DenseStorage::F32;
+            else if (type == "bf16") storage.cellType = DenseStorage::BF16;
+            else if (type == "f16") storage.cellType = DenseStorage::F16;
+            else if (type == "u16") storage.cellType = DenseStorage::U16;
+            else {
+                std::cerr << "Unknown cell type " << type << "\n";
+                return 1;
+            }
+            denseStorageSet = true;
+        } else if (opt == "--state-file" && i + 1 < argc){
+            storage.path = argv[++i];
+            denseStorageSet = true;
+        } else if (opt == "--output-file" && i + 1 < argc){
+            outputFile = argv[++i];
+        } else if (opt == "--threads" && i + 1 < argc){
+            threads = std::max(1, std::atoi(argv[++i]));
+        } else if (opt == "--in-flight" && i + 1 < argc){
+            inFlight = std::max(1, std::atoi(argv[++i]));
+        } else if (opt == "--checkpoint" && i + 1 < argc){
+            checkpointPath = argv[++i];
+        } else if (opt == "--checkpoint-every" && i + 1 < argc){
+            checkpointEvery = std::max(1, std::atoi(argv[++i]));
+        } else if (opt == "--resume" && i + 1 < argc){
+            resumeFrom = argv[++i];
+        } else if (opt == "--partition-of-unity"){
+            options.partitionOfUnity = true;
+        } else if (opt == "--evaluation-tolerance" && i + 1 < argc){
+            options.evaluationTolerance = std::max(0.0, std::atof(argv[++i]));
+        } else if (opt == "--buffered-io"){
+            bufferedIO = true;
+        } else if (opt == "--oracles" && i + 1 < argc){
+            oracles = std::max(1, std::atoi(argv[++i]));
+        } else if (opt == "--"){
+            oracleCommand.assign(argv + i + 1, argv + argc);
+            break;
+        } else {
+            std::cerr << "Unknown option " << opt << "\n";
+            return 1;
+        }
+    }
 
-    algorithm(dimensions, dimensionSize, totalQueries);
+    if (oracles > 0 && oracleCommand.empty()) {
+        std::cerr << "--oracles needs the oracle command after --\n";
+        return 1;
+    }
+    if (oracles > 0 && bufferedIO) {
+        std::cerr << "--buffered-io applies to stdin/stdout, not to --oracles\n";
+        return 1;
+    }
+#if !defined(LINEAR) && !defined(DUMB)
+    if (denseStorageSet) {
+        std::cerr << "--cell-type and --state-file apply to the dense LINEAR and DUMB models only\n";
+        return 1;
+    }
+#endif
+#if !defined(RBF)
+    if (options.partitionOfUnity || options.evaluationTolerance > 0.0) {
+        std::cerr << "--partition-of-unity and --evaluation-tolerance apply to the RBF model only\n";
+        return 1;
+    }
+#endif
+    if (!storage.path.empty() && storage.cellType != DenseStorage::F64) {
+        std::cerr << "--state-file holds f64 cells, it cannot be combined with another --cell-type\n";
+        return 1;
+    }
+    if (inFlight == 0) inFlight = (oracles > 0 && batchSize == 1) ? oracles : 1;
 
-    return 0;
+    if (oracles > 0) ProcessPoolInputOutput::set_IO(oracleCommand, oracles);
+    else if (bufferedIO) BufferedStreamIO::set_IO();
+    else CommandLineInputOutput::set_IO();
+    CommandLineInputOutput::set_output_format(outputFormat, outputFile);
+    CommandLineInputOutput::set_threads(threads);
+    CommandLineInputOutput::set_checkpoint(checkpointPath, checkpointEvery);
+
+    if (batchSize > 1 && inFlight > 1) {
+        std::cerr << "--batch and --in-flight cannot be combined\n";
+        return 1;
+    }
+
+    return algorithm(dimensions, dimensionSize, totalQueries, batchSize, inFlight, checkpointPath, resumeFrom, options);
 }
\ No newline at end of file
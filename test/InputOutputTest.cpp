@@ -3,6 +3,27 @@
 
 #include "../src/InputOutput/InputOutput.hpp"
 #include "../src/InputOutput/CommandLineInputOutput.hpp"
+#include "../src/InputOutput/BinaryStateWriter.hpp"
+#include "../src/StateSpace/CellCodec.hpp"
+#include "../src/InputOutput/ParallelEvaluator.hpp"
+#include "../src/InputOutput/CoroutineDriver.hpp"
+#include "../src/InputOutput/ProcessPoolInputOutput.hpp"
+#include "../src/InputOutput/BufferedStreamIO.hpp"
+#include "../src/Models/DumbModel.hpp"
+#include "../src/Models/GEKModel.hpp"
+#include "../src/Models/TestModel.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <unistd.h>
+#endif
 
 
 TEST(TestCommandLine, testCLIOinnit){
@@ -30,7 +51,7 @@ TEST(TestCommandLine, testingCLIO__1){
     std::istringstream input("42\n");
     std::streambuf* oldCin = std::cin.rdbuf(input.rdbuf());
 
-    std::vector<int> query = {0,0,0};
+    Coordinates query = {0,0,0};
     double result = io->send_query_recieve_result(query);
     std::cout.rdbuf(oldCout);
 
@@ -52,7 +73,7 @@ TEST(TestCommandLine, testingCLIO__2){
     std::istringstream input("1.001\n");
     std::streambuf* oldCin = std::cin.rdbuf(input.rdbuf());
 
-    std::vector<int> query = {1,2,3};
+    Coordinates query = {1,2,3};
     double result = io->send_query_recieve_result(query);
     std::cout.rdbuf(oldCout);
 
@@ -74,7 +95,7 @@ TEST(TestCommandLine, testingCLIO__3){
     std::istringstream input("1.001\n");
     std::streambuf* oldCin = std::cin.rdbuf(input.rdbuf());
 
-    std::vector<int> query = {1};
+    Coordinates query = {1};
     double result = io->send_query_recieve_result(query);
     std::cout.rdbuf(oldCout);
 
@@ -96,10 +117,433 @@ TEST(TestCommandLine, testingCLIO__4){
     std::istringstream input("test\n");
     std::streambuf* oldCin = std::cin.rdbuf(input.rdbuf());
 
-    std::vector<int> query = {1,2,3};
+    Coordinates query = {1,2,3};
     double result = io->send_query_recieve_result(query);
     std::cout.rdbuf(oldCout);
 
     EXPECT_EQ(result, 0);
     EXPECT_EQ(buffer.str(), "1,2,3\n");
-}
\ No newline at end of file
+}
+// batched queries are written as one block, then one result is read per query
+TEST(TestCommandLine, testingCLIOBatch){
+    // use clio input output
+    CommandLineInputOutput::set_IO();
+
+    InputOutput* io = InputOutput::get_instance();
+    
+    // Redirect cout to a stringstream
+    std::stringstream buffer;
+    std::streambuf* oldCout = std::cout.rdbuf(buffer.rdbuf());
+
+    std::istringstream input("0.5\n1.25\n-2\n");
+    std::streambuf* oldCin = std::cin.rdbuf(input.rdbuf());
+
+    std::vector<Coordinates> queries = {{1,2,3}, {0,0,0}, {4,5,6}};
+    std::vector<double> results = io->send_queries_recieve_results(queries);
+    std::cout.rdbuf(oldCout);
+    std::cin.rdbuf(oldCin);
+
+    EXPECT_EQ(results, std::vector<double>({0.5, 1.25, -2}));
+    EXPECT_EQ(buffer.str(), "1,2,3\n0,0,0\n4,5,6\n");
+}
+
+// binary output is a 32 byte header followed by one raw value per cell
+TEST(TestCommandLine, testingCLIOBinaryOutput){
+    CommandLineInputOutput::set_IO();
+    CommandLineInputOutput::set_output_format(CommandLineInputOutput::BINARY_F64);
+
+    InputOutput* io = InputOutput::get_instance();
+    DumbModel model(2, 3, 1);
+
+    std::stringstream buffer;
+    std::streambuf* oldCout = std::cout.rdbuf(buffer.rdbuf());
+    io->output_state(model);
+    std::cout.rdbuf(oldCout);
+    CommandLineInputOutput::set_output_format(CommandLineInputOutput::TEXT);
+
+    std::string bytes = buffer.str();
+    ASSERT_EQ(bytes.size(), BinaryStateWriter::HEADER_SIZE + 9 * sizeof(double));
+    EXPECT_EQ(bytes.substr(0, 4), "MASS");
+    EXPECT_EQ(bytes[8], BinaryStateWriter::FLOAT64);
+    EXPECT_EQ(bytes[12], 2);
+    EXPECT_EQ(bytes[16], 3);
+    EXPECT_EQ(bytes[24], 9);
+
+    for (int i = 0; i < 9; i++) {
+        double value;
+        std::memcpy(&value, bytes.data() + BinaryStateWriter::HEADER_SIZE + i * sizeof(double), sizeof(double));
+        EXPECT_EQ(value, model.get_value_at(InputOutput::index_to_coords(i, 2, 3)));
+    }
+}
+
+// an f64 output file is filled through a file-backed ArrayStateSpace, the bytes match the stream output
+TEST(TestCommandLine, testingCLIOBinaryOutputFile){
+    auto path = std::filesystem::temp_directory_path() / "mass_cli_output_test.bin";
+    DumbModel model(2, 3, 1);
+
+    CommandLineInputOutput::set_IO();
+    CommandLineInputOutput::set_output_format(CommandLineInputOutput::BINARY_F64);
+    std::stringstream buffer;
+    std::streambuf* oldCout = std::cout.rdbuf(buffer.rdbuf());
+    InputOutput::get_instance()->output_state(model);
+    std::cout.rdbuf(oldCout);
+
+    CommandLineInputOutput::set_output_format(CommandLineInputOutput::BINARY_F64, path.string());
+    InputOutput::get_instance()->output_state(model);
+    CommandLineInputOutput::set_output_format(CommandLineInputOutput::TEXT);
+
+    std::ifstream file(path, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    std::filesystem::remove(path);
+    EXPECT_EQ(buffer.str(), bytes);
+}
+
+TEST(TestCommandLine, testingIndexToCoordsBeyond32Bits){
+    const long long last = StateSpace::cell_count(4, 1024) - 1;
+    EXPECT_EQ(Coordinates({1023, 1023, 1023, 1023}), InputOutput::index_to_coords(last, 4, 1024));
+    EXPECT_EQ(Coordinates({2, 0, 0, 0}), InputOutput::index_to_coords(2LL << 30, 4, 1024));
+    EXPECT_THROW(InputOutput::index_to_coords(-1, 4, 1024), std::out_of_range);
+
+    GridOdometer cell(4, 1024, last - 1);
+    cell.next();
+    EXPECT_EQ(InputOutput::index_to_coords(last, 4, 1024), cell.coords());
+}
+
+TEST(TestCommandLine, testingBinaryWriterFile){
+    auto path = std::filesystem::temp_directory_path() / "mass_binary_writer_test.bin";
+    std::vector<double> values = {0.0, 0.25, 0.5, 0.75, 1.0, -1.0, 2.5, 3.0};
+
+    BinaryStateWriter writer(path.string(), 3, 2, BinaryStateWriter::FLOAT32);
+    writer.write(values.data(), 3);
+    writer.write(values.data() + 3, 5);
+    writer.close();
+
+    std::ifstream in(path, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::filesystem::remove(path);
+
+    ASSERT_EQ(bytes.size(), BinaryStateWriter::HEADER_SIZE + values.size() * sizeof(float));
+    EXPECT_EQ(bytes.substr(0, 4), "MASS");
+    EXPECT_EQ(bytes[8], BinaryStateWriter::FLOAT32);
+    for (size_t i = 0; i < values.size(); i++) {
+        float value;
+        std::memcpy(&value, bytes.data() + BinaryStateWriter::HEADER_SIZE + i * sizeof(float), sizeof(float));
+        EXPECT_EQ(value, (float)values[i]);
+    }
+}
+
+TEST(TestCommandLine, testingBinaryWriterHalfPrecision){
+    std::vector<double> values = {0.0, 0.25, 0.5, 0.75, 1.0, 1.0 / 3.0};
+    for (auto type : {BinaryStateWriter::BFLOAT16, BinaryStateWriter::FLOAT16, BinaryStateWriter::UNORM16}){
+        std::stringstream buffer;
+        BinaryStateWriter writer(buffer, 1, 6, type);
+        writer.write(values.data(), values.size());
+        writer.close();
+
+        std::string bytes = buffer.str();
+        ASSERT_EQ(bytes.size(), BinaryStateWriter::HEADER_SIZE + values.size() * 2);
+        EXPECT_EQ(bytes[8], type);
+        for (size_t i = 0; i < values.size(); i++){
+            const unsigned char* le = reinterpret_cast<const unsigned char*>(bytes.data()) + BinaryStateWriter::HEADER_SIZE + 2 * i;
+            std::uint16_t bits = (std::uint16_t)(le[0] | le[1] << 8);
+            double decoded = type == BinaryStateWriter::BFLOAT16 ? CellCodec<BFloat16>::decode({bits})
+                           : type == BinaryStateWriter::FLOAT16  ? CellCodec<Half>::decode({bits})
+                                                                 : CellCodec<UNorm16>::decode({bits});
+            EXPECT_NEAR(values[i], decoded, 1.0 / 256);
+        }
+    }
+}
+
+TEST(TestCommandLine, testingBinaryWriterShortWrite){
+    std::stringstream buffer;
+    BinaryStateWriter writer(buffer, 2, 2, BinaryStateWriter::FLOAT64);
+    double value = 1.0;
+    writer.write(&value, 1);
+    EXPECT_THROW(writer.close(), std::runtime_error);
+}
+
+// chunks are tiny so threads run out of their own share and steal
+TEST(TestCommandLine, testingParallelMatchesSerial){
+    GEKModel model(2, 24, 90);
+    for (int i = 0; i < 90; i++){
+        auto query = model.get_next_query();
+        model.update_prediction(query, (query[0] * 7 + query[1] * 3) % 5 / 4.0);
+    }
+
+    const long long cells = model.cell_count();
+    std::vector<double> serial(cells);
+    model.evaluate_grid(serial.data());
+
+    for (int threads : {2, 3, 8}){
+        std::vector<double> parallel(cells, -1);
+        ParallelEvaluator(threads, 5).evaluate(model, 0, cells, parallel.data());
+        EXPECT_EQ(serial, parallel) << threads << " threads";
+    }
+
+    std::vector<double> part(100);
+    ParallelEvaluator(4, 7).evaluate(model, 250, 350, part.data());
+    EXPECT_TRUE(std::equal(part.begin(), part.end(), serial.begin() + 250));
+}
+
+// a model that cannot predict one particular cell
+class FailingCellModel : public DumbModel {
+public:
+    FailingCellModel() : DumbModel(1, 100, 1) {}
+    double get_value_at(const Coordinates &query) override {
+        if (query[0] == 63) throw std::runtime_error("cell 63");
+        return query[0];
+    }
+};
+
+TEST(TestCommandLine, testingParallelRethrows){
+    FailingCellModel model;
+    std::vector<double> out(100);
+    EXPECT_THROW(ParallelEvaluator(4, 2).evaluate(model, 0, 100, out.data()), std::runtime_error);
+    EXPECT_NO_THROW(ParallelEvaluator(4, 2).evaluate(model, 0, 60, out.data()));
+    EXPECT_EQ(59, out[59]);
+}
+
+// queries go out as soon as they are submitted, results are matched to them in write order
+TEST(TestCommandLine, testingCLIOAsync){
+    CommandLineInputOutput::set_IO();
+    auto* oracle = dynamic_cast<AsyncOracle*>(InputOutput::get_instance());
+    ASSERT_NE(oracle, nullptr);
+
+    std::stringstream buffer;
+    std::streambuf* oldCout = std::cout.rdbuf(buffer.rdbuf());
+    std::istringstream input("0.5\n-2\n");
+    std::streambuf* oldCin = std::cin.rdbuf(input.rdbuf());
+
+    oracle->submit(7, {1,2});
+    oracle->submit(3, {4,5});
+    std::string written = buffer.str();
+    auto first = oracle->wait_next();
+    auto second = oracle->wait_next();
+    std::cout.rdbuf(oldCout);
+    std::cin.rdbuf(oldCin);
+
+    EXPECT_EQ(written, "1,2\n4,5\n");
+    EXPECT_EQ(first, std::make_pair(7LL, 0.5));
+    EXPECT_EQ(second, std::make_pair(3LL, -2.0));
+}
+
+// answers the outstanding query with the highest id first, so completions arrive out of order
+class ReversingOracle : public AsyncOracle {
+public:
+    std::map<long long, Coordinates> outstanding;
+    size_t mostOutstanding = 0;
+
+    void submit(long long id, const Coordinates &query) override {
+        outstanding[id] = query;
+        mostOutstanding = std::max(mostOutstanding, outstanding.size());
+    }
+    std::pair<long long, double> wait_next() override {
+        auto last = std::prev(outstanding.end());
+        std::pair<long long, double> done = {last->first, last->second[0] * 10.0 + last->second[1]};
+        outstanding.erase(last);
+        return done;
+    }
+};
+
+// walks the cells in order and records every result it is given
+class RecordingModel : public DumbModel {
+public:
+    std::map<Coordinates, double> seen;
+    int next = 0;
+    RecordingModel() : DumbModel(2, 10, 30) {}
+    Coordinates get_next_query() override {
+        next++;
+        return {next / 10, next % 10};
+    }
+    void update_prediction(const Coordinates &query, double result) override {
+        seen[query] = result;
+    }
+};
+
+TEST(TestCommandLine, testingCoroutineDriver){
+    ReversingOracle oracle;
+    RecordingModel model;
+    CoroutineDriver(oracle, 4).run(model, 30);
+
+    EXPECT_EQ(4, oracle.mostOutstanding);
+    EXPECT_TRUE(oracle.outstanding.empty());
+    EXPECT_EQ(30, model.seen.size());
+    for (const auto& [query, result] : model.seen)
+        EXPECT_EQ(query[0] * 10.0 + query[1], result);
+}
+
+// answers every query with a smooth value and counts how many it was asked
+class CountingIO : public InputOutput {
+public:
+    int asked = 0;
+    double send_query_recieve_result(const Coordinates &query) override {
+        asked++;
+        return std::sin(0.4 * query[0]) + std::cos(0.3 * query[1]);
+    }
+    void output_state(Model &) override {}
+};
+
+// a run cut short resumes from its last checkpoint and only asks the queries after it
+TEST(TestCommandLine, testingCheckpointResume){
+    const std::string path = ::testing::TempDir() + "resume.snap";
+    CountingIO io;
+    InputOutput::set_checkpoint(path, 10);
+
+    TestModel interrupted(2, 16, 50);
+    io.run_queries(interrupted, 25);
+    EXPECT_EQ(25, io.asked);
+
+    TestModel resumed(2, 16, 50);
+    resumed.load_snapshot(path);
+    EXPECT_EQ(20, resumed.answered_queries());
+    io.run_queries(resumed, 50, 4);
+    EXPECT_EQ(25 + 30, io.asked);
+    EXPECT_EQ(50, resumed.answered_queries());
+
+    // finished runs restore trained, without asking anything
+    ReversingOracle oracle;
+    TestModel finished(2, 16, 50);
+    finished.load_snapshot(path);
+    CoroutineDriver(oracle, 4).run(finished, 50);
+    EXPECT_EQ(0, oracle.mostOutstanding);
+    EXPECT_EQ(resumed.get_value_at({3, 7}), finished.get_value_at({3, 7}));
+
+    InputOutput::set_checkpoint("", 0);
+    std::remove(path.c_str());
+}
+
+#if defined(SEP25_ORACLE_PATH) && (defined(__unix__) || defined(__APPLE__))
+// the pool must agree with a single copy of the stand-in oracle, whatever order results arrive in
+TEST(TestCommandLine, testingProcessPool){
+    ProcessPoolInputOutput pool({SEP25_ORACLE_PATH, "--latency-us", "200"}, 3);
+    EXPECT_EQ(3, pool.get_processes());
+
+    std::vector<Coordinates> queries;
+    for (int i = 0; i < 20; i++) queries.push_back({i, 20 - i});
+    std::vector<double> block = pool.send_queries_recieve_results(queries);
+
+    for (size_t i = 0; i < queries.size(); i++)
+        EXPECT_DOUBLE_EQ(block[i], pool.send_query_recieve_result(queries[i]));
+
+    RecordingModel model;
+    CoroutineDriver(pool, 3).run(model, 30);
+    EXPECT_EQ(30, model.seen.size());
+}
+
+TEST(TestCommandLine, testingProcessPoolDeadOracle){
+    ProcessPoolInputOutput pool({"/nonexistent/oracle"}, 2);
+    EXPECT_THROW(pool.send_query_recieve_result({1, 2}), std::runtime_error);
+}
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+static std::string drain(int fd) {
+    std::string text;
+    char chunk[256];
+    ssize_t n;
+    while ((n = ::read(fd, chunk, sizeof(chunk))) > 0) text.append(chunk, n);
+    return text;
+}
+
+// nothing is written until a result has to be waited for, results parse like operator>>
+TEST(TestCommandLine, testingBufferedStreamIO){
+    int results[2], queries[2];
+    ASSERT_EQ(0, ::pipe(results));
+    ASSERT_EQ(0, ::pipe(queries));
+    std::string answers = "0.5\n+2 \r\n-1e3\n\n7";
+    ASSERT_EQ((ssize_t)answers.size(), ::write(results[1], answers.data(), answers.size()));
+    ::close(results[1]);
+
+    {
+        BufferedStreamIO io(results[0], queries[1]);
+        EXPECT_EQ(0.5, io.send_query_recieve_result({1, 2}));
+
+        io.submit(7, {3});
+        io.submit(8, {40, -5});
+        EXPECT_EQ(std::make_pair(7LL, 2.0), io.wait_next());
+        EXPECT_EQ(std::make_pair(8LL, -1000.0), io.wait_next());
+        EXPECT_EQ(std::vector<double>({7.0}), io.send_queries_recieve_results({{0, 0, 0}}));
+        EXPECT_THROW(io.wait_next(), std::logic_error);
+        EXPECT_THROW(io.send_query_recieve_result({9}), std::runtime_error);
+    }
+    ::close(queries[1]);
+    EXPECT_EQ("1,2\n3\n40,-5\n0,0,0\n9\n", drain(queries[0]));
+    ::close(results[0]);
+    ::close(queries[0]);
+}
+
+TEST(TestCommandLine, testingBufferedStreamIOMalformedResult){
+    int results[2], queries[2];
+    ASSERT_EQ(0, ::pipe(results));
+    ASSERT_EQ(0, ::pipe(queries));
+    ASSERT_EQ(4, ::write(results[1], "0.x\n", 4));
+
+    {
+        BufferedStreamIO io(results[0], queries[1]);
+        EXPECT_THROW(io.send_query_recieve_result({1}), std::runtime_error);
+    }
+    for (int fd : {results[0], results[1], queries[0], queries[1]}) ::close(fd);
+}
+
+// the text state space must be byte for byte what CommandLineInputOutput prints
+TEST(TestCommandLine, testingBufferedStreamIOOutputMatchesCLIO){
+    GEKModel model(2, 12, 30);
+    for (int i = 0; i < 30; i++) {
+        Coordinates query = model.get_next_query();
+        model.update_prediction(query, std::sin(query[0] * 0.7) * 1e-3 + query[1] * 123.456);
+    }
+
+    CommandLineInputOutput::set_IO();
+    std::stringstream expected;
+    std::streambuf* oldCout = std::cout.rdbuf(expected.rdbuf());
+    InputOutput::get_instance()->output_state(model);
+    std::cout.rdbuf(oldCout);
+
+    int results[2], output[2];
+    ASSERT_EQ(0, ::pipe(results));
+    ASSERT_EQ(0, ::pipe(output));
+    {
+        BufferedStreamIO io(results[0], output[1]);
+        io.output_state(model);
+    }
+    ::close(output[1]);
+    EXPECT_EQ(expected.str(), drain(output[0]));
+    for (int fd : {results[0], results[1], output[0]}) ::close(fd);
+}
+
+// with an output file the same text goes to the file, and nothing to the oracle
+TEST(TestCommandLine, testingBufferedStreamIOOutputFile){
+    auto path = std::filesystem::temp_directory_path() / "mass_buffered_output_test.txt";
+    GEKModel model(2, 12, 30);
+    for (int i = 0; i < 30; i++) {
+        Coordinates query = model.get_next_query();
+        model.update_prediction(query, std::sin(query[0] * 0.7) * 1e-3 + query[1] * 123.456);
+    }
+
+    CommandLineInputOutput::set_IO();
+    std::stringstream expected;
+    std::streambuf* oldCout = std::cout.rdbuf(expected.rdbuf());
+    InputOutput::get_instance()->output_state(model);
+    std::cout.rdbuf(oldCout);
+
+    int results[2], output[2];
+    ASSERT_EQ(0, ::pipe(results));
+    ASSERT_EQ(0, ::pipe(output));
+    CommandLineInputOutput::set_output_format(CommandLineInputOutput::TEXT, path.string());
+    {
+        BufferedStreamIO io(results[0], output[1]);
+        io.output_state(model);
+    }
+    CommandLineInputOutput::set_output_format(CommandLineInputOutput::TEXT);
+    ::close(output[1]);
+    EXPECT_EQ("", drain(output[0]));
+    for (int fd : {results[0], results[1], output[0]}) ::close(fd);
+
+    std::ifstream file(path, std::ios::binary);
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    std::filesystem::remove(path);
+    EXPECT_EQ(expected.str(), text);
+}
+#endif
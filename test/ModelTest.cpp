@@ -2,6 +2,55 @@
 #include <gtest/gtest.h>
 
 #include "../src/Models/DumbModel.hpp"
+#include "../src/Models/GEKModel.hpp"
+#include "../src/Models/LinearModel.hpp"
+#include "../src/Models/RBF.hpp"
+#include "../src/Models/TestModel.hpp"
+#include "../src/Models/StochasticQueryModel.hpp"
+#include "../src/InputOutput/InputOutput.hpp"
+#include "../src/InputOutput/BinaryStateWriter.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <set>
+
+// drive a model to its final prediction on a smooth function, then check the bulk
+// evaluation agrees with get_value_at on a range that crosses row boundaries
+static void expect_range_matches_cells(Model& model, int totalQueries){
+    for (int i = 0; i < totalQueries; i++){
+        auto query = model.get_next_query();
+        double value = 0;
+        for (int c : query) value += std::sin(0.3 * c);
+        model.update_prediction(query, value > 0 ? 1.0 : 0.0);
+    }
+
+    const long long begin = 7, end = model.cell_count() - 5;
+    std::vector<double> bulk(end - begin);
+    model.evaluate_range(begin, end, bulk.data());
+    for (long long i = begin; i < end; i++){
+        auto coords = InputOutput::index_to_coords(i, model.get_dimensions(), model.get_dimensionSize());
+        EXPECT_EQ(model.get_value_at(coords), bulk[i - begin]) << "cell " << i;
+    }
+}
+
+// distinct cells of a dimensionSize^3 grid drawn by a fixed LCG, each valued
+// sin(a * c0) + cos(b * c1) - slope * c2
+static void draw_smooth_samples(int dimensionSize, int samples, unsigned seed, double a, double b, double slope,
+                                std::vector<Coordinates>& queries, std::vector<double>& results){
+    std::set<Coordinates> seen;
+    unsigned state = seed;
+    auto next = [&]() { state = state * 1103515245u + 12345u; return (int)((state >> 16) % dimensionSize); };
+    while ((int)queries.size() < samples){
+        Coordinates c = {next(), next(), next()};
+        if (!seen.insert(c).second) continue;
+        queries.push_back(c);
+        results.push_back(std::sin(a * c[0]) + std::cos(b * c[1]) - slope * c[2]);
+    }
+}
 
 
 TEST(TestModel, TestsModel1D){
@@ -23,7 +72,7 @@ TEST(TestModel, TestsModelND){
     for (int i = 1; i < 6; i++){
         DumbModel myModel(i, 10, 10);
         
-        std::vector<int> queryPoint(i, 0);
+        Coordinates queryPoint(i, 0);
 
         // test functionality
         EXPECT_EQ(i, myModel.get_next_query().size());
@@ -41,4 +90,374 @@ TEST(TestModel, TestsModelND){
             queryPoint[j] = 9;
         }
     }
-}
\ No newline at end of file
+}
+// a batch is picked before any result is known, the points must still be distinct
+// the linear model fills its state space the same way whatever the cells are stored as
+TEST(TestModel, LinearModelReducedPrecision){
+    LinearModel exact(1, 50, 10);
+    DenseStorage storage;
+    storage.cellType = DenseStorage::F32;
+    LinearModel packed(1, 50, 10, storage);
+    for (int q = 0; q < 10; q++){
+        Coordinates query = {q == 9 ? 49 : q * 5};
+        exact.update_prediction(query, 0.1 * query[0]);
+        packed.update_prediction(query, 0.1 * query[0]);
+    }
+    for (int i = 0; i < 50; i++)
+        EXPECT_NEAR(exact.get_value_at({i}), packed.get_value_at({i}), 1e-5);
+}
+
+// a file-backed linear model predicts the same as one in memory, and leaves its cells in the file
+TEST(TestModel, LinearModelFileBacked){
+    auto path = std::filesystem::temp_directory_path() / "mass_linear_model_test.bin";
+    DenseStorage storage;
+    storage.path = path.string();
+    std::vector<double> expected(50);
+    {
+        LinearModel inMemory(1, 50, 10);
+        LinearModel mapped(1, 50, 10, storage);
+        for (int q = 0; q < 10; q++){
+            Coordinates query = {q == 9 ? 49 : q * 5};
+            inMemory.update_prediction(query, 0.1 * query[0]);
+            mapped.update_prediction(query, 0.1 * query[0]);
+        }
+        for (int i = 0; i < 50; i++){
+            expected[i] = inMemory.get_value_at({i});
+            EXPECT_EQ(expected[i], mapped.get_value_at({i}));
+        }
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    std::filesystem::remove(path);
+    ASSERT_EQ(bytes.size(), BinaryStateWriter::HEADER_SIZE + 50 * sizeof(double));
+    for (int i = 0; i < 50; i++){
+        double value;
+        std::memcpy(&value, bytes.data() + BinaryStateWriter::HEADER_SIZE + i * sizeof(double), sizeof(double));
+        EXPECT_EQ(expected[i], value);
+    }
+
+    storage.cellType = DenseStorage::F32;
+    EXPECT_THROW(LinearModel(1, 50, 10, storage), std::invalid_argument);
+}
+
+TEST(TestModel, BatchedQueriesAreDistinct){
+    GEKModel myModel(2, 20, 64);
+
+    auto first = myModel.get_next_queries(16);
+    EXPECT_EQ(16, first.size());
+    std::set<Coordinates> unique(first.begin(), first.end());
+    EXPECT_EQ(16, unique.size());
+
+    EXPECT_NO_THROW(myModel.update_predictions(first, std::vector<double>(16, 0.5)));
+    EXPECT_EQ(16, myModel.get_next_queries(16).size());
+}
+
+TEST(TestModel, EvaluateRangeMatchesCellsGEK){
+    GEKModel myModel(2, 20, 100); // more points than the local neighbourhood
+    expect_range_matches_cells(myModel, 100);
+}
+
+TEST(TestModel, EvaluateRangeMatchesCellsIDW){
+    TestModel myModel(3, 8, 60);
+    expect_range_matches_cells(myModel, 60);
+}
+
+TEST(TestModel, EvaluateRangeMatchesCellsRBF){
+    RBFModel myModel(2, 20, 50);
+    expect_range_matches_cells(myModel, 50);
+}
+
+TEST(TestModel, EvaluateRangeMatchesCellsStochastic){
+    StochasticQueryModel myModel(2, 64, 400);
+    expect_range_matches_cells(myModel, 400);
+}
+
+// train a model, snapshot it and restore the snapshot into a fresh model of the same shape,
+// which must then reconstruct exactly the same state space
+template <typename M>
+static void expect_snapshot_restores(int dimensions, int dimensionSize, int totalQueries){
+    M trained(dimensions, dimensionSize, totalQueries);
+    for (int i = 0; i < totalQueries; i++){
+        auto query = trained.get_next_query();
+        double value = 0;
+        for (int c : query) value += std::sin(0.3 * c);
+        trained.update_prediction(query, value > 0 ? 1.0 : 0.0);
+    }
+    const std::string path = ::testing::TempDir() + "model.snap";
+    trained.save_snapshot(path);
+
+    M restored(dimensions, dimensionSize, totalQueries);
+    restored.load_snapshot(path);
+    std::remove(path.c_str());
+    EXPECT_EQ(totalQueries, restored.answered_queries());
+
+    std::vector<double> expected(trained.cell_count()), actual(restored.cell_count());
+    trained.evaluate_grid(expected.data());
+    restored.evaluate_grid(actual.data());
+    EXPECT_EQ(expected, actual);
+}
+
+TEST(TestModel, SnapshotRestoresGEK){
+    expect_snapshot_restores<GEKModel>(2, 20, 100);
+    expect_snapshot_restores<GEKModel>(2, 12, 40); // trained globally
+}
+
+TEST(TestModel, SnapshotRestoresIDW){
+    expect_snapshot_restores<TestModel>(3, 8, 60);
+}
+
+TEST(TestModel, SnapshotRestoresRBF){
+    expect_snapshot_restores<RBFModel>(2, 20, 50);
+}
+
+TEST(TestModel, SnapshotRestoresStochastic){
+    expect_snapshot_restores<StochasticQueryModel>(2, 64, 400);
+}
+
+// a checkpoint taken with samples of two points in flight: after the restart the current point
+// finishes first, then the other one gets its outstanding samples back before any new point
+TEST(TestModel, SnapshotResumesStochasticInFlight){
+    // 32 / 4 scaled points per axis, 300 samples each, all inside the point's 8 x 8 block
+    const int dimensionSize = 32, totalQueries = 3200;
+    auto point_of = [](const Coordinates& c) { return (c[0] / 8) * 4 + c[1] / 8; };
+    auto answer = [](const Coordinates& c) { return std::sin(0.3 * c[0]) + std::cos(0.2 * c[1]) > 0 ? 1.0 : 0.0; };
+
+    StochasticQueryModel interrupted(2, dimensionSize, totalQueries);
+    std::vector<Coordinates> asked;
+    for (int i = 0; i < 310; i++) asked.push_back(interrupted.get_next_query());
+    for (int i = 0; i < 298; i++) interrupted.update_prediction(asked[i], answer(asked[i]));
+    const int first = point_of(asked[0]), second = point_of(asked[309]);
+    ASSERT_NE(first, second);
+    ASSERT_EQ(first, point_of(asked[299]));
+
+    const std::string path = ::testing::TempDir() + "stochastic.snap";
+    interrupted.save_snapshot(path);
+    StochasticQueryModel resumed(2, dimensionSize, totalQueries);
+    resumed.load_snapshot(path);
+    std::remove(path.c_str());
+    EXPECT_EQ(298, resumed.answered_queries());
+
+    std::vector<int> points;
+    while (resumed.answered_queries() < totalQueries){
+        Coordinates query = resumed.get_next_query();
+        points.push_back(point_of(query));
+        resumed.update_prediction(query, answer(query));
+    }
+    for (int i = 0; i < 300; i++) EXPECT_EQ(second, points[i]) << "query " << i;
+    for (int i = 300; i < 302; i++) EXPECT_EQ(first, points[i]) << "query " << i;
+    EXPECT_NE(first, points[302]);
+    EXPECT_NE(second, points[302]);
+
+    std::vector<double> grid(resumed.cell_count());
+    resumed.evaluate_grid(grid.data());
+    for (double v : grid) EXPECT_TRUE(std::isfinite(v));
+}
+
+TEST(TestModel, SnapshotRejectsOtherRuns){
+    const std::string path = ::testing::TempDir() + "other.snap";
+    TestModel saved(2, 10, 20);
+    saved.save_snapshot(path);
+
+    TestModel otherBudget(2, 10, 30);
+    EXPECT_THROW(otherBudget.load_snapshot(path), std::invalid_argument);
+    RBFModel otherModel(2, 10, 20);
+    EXPECT_THROW(otherModel.load_snapshot(path), std::runtime_error);
+    DumbModel unsupported(2, 10, 20);
+    EXPECT_THROW(unsupported.save_snapshot(path), std::logic_error);
+    std::remove(path.c_str());
+}
+
+// models without snapshots say so up front, so a run can refuse --checkpoint before any oracle
+// call, and neither writing nor loading one leaves anything behind
+TEST(TestModel, SnapshotSupportIsReported){
+    EXPECT_TRUE(TestModel(2, 10, 20).supports_snapshots());
+    EXPECT_TRUE(RBFModel(2, 10, 20).supports_snapshots());
+    EXPECT_TRUE(GEKModel(2, 10, 20).supports_snapshots());
+    EXPECT_TRUE(StochasticQueryModel(2, 64, 400).supports_snapshots());
+
+    const std::string path = ::testing::TempDir() + "unsupported.snap";
+    LinearModel linear(1, 10, 20);
+    DumbModel dumb(2, 10, 20);
+    for (Model* model : {(Model*)&linear, (Model*)&dumb}){
+        EXPECT_FALSE(model->supports_snapshots());
+        EXPECT_THROW(model->save_snapshot(path), std::logic_error);
+        EXPECT_FALSE(std::filesystem::exists(path + ".partial"));
+        EXPECT_THROW(model->load_snapshot(path), std::logic_error);
+    }
+}
+
+// version 1 RBF snapshots end before the partition-of-unity patches, so they must be refused
+TEST(TestModel, SnapshotRejectsOldVersions){
+    const std::string path = ::testing::TempDir() + "old.snap";
+    {
+        std::ofstream file(path, std::ios::binary);
+        SnapshotWriter out(file);
+        out.tag("MASSSNAP");
+        out.integer(1);
+        out.integer(2);
+        out.integer(10);
+        out.integer(20);
+        out.integer(0);
+        out.tag("RBFModel");
+        out.integer(0);
+        out.reals({});
+    }
+    RBFModel model(2, 10, 20);
+    try {
+        model.load_snapshot(path);
+        ADD_FAILURE() << "a version 1 snapshot was loaded";
+    } catch (const std::runtime_error &e) {
+        EXPECT_NE(std::string::npos, std::string(e.what()).find("Unsupported snapshot version"));
+    }
+    std::remove(path.c_str());
+}
+
+TEST(TestModel, ApproximateKNNWithinEpsilon){
+    const int dims = 6, K = 8;
+    std::vector<std::pair<double, Coordinates>> data;
+    unsigned state = 12345;
+    auto next = [&]() { state = state * 1103515245u + 12345u; return (int)((state >> 16) % 16); };
+    for (int i = 0; i < 2000; i++){
+        Coordinates p(dims);
+        for (int d = 0; d < dims; d++) p[d] = next();
+        data.emplace_back(i, p);
+    }
+    KNNTree tree(data);
+
+    std::vector<KNNTree::Neighbour> exact, approx;
+    for (int q = 0; q < 100; q++){
+        Coordinates target(dims);
+        for (int d = 0; d < dims; d++) target[d] = next();
+        tree.setApproximation({});
+        tree.getKNearest(target, K, exact);
+        tree.setApproximation({0.5, 0});
+        tree.getKNearest(target, K, approx);
+        ASSERT_EQ(exact.size(), approx.size());
+        for (size_t j = 0; j < exact.size(); j++)
+            EXPECT_LE(approx[j].distance, exact[j].distance * 1.5 + 1e-12);
+
+        // a budget of one point still returns the first descent
+        tree.setApproximation({0.0, 1});
+        tree.getKNearest(target, K, approx);
+        EXPECT_FALSE(approx.empty());
+    }
+    EXPECT_THROW(tree.setApproximation({0.0, -1}), std::invalid_argument);
+}
+
+// the bulk IDW walk must agree with per-cell predictions whether the search is exact or not
+TEST(TestModel, IDWRangeMatchesCellsWhenApproximate){
+    const int dims = 3, dimensionSize = 16;
+    std::vector<std::pair<double, Coordinates>> data;
+    unsigned state = 777;
+    auto next = [&]() { state = state * 1103515245u + 12345u; return (int)((state >> 16) % dimensionSize); };
+    for (int i = 0; i < 300; i++){
+        Coordinates p = {next(), next(), next()};
+        data.emplace_back(std::sin(0.4 * p[0]) + 0.1 * p[1] * p[2], p);
+    }
+    IDW idw(data, 8, 2);
+
+    const long long begin = 5, end = 4000;
+    std::vector<double> bulk(end - begin);
+    for (KNNTree::Approximation approximation : {KNNTree::Approximation{}, KNNTree::Approximation{0.5, 0},
+                                                 KNNTree::Approximation{0.0, 20}}){
+        idw.set_approximation(approximation);
+        idw.predict_range(begin, end, dims, dimensionSize, bulk.data());
+        for (long long i = begin; i < end; i++)
+            EXPECT_EQ(idw.predict(InputOutput::index_to_coords(i, dims, dimensionSize)), bulk[i - begin])
+                << "cell " << i << " epsilon " << approximation.epsilon << " maxChecks " << approximation.maxChecks;
+    }
+}
+
+// the samples / cells ratio picks the kernel: IMQ and Gaussian train through Cholesky, MQ through LU,
+// and either way the trained model reproduces its samples
+TEST(TestModel, RBFInterpolatesSamplesForEveryKernel){
+    for (int dimensionSize : {20, 8, 6}){
+        const int samples = 60;
+        RBFModel model(3, dimensionSize, samples);
+        std::vector<Coordinates> queries;
+        std::vector<double> results;
+        draw_smooth_samples(dimensionSize, samples, dimensionSize, 0.5, 0.3, 0.1, queries, results);
+        model.update_predictions(queries, results);
+        for (int i = 0; i < samples; i++)
+            EXPECT_NEAR(results[i], model.get_value_at(queries[i]), 1e-4) << "grid " << dimensionSize << " sample " << i;
+    }
+}
+
+TEST(TestModel, RBFWendlandInterpolatesLargeSampleSets){
+    const int dimensionSize = 50, samples = RBFModel::DENSE_MAX_SAMPLES + 2000;
+    RBFModel model(3, dimensionSize, samples);
+    std::vector<Coordinates> queries;
+    std::vector<double> results;
+    draw_smooth_samples(dimensionSize, samples, 7, 0.2, 0.1, 0.02, queries, results);
+    model.update_predictions(queries, results);
+    for (int i = 0; i < samples; i += 7)
+        EXPECT_NEAR(results[i], model.get_value_at(queries[i]), 1e-4) << "sample " << i;
+
+    const long long begin = 1000, end = 6000;
+    std::vector<double> bulk(end - begin);
+    model.evaluate_range(begin, end, bulk.data());
+    for (long long i = begin; i < end; i++)
+        EXPECT_EQ(bulk[i - begin], model.get_value_at(InputOutput::index_to_coords(i, 3, dimensionSize)));
+}
+
+TEST(TestModel, RBFPartitionOfUnityInterpolatesSamples){
+    const int dimensionSize = 40, samples = 3000;
+    RBFModel model(3, dimensionSize, samples);
+    model.set_partition_of_unity(true, 2);
+    std::vector<Coordinates> queries;
+    std::vector<double> results;
+    draw_smooth_samples(dimensionSize, samples, 11, 0.2, 0.1, 0.02, queries, results);
+    model.update_predictions(queries, results);
+    for (int i = 0; i < samples; i += 3)
+        EXPECT_NEAR(results[i], model.get_value_at(queries[i]), 1e-4) << "sample " << i;
+
+    const long long begin = 500, end = 4500;
+    std::vector<double> bulk(end - begin);
+    model.evaluate_range(begin, end, bulk.data());
+    for (long long i = begin; i < end; i++)
+        EXPECT_EQ(bulk[i - begin], model.get_value_at(InputOutput::index_to_coords(i, 3, dimensionSize)));
+}
+
+TEST(TestModel, RBFGridEvaluationWithinTolerance){
+    for (int dimensionSize : {30, 12}){
+        RBFModel model(3, dimensionSize, 80);
+        for (int i = 0; i < 80; i++){
+            auto query = model.get_next_query();
+            model.update_prediction(query, std::sin(0.3 * query[0]) + 0.1 * query[1] * query[2]);
+        }
+        const long long cells = model.cell_count();
+        std::vector<double> bulk(cells);
+        model.set_evaluation_tolerance(1e-6);
+        model.evaluate_range(0, cells, bulk.data());
+        for (long long i = 0; i < cells; i++)
+            EXPECT_NEAR(bulk[i], model.get_value_at(InputOutput::index_to_coords(i, 3, dimensionSize)), 1e-6) << "cell " << i;
+    }
+    EXPECT_THROW(RBFModel(2, 8, 4).set_evaluation_tolerance(-1.0), std::invalid_argument);
+}
+
+TEST(TestModel, RBFFarthestPointQueriesSpreadInAnyDimension){
+    for (int dimensions : {4, 5, 7}){
+        // 40 samples stay well under a quarter of the cells, so every query is a farthest point
+        const int dimensionSize = 6, queries = 40;
+        RBFModel model(dimensions, dimensionSize, 100);
+        std::vector<Coordinates> asked;
+        double previous = std::numeric_limits<double>::infinity();
+        for (int i = 0; i < queries; i++){
+            Coordinates query = model.get_next_query();
+            double closest = std::numeric_limits<double>::infinity();
+            for (const Coordinates& c : asked){
+                double squared = 0;
+                for (int d = 0; d < dimensions; d++) squared += (query[d] - c[d]) * (query[d] - c[d]);
+                closest = std::min(closest, squared);
+            }
+            // each query is a farthest point, so it is new and no farther out than the last one
+            EXPECT_GT(closest, 0.0) << dimensions << "D query " << i;
+            EXPECT_LE(closest, previous) << dimensions << "D query " << i;
+            previous = closest;
+            asked.push_back(query);
+            model.update_prediction(query, 1.0);
+        }
+    }
+}
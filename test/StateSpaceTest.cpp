@@ -2,7 +2,20 @@
 #include <gtest/gtest.h>
 
 #include "../src/StateSpace/ArrayStateSpace.hpp"
+#include "../src/StateSpace/ArrayStateSpaceN.hpp"
 #include "../src/StateSpace/KDTreeStateSpace.hpp"
+#include "../src/StateSpace/FlatKDTreeStateSpace.hpp"
+#include "../src/StateSpace/MortonStateSpace.hpp"
+#include "../src/StateSpace/CellSlotMap.hpp"
+#include "../src/StateSpace/PackedArrayStateSpace.hpp"
+#include "../src/Models/Tools/GridOdometer.hpp"
+#include "../src/InputOutput/BinaryStateWriter.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
 
 TEST(TestStateSpace, TestsGetAndSetIn1D){
     ArrayStateSpace mySpace(1, 5);
@@ -17,7 +30,7 @@ TEST(TestStateSpace, TestsGetAndSetInND){
         EXPECT_EQ(i, mySpace.get_dimensions());
         EXPECT_EQ(10, mySpace.get_dimension_size());
 
-        std::vector<int> point(i, i);
+        Coordinates point(i, i);
     
         EXPECT_EQ(0.0, mySpace.get(point));
         EXPECT_NO_THROW(mySpace.set(point, 23));
@@ -44,6 +57,261 @@ TEST(TestStateSpace, TestsErrorThrowing){
 
 }
 
+TEST(TestStateSpace, TestsCellCountBeyond32Bits){
+    EXPECT_EQ(100000000000000000LL, StateSpace::cell_count(17, 10));
+    EXPECT_EQ(1LL << 40, StateSpace::cell_count(40, 2));
+
+    EXPECT_THROW(StateSpace::cell_count(19, 10), std::overflow_error);
+    EXPECT_THROW(StateSpace::cell_count(10, 1000), std::overflow_error);
+    EXPECT_THROW(ArrayStateSpace(64, 2), std::overflow_error);
+
+    // a 2^36 cell KD tree never allocates the grid, so its indices must not wrap
+    KDTreeStateSpace tree(4, 512);
+    tree.insert({511, 511, 511, 511}, 7.0);
+    EXPECT_EQ(7.0, tree.get({511, 511, 511, 511}));
+}
+
+// the fixed dimension space must lay cells out exactly like the generic one
+TEST(TestStateSpace, TestsFixedDimensionMatchesGeneric){
+    ArrayStateSpace generic(3, 7);
+    ArrayStateSpaceN<3> fixed(7);
+    for (int i = 0; i < 7 * 7 * 7; i++){
+        Coordinates coords = {i / 49, (i / 7) % 7, i % 7};
+        generic.set(coords, i * 0.5);
+        if (i % 2) fixed.set(coords, i * 0.5);
+        else fixed[{coords[0], coords[1], coords[2]}] = i * 0.5;
+    }
+    EXPECT_TRUE(std::equal(generic.raw_view().begin(), generic.raw_view().end(), fixed.raw_view().begin()));
+    EXPECT_EQ(generic.get({6, 0, 3}), fixed.at({6, 0, 3}));
+    EXPECT_EQ(6 * 49 + 3, fixed.index({6, 0, 3}));
+
+    EXPECT_THROW(fixed.at({7, 0, 0}), std::out_of_range);
+    EXPECT_THROW(fixed.get({0, -1, 0}), std::out_of_range);
+    EXPECT_THROW(fixed.get({0, 0}), std::invalid_argument);
+
+    // the view is the storage itself
+    fixed.raw_view()[5] = -1.0;
+    EXPECT_EQ(-1.0, fixed.get({0, 0, 5}));
+}
+
+TEST(TestStateSpace, TestsDispatchByDimension){
+    for (int d = 1; d <= 10; d++){
+        std::unique_ptr<ArrayStateSpace> space = make_array_state_space(d, 3, 2.0);
+        EXPECT_EQ(d, space->get_dimensions());
+        EXPECT_EQ(StateSpace::cell_count(d, 3), (long long)space->raw_view().size());
+
+        Coordinates last(d, 2);
+        EXPECT_EQ(2.0, space->get(last));
+        space->set(last, 9.0);
+        EXPECT_EQ(9.0, space->raw_view().back());
+    }
+    EXPECT_NE(nullptr, dynamic_cast<ArrayStateSpaceN<8>*>(make_array_state_space(8, 2).get()));
+    EXPECT_EQ(nullptr, dynamic_cast<ArrayStateSpaceN<8>*>(make_array_state_space(9, 2).get()));
+}
+
+TEST(TestStateSpace, TestsDenseStorageCellTypes){
+    DenseStorage storage;
+    EXPECT_NE(nullptr, dynamic_cast<ArrayStateSpaceN<3>*>(make_dense_state_space(3, 4, storage).get()));
+    storage.cellType = DenseStorage::F32;
+    EXPECT_NE(nullptr, dynamic_cast<PackedArrayStateSpace<float>*>(make_dense_state_space(3, 4, storage).get()));
+    storage.cellType = DenseStorage::BF16;
+    EXPECT_NE(nullptr, dynamic_cast<PackedArrayStateSpace<BFloat16>*>(make_dense_state_space(3, 4, storage).get()));
+    storage.cellType = DenseStorage::F16;
+    EXPECT_NE(nullptr, dynamic_cast<PackedArrayStateSpace<Half>*>(make_dense_state_space(3, 4, storage).get()));
+    storage.cellType = DenseStorage::U16;
+    EXPECT_NE(nullptr, dynamic_cast<PackedArrayStateSpace<UNorm16>*>(make_dense_state_space(3, 4, storage).get()));
+
+    // every cell type goes through the same interface, rounding what it stores
+    for (auto type : {DenseStorage::F64, DenseStorage::F32, DenseStorage::BF16, DenseStorage::F16, DenseStorage::U16}){
+        storage.cellType = type;
+        std::unique_ptr<DenseStateSpace> space = make_dense_state_space(3, 4, storage, 0.5);
+        EXPECT_NEAR(0.5, space->get({3, 3, 3}), 1e-4);
+        double stored = space->set({1, 2, 3}, 0.3);
+        EXPECT_NEAR(0.3, stored, 2e-3);
+        EXPECT_EQ(stored, space->get({1, 2, 3}));
+        EXPECT_EQ(stored, space->get_raw_representation()[1 * 16 + 2 * 4 + 3]);
+    }
+}
+
+// the mapped file is the f64 binary output of the state space, header included
+TEST(TestStateSpace, TestsFileBackedArray){
+    auto path = std::filesystem::temp_directory_path() / "mass_file_backed_test.bin";
+    {
+        std::unique_ptr<ArrayStateSpace> space = make_array_state_space(3, 5, path.string(), ArrayStateSpace::RANDOM, 1.5);
+        ASSERT_TRUE(space->is_file_backed());
+        EXPECT_EQ(1.5, space->get({4, 4, 4}));
+        space->set({1, 2, 3}, -7.25);
+        EXPECT_EQ(-7.25, space->get({1, 2, 3}));
+        EXPECT_THROW(space->get({5, 0, 0}), std::out_of_range);
+
+        // copies live in memory and no longer share cells with the file
+        ArrayStateSpace copy = *space;
+        EXPECT_FALSE(copy.is_file_backed());
+        copy.set({0, 0, 0}, 9.0);
+        EXPECT_EQ(1.5, space->get({0, 0, 0}));
+
+        space->advise(ArrayStateSpace::SEQUENTIAL);
+        space->flush();
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    std::filesystem::remove(path);
+
+    ASSERT_EQ(bytes.size(), BinaryStateWriter::HEADER_SIZE + 125 * sizeof(double));
+    unsigned char header[BinaryStateWriter::HEADER_SIZE];
+    BinaryStateWriter::encode_header(header, 3, 5, BinaryStateWriter::FLOAT64);
+    EXPECT_EQ(0, std::memcmp(header, bytes.data(), sizeof(header)));
+    for (int i = 0; i < 125; i++) {
+        double value;
+        std::memcpy(&value, bytes.data() + BinaryStateWriter::HEADER_SIZE + i * sizeof(double), sizeof(double));
+        EXPECT_EQ(i == 1 * 25 + 2 * 5 + 3 ? -7.25 : 1.5, value);
+    }
+
+    // moving keeps the mapping
+    auto movedPath = std::filesystem::temp_directory_path() / "mass_file_backed_move.bin";
+    ArrayStateSpace original(2, 4, movedPath.string());
+    original.set({3, 3}, 2.0);
+    ArrayStateSpace moved = std::move(original);
+    EXPECT_TRUE(moved.is_file_backed());
+    EXPECT_EQ(2.0, moved.get({3, 3}));
+    EXPECT_EQ(0.0, moved.get({0, 0}));
+    std::filesystem::remove(movedPath);
+
+    EXPECT_THROW(ArrayStateSpace(2, 4, (std::filesystem::temp_directory_path() / "missing_dir" / "x.bin").string()),
+                 std::runtime_error);
+}
+
+TEST(TestStateSpace, TestsMortonLayoutMatchesRowMajor){
+    for (auto [dims, size] : {std::pair{1, 5000}, {2, 70}, {3, 20}, {4, 9}, {5, 3}}){
+        ArrayStateSpace rowMajor(dims, size);
+        MortonStateSpace morton(dims, size);
+        EXPECT_EQ(0, morton.raw_view().size() % (std::size_t)std::pow(morton.tile_side(), dims));
+
+        std::vector<char> used(morton.raw_view().size(), 0);
+        GridOdometer cell(dims, size, 0);
+        for (long long i = 0; i < StateSpace::cell_count(dims, size); i++, cell.next()){
+            long long stored = morton.index(cell.coords());
+            ASSERT_LT(stored, (long long)used.size());
+            EXPECT_EQ(0, used[stored]++);
+            EXPECT_EQ(cell.coords(), morton.coords_of(stored));
+
+            rowMajor.set(cell.coords(), i * 0.5);
+            morton.set(cell.coords(), i * 0.5);
+        }
+        EXPECT_EQ(rowMajor.get_raw_representation(), morton.get_raw_representation());
+        EXPECT_EQ(rowMajor.get(Coordinates(dims, size - 1)), morton.get(Coordinates(dims, size - 1)));
+    }
+
+    MortonStateSpace morton(3, 10);
+    EXPECT_THROW(morton.get({1, 2}), std::invalid_argument);
+    EXPECT_THROW(morton.set({1, 10, 2}, 1.0), std::out_of_range);
+    EXPECT_THROW(morton.get({-1, 0, 0}), std::out_of_range);
+}
+
+TEST(TestStateSpace, TestsCellSlotMap){
+    CellSlotMap slots(3, 40);
+    EXPECT_EQ(CellSlotMap::NONE, slots.find({1, 2, 3}));
+
+    // enough cells to rehash several times
+    int slot = 0;
+    for (int x = 0; x < 40; x += 3)
+        for (int y = 0; y < 40; y += 2)
+            for (int z = 0; z < 40; z += 5){
+                EXPECT_EQ(slot, slots.emplace({x, y, z}, slot));
+                slot++;
+            }
+    EXPECT_EQ((std::size_t)slot, slots.size());
+
+    // the first slot stored for a cell is kept
+    EXPECT_EQ(0, slots.emplace({0, 0, 0}, 99));
+    EXPECT_EQ(1, slots.find({0, 0, 5}));
+    EXPECT_EQ(StateSpace::cell_count(3, 40) - 1, slots.cell_index({39, 39, 39}));
+    EXPECT_TRUE(slots.contains({39, 38, 35}));
+    EXPECT_FALSE(slots.contains({1, 0, 0}));
+
+    // outside the grid or of the wrong dimension is never found nor stored
+    EXPECT_EQ(-1, slots.cell_index({40, 0, 0}));
+    EXPECT_EQ(CellSlotMap::NONE, slots.find({0, 0}));
+    EXPECT_EQ(CellSlotMap::NONE, slots.emplace({-1, 0, 0}, 5));
+    EXPECT_EQ((std::size_t)slot, slots.size());
+}
+
+// bulk conversion must agree with the scalar codec, and both stay within the type's rounding error
+template <typename Cell>
+static void expect_packed_cells(double tolerance){
+    PackedArrayStateSpace<Cell> space(2, 37, 0.5);
+    EXPECT_NEAR(0.5, space.get({36, 0}), tolerance);
+    EXPECT_EQ(37u * 37u * sizeof(Cell), space.raw_view().size_bytes());
+
+    std::vector<double> values(37 * 37);
+    for (size_t i = 0; i < values.size(); i++) values[i] = std::fmod(i * 0.618034, 1.0);
+    space.write(0, values);
+    std::vector<double> bulk = space.get_raw_representation();
+    for (size_t i = 0; i < values.size(); i++){
+        EXPECT_NEAR(values[i], bulk[i], tolerance * std::max(1.0, std::abs(values[i])));
+        EXPECT_EQ(CellCodec<Cell>::decode(CellCodec<Cell>::encode(values[i])), bulk[i]);
+    }
+
+    double stored = space.set({3, 4}, 0.3);
+    EXPECT_EQ(stored, space.get({3, 4}));
+    std::vector<double> row(37);
+    space.read(3 * 37, row);
+    EXPECT_EQ(stored, row[4]);
+
+    EXPECT_THROW(space.get({37, 0}), std::out_of_range);
+    EXPECT_THROW(space.get({1}), std::invalid_argument);
+    std::vector<double> tooMany(values.size() + 1);
+    EXPECT_THROW(space.read(0, tooMany), std::out_of_range);
+    EXPECT_THROW(space.write(0, tooMany), std::out_of_range);
+}
+
+TEST(TestStateSpace, TestsPackedCellTypes){
+    expect_packed_cells<double>(0.0);
+    expect_packed_cells<float>(1e-7);
+    expect_packed_cells<BFloat16>(1.0 / 256);
+    expect_packed_cells<Half>(1.0 / 2048);
+    expect_packed_cells<UNorm16>(0.5 / 65535);
+
+    // edges of the 16-bit formats
+    EXPECT_EQ(65504.0, CellCodec<Half>::decode(CellCodec<Half>::encode(65504.0)));
+    EXPECT_TRUE(std::isinf(CellCodec<Half>::decode(CellCodec<Half>::encode(70000.0))));
+    EXPECT_EQ(std::ldexp(1.0, -24), CellCodec<Half>::decode(CellCodec<Half>::encode(std::ldexp(1.0, -24))));
+    EXPECT_EQ(-0.25, CellCodec<Half>::decode(CellCodec<Half>::encode(-0.25)));
+    EXPECT_TRUE(std::isnan(CellCodec<Half>::decode(CellCodec<Half>::encode(std::nan("")))));
+    EXPECT_TRUE(std::isnan(CellCodec<BFloat16>::decode(CellCodec<BFloat16>::encode(std::nan("")))));
+    EXPECT_EQ(1.0, CellCodec<BFloat16>::decode(CellCodec<BFloat16>::encode(1.0)));
+    EXPECT_EQ(0.0, CellCodec<UNorm16>::decode(CellCodec<UNorm16>::encode(-3.0)));
+    EXPECT_EQ(1.0, CellCodec<UNorm16>::decode(CellCodec<UNorm16>::encode(3.0)));
+}
+
+// copies, moves and comparisons behave the same inline and once spilled to the heap
+TEST(TestStateSpace, TestsCoordinatesInlineAndSpilled){
+    for (int d : {3, 8, 9, 20}){
+        Coordinates coords;
+        for (int i = 0; i < d; i++) coords.push_back(i * 7);
+        EXPECT_EQ((std::size_t)d, coords.size());
+        EXPECT_EQ(d > (int)Coordinates::INLINE_CAPACITY, coords.capacity() > Coordinates::INLINE_CAPACITY);
+
+        Coordinates copy = coords;
+        EXPECT_EQ(coords, copy);
+        copy.back()++;
+        EXPECT_LT(coords, copy);
+
+        Coordinates moved = std::move(copy);
+        EXPECT_TRUE(copy.empty());
+        EXPECT_EQ((d - 1) * 7 + 1, moved.back());
+
+        copy = moved;
+        moved = coords;
+        EXPECT_EQ(coords, moved);
+        EXPECT_NE(coords, copy);
+        EXPECT_EQ(coords.to_vector(), std::vector<int>(coords.begin(), coords.end()));
+        EXPECT_EQ(coords, Coordinates(coords.to_vector()));
+    }
+}
+
 // KDTreeStateSpace tests
 
 // ---------- Basic insert / get tests ----------
@@ -71,7 +339,7 @@ TEST(TestKDTreeStateSpace, TestInsertAndGetInND) {
         EXPECT_EQ(dim, tree.get_dimensions());
         EXPECT_EQ(10, tree.get_dimension_size());
 
-        std::vector<int> coords(dim, 4);
+        Coordinates coords(dim, 4);
 
         EXPECT_DOUBLE_EQ(0.0, tree.get(coords));
 
@@ -106,6 +374,11 @@ TEST(TestKDTreeStateSpace, TestOutOfRangeReturnsDefault) {
     tree.insert({1, 1}, 42.0);
     EXPECT_DOUBLE_EQ(42.0, tree.get({1, 1}));
     EXPECT_DOUBLE_EQ(0.0, tree.get({0, 0}));
+
+    // points outside the grid are still found, through the tree
+    tree.insert({7, 1}, 3.0);
+    EXPECT_DOUBLE_EQ(3.0, tree.get({7, 1}));
+    EXPECT_DOUBLE_EQ(0.0, tree.get({7, 2}));
 }
 
 
@@ -119,7 +392,7 @@ TEST(TestKDTreeStateSpace, TestNearestNeighborExactMatch) {
 
     auto* nn = tree.nearest_neighbor({5, 5});
     ASSERT_NE(nullptr, nn);
-    EXPECT_EQ(nn->coords, std::vector<int>({5, 5}));
+    EXPECT_EQ(nn->coords, Coordinates({5, 5}));
     EXPECT_DOUBLE_EQ(nn->value, 3.5);
 }
 
@@ -133,10 +406,219 @@ TEST(TestKDTreeStateSpace, TestNearestNeighborClosestPoint) {
     // Query point closer to (2,2)
     auto* nn = tree.nearest_neighbor({3, 3});
     ASSERT_NE(nullptr, nn);
-    EXPECT_EQ(nn->coords, std::vector<int>({2, 2}));
+    EXPECT_EQ(nn->coords, Coordinates({2, 2}));
     EXPECT_DOUBLE_EQ(nn->value, 2.0);
 }
 
+// k-NN, radius and nearest queries agree with a brute force scan once buckets have split
+// along axes other than depth % dimensions
+TEST(TestKDTreeStateSpace, TestNeighborQueriesMatchBruteForce) {
+    for (int dims : {1, 2, 3, 4}) {
+        KDTreeStateSpace tree(dims, 16);
+        std::mt19937 rng(7 * dims);
+        std::uniform_int_distribution<int> coord(0, 15);
+
+        std::vector<Coordinates> points;
+        for (int i = 0; i < 300; i++) {
+            Coordinates p(dims);
+            for (int d = 0; d < dims; d++) p[d] = coord(rng);
+            if (std::find(points.begin(), points.end(), p) == points.end()) points.push_back(p);
+            tree.insert(p, i);
+        }
+
+        std::vector<KDTreeStateSpace::Neighbor> found;
+        for (int q = 0; q < 100; q++) {
+            Coordinates target(dims);
+            for (int d = 0; d < dims; d++) target[d] = coord(rng);
+            std::vector<double> dists;
+            for (const Coordinates& p : points) dists.push_back(tree.squared_distance(p, target));
+            std::sort(dists.begin(), dists.end());
+
+            EXPECT_DOUBLE_EQ(dists[0], tree.squared_distance(tree.nearest_neighbor(target)->coords, target));
+
+            for (size_t k : {1, 5, 20}) {
+                tree.nearest_k_neighbors(target, (int)k, found);
+                ASSERT_EQ(std::min(k, points.size()), found.size());
+                for (size_t i = 0; i < found.size(); i++) {
+                    EXPECT_DOUBLE_EQ(dists[i], found[i].squaredDistance);
+                    EXPECT_DOUBLE_EQ(found[i].squaredDistance, tree.squared_distance(found[i].node->coords, target));
+                }
+            }
+
+            tree.radius_neighbors(target, 3.0, found);
+            size_t within = std::upper_bound(dists.begin(), dists.end(), 9.0) - dists.begin();
+            ASSERT_EQ(within, found.size());
+            for (size_t i = 0; i < within; i++) EXPECT_DOUBLE_EQ(dists[i], found[i].squaredDistance);
+        }
+
+        // asking for more neighbours than there are samples returns them all
+        tree.nearest_k_neighbors(Coordinates(dims, 0), 1000, found);
+        EXPECT_EQ(points.size(), found.size());
+    }
+
+    KDTreeStateSpace empty(2, 4);
+    std::vector<KDTreeStateSpace::Neighbor> found = {{nullptr, 1.0}};
+    empty.nearest_k_neighbors({1, 1}, 3, found);
+    EXPECT_TRUE(found.empty());
+    EXPECT_THROW(empty.radius_neighbors({1}, 1.0, found), std::invalid_argument);
+}
+
+TEST(TestKDTreeStateSpace, TestApproximateNearestWithinEpsilon) {
+    const int dims = 6;
+    KDTreeStateSpace tree(dims, 16);
+    std::mt19937 rng(17);
+    std::uniform_int_distribution<int> coord(0, 15);
+    for (int i = 0; i < 3000; i++) {
+        Coordinates p(dims);
+        for (int d = 0; d < dims; d++) p[d] = coord(rng);
+        tree.insert(p, i);
+    }
+
+    std::vector<Coordinates> targets;
+    for (int q = 0; q < 200; q++) {
+        Coordinates p(dims);
+        for (int d = 0; d < dims; d++) p[d] = coord(rng);
+        targets.push_back(p);
+    }
+    std::vector<double> exact;
+    std::vector<std::vector<KDTreeStateSpace::Neighbor>> exactK(targets.size());
+    for (size_t i = 0; i < targets.size(); i++) {
+        exact.push_back(tree.squared_distance(tree.nearest_neighbor(targets[i])->coords, targets[i]));
+        tree.nearest_k_neighbors(targets[i], 8, exactK[i]);
+    }
+
+    const double epsilon = 1.0;
+    tree.set_approximation({epsilon, 0});
+    std::vector<KDTreeStateSpace::Neighbor> found;
+    tree.nearest_neighbors(targets, found);
+    for (size_t i = 0; i < targets.size(); i++) {
+        double approx = tree.squared_distance(tree.nearest_neighbor(targets[i])->coords, targets[i]);
+        EXPECT_LE(approx, exact[i] * (1 + epsilon) * (1 + epsilon));
+        EXPECT_LE(found[i].squaredDistance, exact[i] * (1 + epsilon) * (1 + epsilon));
+
+        std::vector<KDTreeStateSpace::Neighbor> approxK;
+        tree.nearest_k_neighbors(targets[i], 8, approxK);
+        ASSERT_EQ(8u, approxK.size());
+        for (size_t j = 0; j < approxK.size(); j++)
+            EXPECT_LE(approxK[j].squaredDistance, exactK[i][j].squaredDistance * (1 + epsilon) * (1 + epsilon));
+    }
+
+    // a budget of one still finishes the first descent
+    tree.set_approximation({0.0, 1});
+    for (const Coordinates& target : targets) EXPECT_NE(nullptr, tree.nearest_neighbor(target));
+    tree.nearest_k_neighbors(targets[0], 8, found);
+    EXPECT_FALSE(found.empty());
+
+    tree.set_approximation({});
+    for (size_t i = 0; i < targets.size(); i++)
+        EXPECT_DOUBLE_EQ(exact[i], tree.squared_distance(tree.nearest_neighbor(targets[i])->coords, targets[i]));
+    EXPECT_THROW(tree.set_approximation({-0.5, 0}), std::invalid_argument);
+}
+
+TEST(TestKDTreeStateSpace, TestBatchedNearestMatchesSingle) {
+    for (int dims : {1, 2, 3}) {
+        KDTreeStateSpace tree(dims, 32);
+        std::mt19937 rng(3 * dims);
+        std::uniform_int_distribution<int> coord(0, 31);
+        for (int i = 0; i < 500; i++) {
+            Coordinates p(dims);
+            for (int d = 0; d < dims; d++) p[d] = coord(rng);
+            tree.insert(p, i);
+        }
+
+        // a lattice, then scattered targets with repeats
+        std::vector<Coordinates> targets;
+        for (int i = 0; i < 32; i += 3) {
+            Coordinates p(dims, i);
+            if (dims > 1) p[1] = 31 - i;
+            targets.push_back(p);
+        }
+        for (int q = 0; q < 400; q++) {
+            Coordinates p(dims);
+            for (int d = 0; d < dims; d++) p[d] = coord(rng);
+            targets.push_back(p);
+        }
+        targets.push_back(targets.back());
+
+        std::vector<KDTreeStateSpace::Neighbor> found;
+        tree.nearest_neighbors(targets, found);
+        ASSERT_EQ(targets.size(), found.size());
+        for (size_t i = 0; i < targets.size(); i++) {
+            double expected = tree.squared_distance(tree.nearest_neighbor(targets[i])->coords, targets[i]);
+            EXPECT_DOUBLE_EQ(expected, found[i].squaredDistance);
+            EXPECT_DOUBLE_EQ(expected, tree.squared_distance(found[i].node->coords, targets[i]));
+        }
+    }
+
+    KDTreeStateSpace empty(2, 4);
+    std::vector<KDTreeStateSpace::Neighbor> found;
+    empty.nearest_neighbors({{1, 1}, {2, 2}}, found);
+    ASSERT_EQ(2u, found.size());
+    EXPECT_EQ(nullptr, found[0].node);
+    EXPECT_THROW(empty.nearest_neighbors({{1, 1}, {1}}, found), std::invalid_argument);
+}
+
+// samples arriving in a sweep, as dense_uniform_query produces them, keep the tree shallow
+TEST(TestKDTreeStateSpace, TestSweepInsertsStayBalanced) {
+    KDTreeStateSpace tree(2, 64);
+    for (int i = 0; i < 64; i++)
+        for (int j = 0; j < 64; j++) tree.insert({i, j}, i * 64 + j);
+    tree.insert({5, 6}, -1.0); // an update, not a new sample
+
+    EXPECT_EQ(4096, tree.size());
+    EXPECT_LE(tree.depth(), 2 * (int)std::log2(4096.0));
+    EXPECT_DOUBLE_EQ(-1.0, tree.get({5, 6}));
+    EXPECT_DOUBLE_EQ(63 * 64 + 2, tree.get({63, 2}));
+    auto* nn = tree.nearest_neighbor({70, -3});
+    ASSERT_NE(nullptr, nn);
+    EXPECT_EQ(Coordinates({63, 0}), nn->coords);
+
+    int bucketed = 0;
+    for (auto* leaf : tree.get_leaves()) bucketed += leaf->isBucket ? (int)leaf->bucket.size() : 1;
+    EXPECT_LE(bucketed, 4096);
+}
+
+TEST(TestKDTreeStateSpace, TestBulkLoad) {
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> coord(0, 31);
+    std::vector<Coordinates> coords;
+    std::vector<double> values;
+    for (int i = 0; i < 2000; i++) {
+        coords.push_back({coord(rng), coord(rng), coord(rng)});
+        values.push_back(i);
+    }
+    coords.push_back({40, 1, 1}); // off the grid
+    values.push_back(-2.0);
+    coords.push_back(coords[7]); // repeated cell, the last value wins
+    values.push_back(-7.0);
+
+    KDTreeStateSpace bulk(3, 32, coords, values);
+    KDTreeStateSpace incremental(3, 32);
+    for (size_t i = 0; i < coords.size(); i++) incremental.insert(coords[i], values[i]);
+
+    EXPECT_EQ(incremental.size(), bulk.size());
+    EXPECT_LE(bulk.depth(), (int)std::ceil(std::log2(2000.0 / std::log2(32.0 * 32 * 32))) + 2);
+    EXPECT_DOUBLE_EQ(-7.0, bulk.get(coords[7]));
+    EXPECT_DOUBLE_EQ(-2.0, bulk.get({40, 1, 1}));
+    for (size_t i = 0; i < coords.size(); i++) EXPECT_DOUBLE_EQ(incremental.get(coords[i]), bulk.get(coords[i]));
+
+    std::vector<KDTreeStateSpace::Neighbor> a, b;
+    for (int q = 0; q < 50; q++) {
+        Coordinates target = {coord(rng), coord(rng), coord(rng)};
+        bulk.nearest_k_neighbors(target, 8, a);
+        incremental.nearest_k_neighbors(target, 8, b);
+        ASSERT_EQ(a.size(), b.size());
+        for (size_t i = 0; i < a.size(); i++) EXPECT_DOUBLE_EQ(a[i].squaredDistance, b[i].squaredDistance);
+    }
+
+    // inserting after a bulk load keeps working
+    bulk.insert({0, 0, 0}, 123.0);
+    EXPECT_DOUBLE_EQ(123.0, bulk.get({0, 0, 0}));
+
+    EXPECT_THROW(KDTreeStateSpace(2, 4, {{1, 1}}, {}), std::invalid_argument);
+    EXPECT_THROW(KDTreeStateSpace(2, 4, {{1, 1}, {1}}, {1.0, 2.0}), std::invalid_argument);
+}
+
 TEST(TestKDTreeStateSpace, TestBucketInsertionAndNoSplitUnderThreshold) {
     // For 2D, dimensionSize=4 => totalPoints=16 => log2(16)=4
     // So bucketSizeThreshold = 4
@@ -232,7 +714,7 @@ TEST(TestKDTreeStateSpace, TestBucketValueUpdateWorks) {
     int count22 = 0;
     double val22 = 0.0;
     for (auto* n : root->bucket) {
-        if (n->coords == std::vector<int>({2, 2})) {
+        if (n->coords == Coordinates({2, 2})) {
             val22 = n->value;
             ++count22;
         }
@@ -273,3 +755,64 @@ TEST(TestKDTreeStateSpace, TestBucketSplitPreservesAllValues) {
     EXPECT_DOUBLE_EQ(tree.get({3, 3}), 4.0);
     EXPECT_DOUBLE_EQ(tree.get({0, 3}), 5.0);
 }
+
+
+// FlatKDTreeStateSpace tests
+
+TEST(TestFlatKDTreeStateSpace, TestInsertFindAndGet) {
+    FlatKDTreeStateSpace tree(2, 5);
+    EXPECT_EQ(std::max(2, (int)std::log2(25.0)), tree.bucket_size());
+
+    EXPECT_FALSE(tree.find({2, 3}).has_value());
+    EXPECT_FALSE(tree.nearest_neighbor({2, 3}).has_value());
+    EXPECT_DOUBLE_EQ(0.0, tree.get({2, 3}));
+
+    tree.insert({2, 3}, 1.5);
+    tree.insert({2, 3}, -4.0);
+    EXPECT_EQ(1, tree.size());
+    EXPECT_EQ(std::optional<double>(-4.0), tree.find({2, 3}));
+
+    // points outside the grid are found through the tree
+    tree.insert({7, -1}, 8.0);
+    EXPECT_EQ(std::optional<double>(8.0), tree.find({7, -1}));
+    EXPECT_FALSE(tree.find({7, 0}).has_value());
+
+    // no exceptions from lookups, only from the StateSpace interface
+    EXPECT_FALSE(tree.find({1, 2, 3}).has_value());
+    EXPECT_FALSE(tree.nearest_neighbor({1}).has_value());
+    EXPECT_THROW(tree.get({1, 2, 3}), std::invalid_argument);
+    EXPECT_THROW(tree.insert({1}, 0.0), std::invalid_argument);
+}
+
+// nearest neighbours match a brute force scan, through many bucket splits
+TEST(TestFlatKDTreeStateSpace, TestNearestMatchesBruteForce) {
+    for (int dims : {1, 2, 3, 5}) {
+        FlatKDTreeStateSpace tree(dims, 40, 3);
+        std::mt19937 rng(dims);
+        std::uniform_int_distribution<int> coord(0, 39);
+
+        std::vector<Coordinates> points;
+        for (int i = 0; i < 400; i++) {
+            Coordinates p(dims);
+            for (int d = 0; d < dims; d++) p[d] = dims == 1 ? coord(rng) : coord(rng) / 4; // many ties
+            if (!tree.find(p)) points.push_back(p);
+            tree.insert(p, i);
+        }
+        ASSERT_EQ((int)points.size(), tree.size());
+        for (int i = 0; i < tree.size(); i++) EXPECT_EQ(tree.find(tree.coords_of(i)), tree.value_of(i));
+
+        for (int q = 0; q < 200; q++) {
+            Coordinates target(dims);
+            for (int d = 0; d < dims; d++) target[d] = coord(rng) - 5;
+            double best = std::numeric_limits<double>::infinity();
+            for (const Coordinates& p : points) {
+                double dist = 0;
+                for (int d = 0; d < dims; d++) dist += (double)(p[d] - target[d]) * (p[d] - target[d]);
+                best = std::min(best, dist);
+            }
+            auto nn = tree.nearest_neighbor(target);
+            ASSERT_TRUE(nn.has_value());
+            EXPECT_DOUBLE_EQ(best, nn->squaredDistance);
+        }
+    }
+}